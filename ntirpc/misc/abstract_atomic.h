@@ -78,6 +78,7 @@
 
 #ifndef _ABSTRACT_ATOMIC_H
 #define _ABSTRACT_ATOMIC_H
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <time.h>
@@ -242,6 +243,30 @@ static inline int32_t atomic_inc_int32_t(int32_t *var)
 	return atomic_add_int32_t(var, 1);
 }
 
+/**
+ * @brief Atomically increment an int32_t, unless it is zero
+ *
+ * This function atomically adds 1 to the supplied value, unless the
+ * value is zero (for example, a reference count already released).
+ *
+ * @param[in,out] var Pointer to the variable to modify
+ *
+ * @return The value after increment, or 0 if not incremented.
+ */
+
+static inline int32_t atomic_inc_unless_zero_int32_t(int32_t *var)
+{
+	int32_t cur = __atomic_load_n(var, __ATOMIC_SEQ_CST);
+
+	do {
+		if (!cur)
+			return 0;
+	} while (!__atomic_compare_exchange_n(var, &cur, cur + 1, 0,
+					      __ATOMIC_SEQ_CST,
+					      __ATOMIC_SEQ_CST));
+	return cur + 1;
+}
+
 /**
  * @brief Atomically subtract from an int32_t
  *
@@ -1646,6 +1671,61 @@ static inline void atomic_store_voidptr(void **var, void *val)
 	__atomic_store_n(var, val, __ATOMIC_SEQ_CST);
 }
 
+/**
+ * @brief Atomically exchange a void *
+ *
+ * This function atomically stores the supplied value, returning the
+ * value it replaced.
+ *
+ * @param[in,out] var Pointer to the variable to modify
+ * @param[in]     val The value to store
+ *
+ * @return the previous value pointed to by var.
+ */
+
+static inline void *atomic_exchange_voidptr(void **var, void *val)
+{
+	return __atomic_exchange_n(var, val, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically exchange a uint32_t
+ *
+ * This function atomically stores the supplied value, returning the
+ * value it replaced.
+ *
+ * @param[in,out] var Pointer to the variable to modify
+ * @param[in]     val The value to store
+ *
+ * @return the previous value pointed to by var.
+ */
+
+static inline uint32_t atomic_exchange_uint32_t(uint32_t *var, uint32_t val)
+{
+	return __atomic_exchange_n(var, val, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically compare and exchange a uint32_t
+ *
+ * This function atomically stores the supplied value, only when the
+ * variable holds the expected value.
+ *
+ * @param[in,out] var Pointer to the variable to modify
+ * @param[in]     old The expected value
+ * @param[in]     val The value to store
+ *
+ * @return true if stored.
+ */
+
+static inline bool atomic_cmpxchg_uint32_t(uint32_t *var, uint32_t old,
+					   uint32_t val)
+{
+	return __atomic_compare_exchange_n(var, &old, val, 0,
+					   __ATOMIC_SEQ_CST,
+					   __ATOMIC_SEQ_CST);
+}
+
 /**
  * @brief Atomically fetch an int64_t
  *
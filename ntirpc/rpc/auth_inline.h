@@ -119,12 +119,12 @@ xdr_opaque_auth_decode_it(XDR *xdrs, struct opaque_auth *oa)
 }
 
 /*
- * decode an auth message
+ * decode an auth message flavor and length
  *
  * param[IN]	buf	2 more inline
  */
 static inline bool
-xdr_opaque_auth_decode(XDR *xdrs, struct opaque_auth *oa, int32_t *buf)
+xdr_opaque_auth_decode_hdr(XDR *xdrs, struct opaque_auth *oa, int32_t *buf)
 {
 	if (buf != NULL) {
 		oa->oa_flavor = IXDR_GET_ENUM(buf, enum_t);
@@ -140,6 +140,19 @@ xdr_opaque_auth_decode(XDR *xdrs, struct opaque_auth *oa, int32_t *buf)
 			__func__, __LINE__);
 		return (false);
 	}
+	return (true);
+}
+
+/*
+ * decode an auth message
+ *
+ * param[IN]	buf	2 more inline
+ */
+static inline bool
+xdr_opaque_auth_decode(XDR *xdrs, struct opaque_auth *oa, int32_t *buf)
+{
+	if (!xdr_opaque_auth_decode_hdr(xdrs, oa, buf))
+		return (false);
 
 	if (oa->oa_length) {
 		/* only call and alloc for > 0 length */
@@ -148,6 +161,37 @@ xdr_opaque_auth_decode(XDR *xdrs, struct opaque_auth *oa, int32_t *buf)
 	return (true);	/* 0 length succeeds */
 }
 
+/*
+ * decode an auth message, setting *body to its contents:  on a stream
+ * marked XDR_FLAG_BORROW, a body within one buffer is left there (and
+ * oa_body is not filled); otherwise, it is copied to oa_body.
+ *
+ * param[IN]	buf	2 more inline
+ */
+static inline bool
+xdr_opaque_auth_decode_ref(XDR *xdrs, struct opaque_auth *oa, char **body,
+			   int32_t *buf)
+{
+	uint8_t *future;
+
+	if (!xdr_opaque_auth_decode_hdr(xdrs, oa, buf))
+		return (false);
+
+	*body = oa->oa_body;
+	if (!oa->oa_length)
+		return (true);	/* 0 length succeeds */
+
+	future = xdrs->x_data + RNDUP(oa->oa_length);
+	if ((xdrs->x_flags & XDR_FLAG_BORROW)
+	 && oa->oa_length <= MAX_AUTH_BYTES
+	 && future <= xdrs->x_v.vio_tail) {
+		*body = (char *)xdrs->x_data;
+		xdrs->x_data = future;
+		return (true);
+	}
+	return xdr_opaque_auth_decode_it(xdrs, oa);
+}
+
 /*
  * XDR an auth message
  */
@@ -105,6 +105,12 @@ typedef struct rpc_client {
 
 		/* the ioctl() of rpc */
 		 bool(*cl_control) (struct rpc_client *, u_int, void *);
+
+		/* client to carry a call (multi-connection), ref+1 */
+		struct rpc_client *(*cl_select) (struct rpc_client *);
+
+		/* send several calls on this client (optional) */
+		enum clnt_stat (*cl_call_batch) (struct clnt_req **, int);
 	} *cl_ops;
 
 	char *cl_netid;		/* network token */
@@ -123,6 +129,16 @@ typedef struct rpc_client {
 #define CLNT_REQ_FLAG_EXPIRING	0x0001
 #define CLNT_REQ_FLAG_BACKSYNC	0x0004
 #define CLNT_REQ_FLAG_ACKSYNC	0x0008
+#define CLNT_REQ_FLAG_RETRANS	0x0010	/* sent more than once (Karn) */
+#define CLNT_REQ_FLAG_RESENDING	0x0020	/* retransmit task pending */
+#define CLNT_REQ_FLAG_CREDIT	0x0040	/* holds flow control credit */
+
+struct clnt_cq;
+
+/* link on a completion queue (clnt_cq) */
+struct clnt_cq_entry {
+	struct clnt_cq_entry *cqe_next;
+};
 
 /*
  * RPC context.  Intended to enable efficient multiplexing of calls
@@ -150,6 +166,49 @@ struct clnt_req {
 	uint32_t cc_xid;
 	int32_t cc_refcnt;
 	uint16_t cc_flags;
+
+	/* New with libntirpc 7.0 */
+	struct clnt_cq_entry cc_cqe;	/* also links a staged call */
+	struct clnt_cq *cc_cq;	/* completes to, by clnt_cq_complete() */
+	struct xdr_arena *cc_arena;	/* results, to clnt_req_release() */
+	void *cc_expires;	/* channel of call_expires, while EXPIRING */
+	struct timespec cc_sent;	/* last transmission (monotonic) */
+	int cc_deadline_ms;	/* retransmit until (monotonic), or 0 */
+	uint32_t cc_done;	/* sync completion (futex word) */
+	uint32_t cc_bytes;	/* charged to the flow control window */
+};
+
+/*
+ * Flow control window of a CLIENT (CLSET_WINDOW, CLGET_WINDOW); of each
+ * connection of a multi-connection CLIENT.  A call takes its credit when
+ * first sent, and returns it in clnt_req_reset() (or the final
+ * clnt_req_release()).  Zero limits are unlimited.
+ *
+ * With CLNT_WINDOW_FLAG_ADAPT, the call limit (cw_cwnd) moves between 1
+ * and cw_calls: +1 per window of replies within the latency target, and
+ * halved on a later reply or a timeout (AIMD).  cw_target_us 0 targets
+ * four times the least latency seen, and at least a millisecond.
+ */
+#define CLNT_WINDOW_BLOCK	0	/* wait, up to cc_timeout */
+#define CLNT_WINDOW_FAIL	1	/* RPC_SYSTEMERROR, EAGAIN */
+#define CLNT_WINDOW_QUEUE	2	/* stage CLNT_CALL_BACK(), up to cw_stage */
+
+#define CLNT_WINDOW_FLAG_NONE	0x0000
+#define CLNT_WINDOW_FLAG_ADAPT	0x0001
+
+struct clnt_window {
+	uint32_t cw_calls;	/* calls in flight */
+	uint32_t cw_bytes;	/* call bytes in flight */
+	uint32_t cw_stage;	/* staged calls (CLNT_WINDOW_QUEUE) */
+	uint32_t cw_target_us;	/* reply latency (CLNT_WINDOW_FLAG_ADAPT) */
+	uint16_t cw_mode;
+	uint16_t cw_flags;
+	/* CLGET_WINDOW only */
+	uint32_t cw_cwnd;
+	uint32_t cw_inflight;
+	uint32_t cw_inflight_bytes;
+	uint32_t cw_staged;
+	uint64_t cw_stalls;	/* calls finding the window full */
 };
 
 /*
@@ -161,6 +220,23 @@ struct rpc_timers {
 	u_long rt_rtxcur;	/* current (backed-off) rto */
 };
 
+/*
+ * Round trip estimates of a datagram client (CLGET_RTT_STATS).
+ * rs_hist[i] counts samples under 2^i microseconds (and not under
+ * 2^(i-1)); the last bucket also counts all longer samples.
+ */
+#define CLNT_RTT_HIST_MAX 24
+
+struct clnt_rtt_stats {
+	uint32_t rs_srtt_us;	/* smoothed round-trip time */
+	uint32_t rs_rttvar_us;	/* round-trip time variation */
+	uint32_t rs_rto_us;	/* retransmit timeout, before backoff */
+	uint32_t rs_backoff;	/* current exponential backoff shift */
+	uint64_t rs_samples;
+	uint64_t rs_retrans;
+	uint64_t rs_hist[CLNT_RTT_HIST_MAX];
+};
+
 /*
  * Feedback values used for possible congestion and rate control
  */
@@ -182,6 +258,7 @@ struct rpc_timers {
 #define CLNT_FLAG_DESTROYING		SVC_XPRT_FLAG_DESTROYING
 #define CLNT_FLAG_RELEASING		SVC_XPRT_FLAG_RELEASING
 #define CLNT_FLAG_DESTROYED		SVC_XPRT_FLAG_DESTROYED
+#define CLNT_FLAG_CACHED		0x4000 /* held by the client cache */
 #define CLNT_FLAG_LOCAL			0x8000 /* Client is unshared/local */
 
 /*
@@ -268,6 +345,9 @@ struct rpc_timers {
 #define CLSET_SVC_ADDR  16	/* get server's address (netbuf) */
 #define CLSET_PUSH_TIMOD 17	/* push timod if not already present */
 #define CLSET_POP_TIMOD  18	/* pop timod */
+#define CLGET_RTT_STATS 19	/* round trip estimates (clnt_rtt_stats) */
+#define CLSET_WINDOW    20	/* flow control (clnt_window) */
+#define CLGET_WINDOW    21
 
 /* Protect a CLIENT with a CLNT_REF for each call or request.
  */
@@ -480,6 +560,7 @@ extern CLIENT *clnt_tli_ncreate(const int, const struct netconfig *,
 
 /* uint32_t instructions */
 #define CLNT_CREATE_FLAG_CONNECT	0x10000000
+#define CLNT_CREATE_FLAG_ROUND_ROBIN	0x04000000
 #define CLNT_CREATE_FLAG_LISTEN		SVC_CREATE_FLAG_LISTEN
 #define CLNT_CREATE_FLAG_SVCXPRT	0x40000000
 #define CLNT_CREATE_FLAG_XPRT_DOREG	SVC_CREATE_FLAG_XPRT_DOREG
@@ -510,6 +591,25 @@ extern CLIENT *clnt_vc_ncreate_svc(const SVCXPRT *, const rpcprog_t,
  *      const uint32_t flags;                   -- flags
  */
 
+/*
+ * Create one client handle over several connections to the same server
+ * (nconnect).  Each call goes to the connection with the fewest calls
+ * outstanding, or to each in turn with CLNT_CREATE_FLAG_ROUND_ROBIN.
+ * Broken connections are replaced in the background.
+ */
+extern CLIENT *clnt_vc_ncreate_multi(const struct netbuf *, const rpcprog_t,
+				     const rpcvers_t, const u_int, const u_int,
+				     const u_int, const uint32_t);
+/*
+ *      const struct netbuf *raddr;             -- servers address
+ *      const rpcprog_t prog;                   -- program number
+ *      const rpcvers_t vers;                   -- version number
+ *      const u_int sendsz;                     -- buffer send size
+ *      const u_int recvsz;                     -- buffer recv size
+ *      const u_int nconn;                      -- number of connections
+ *      const uint32_t flags;                   -- flags
+ */
+
 /*
  * Low level clnt create routine for connectionless transports, e.g. udp.
  */
@@ -567,21 +667,20 @@ static inline void clnt_req_fill(struct clnt_req *cc, struct rpc_client *clnt,
 	cc->cc_reply.proc = xresults;
 	cc->cc_reply.where = resultsp;
 	cc->cc_verf = _null_auth;
+	cc->cc_arena = NULL;
 
 	cc->cc_free_cb = (clnt_req_freer)__ntirpc_pkg_params.free_size_;
 	cc->cc_size = sizeof(*cc);
 	cc->cc_refcnt = 1;
 
-	/* protects this */
+	/* waits without futex(2) */
 	pthread_mutex_init(&cc->cc_we.mtx, NULL);
-	pthread_mutex_lock(&cc->cc_we.mtx);
 	pthread_cond_init(&cc->cc_we.cv, 0);
 }
 
 static inline void clnt_req_fini(struct clnt_req *cc)
 {
 	pthread_cond_destroy(&cc->cc_we.cv);
-	pthread_mutex_unlock(&cc->cc_we.mtx);
 	pthread_mutex_destroy(&cc->cc_we.mtx);
 }
 
@@ -589,9 +688,55 @@ enum clnt_stat clnt_req_callback(struct clnt_req *);
 enum clnt_stat clnt_req_refresh(struct clnt_req *);
 void clnt_req_reset(struct clnt_req *);
 enum clnt_stat clnt_req_setup(struct clnt_req *, struct timespec);
+enum clnt_stat clnt_req_submit_batch(struct clnt_req **, int);
+
+/*
+ * Completion queue.  Calls completing to a queue are collected in
+ * batches by clnt_cq_poll(), instead of signalling a waiter or running
+ * a callback on the receiving thread.  With CLNT_CQ_FLAG_EVENTFD,
+ * clnt_cq_fd() becomes readable when completions are waiting, for use
+ * in another event loop.
+ *
+ * clnt_cq_attach() after clnt_req_setup(), then CLNT_CALL_BACK() or
+ * clnt_req_submit_batch().  Each polled call carries the reference of
+ * its caller, to clnt_req_release().
+ */
+#define CLNT_CQ_FLAG_NONE	0x0000
+#define CLNT_CQ_FLAG_EVENTFD	0x0001
+
+struct clnt_cq *clnt_cq_create(uint32_t);
+void clnt_cq_destroy(struct clnt_cq *);
+int clnt_cq_fd(struct clnt_cq *);
+void clnt_cq_attach(struct clnt_req *, struct clnt_cq *);
+void clnt_cq_complete(struct clnt_req *);
+int clnt_cq_poll(struct clnt_cq *, struct clnt_req **, int, int);
+/*
+ *      struct clnt_cq *cq;                     -- completion queue
+ *      struct clnt_req **ccv;                  -- completed calls (out)
+ *      int n;                                  -- at most
+ *      int timeout_ms;                         -- 0 poll, -1 forever
+ */
 enum clnt_stat clnt_req_wait_reply(struct clnt_req *);
 int clnt_req_release(struct clnt_req *);
 
+/*
+ * Shared client cache.  clnt_cache_ncreate_timed() returns the handle
+ * for (host, program, version, nettype) shared by every caller, making
+ * it (as clnt_ncreate_timed()) only when missing.  Each handle returned
+ * is given back with clnt_cache_release(), and must not be destroyed, or
+ * its program, version or address changed.
+ *
+ * Idle handles are evicted after a time, or the least recently used when
+ * over the cache size (RPC_SVC_CLNT_CACHE_SET).  A handle found with its
+ * connection lost is replaced by a new connection, made in background
+ * (on svc_work_pool, so svc_init() is required).
+ */
+CLIENT *clnt_cache_ncreate_timed(const char *, const rpcprog_t,
+				 const rpcvers_t, const char *,
+				 const struct timeval *);
+void clnt_cache_release(CLIENT *);
+void clnt_cache_flush(void);
+
 __END_DECLS
 /*
  * Used by rpc_perror() and rpc_sperror()
@@ -115,6 +115,7 @@ enum xprt_stat {
 #define SVCSET_XP_FREE_USER_DATA        16
 #define SVCGET_XP_UNREF_USER_DATA        17
 #define SVCSET_XP_UNREF_USER_DATA        18
+#define SVCGET_XP_MEM_STAT      19	/* struct rpc_xprt_mem_stat */
 
 /*
  * Operations for rpc_control().
@@ -125,6 +126,75 @@ enum xprt_stat {
 #define RPC_SVC_XPRTS_SET       3
 #define RPC_SVC_FDSET_GET       4
 #define RPC_SVC_FDSET_SET       5
+#define RPC_SVC_IOQ_POOL_GET    6	/* struct rpc_ioq_pool_stat */
+#define RPC_SVC_IOQ_POOL_SET    7	/* high_wat and low_wat only */
+#define RPC_SVC_IOQ_TRIM        8	/* memory pressure, arg ignored */
+#define RPC_SVC_MEM_BUDGET_GET  9	/* struct rpc_mem_budget */
+#define RPC_SVC_MEM_BUDGET_SET  10	/* limits only */
+#define RPC_SVC_DG_BATCH_SET    11	/* datagrams per wakeup (1..64) */
+#define RPC_SVC_DG_BATCH_GET    12
+#define RPC_SVC_DG_OFFLOAD_SET  13	/* RPC_DG_OFFLOAD_* for new sockets */
+#define RPC_SVC_DG_OFFLOAD_GET  14
+#define RPC_SVC_CLNT_SPIN_SET   15	/* sync reply polls before sleeping */
+#define RPC_SVC_CLNT_SPIN_GET   16
+#define RPC_SVC_CLNT_CACHE_GET  17	/* struct rpc_clnt_cache */
+#define RPC_SVC_CLNT_CACHE_SET  18	/* limits only */
+#define RPC_SVC_XDR_ARENA_SET   19	/* request decode arena bytes, or 0 */
+#define RPC_SVC_XDR_ARENA_GET   20
+#define RPC_SVC_XDR_SIZING_SET  21	/* size replies before encoding (int) */
+#define RPC_SVC_XDR_SIZING_GET  22
+
+/* RPC_SVC_DG_OFFLOAD_SET (int) */
+#define RPC_DG_OFFLOAD_GRO      0x0001	/* UDP_GRO receive */
+#define RPC_DG_OFFLOAD_GSO      0x0002	/* UDP_SEGMENT batched replies */
+
+/*
+ * Socket transport buffer pool (rpc_control).
+ */
+struct rpc_ioq_pool_stat {
+	size_t high_wat;	/* bytes pooled; 0: pool disabled */
+	size_t low_wat;		/* bytes kept when shrinking */
+	size_t total;		/* bytes pooled in chunks */
+	size_t in_use;		/* bytes in outstanding buffers */
+	uint64_t chunks_alloc;
+	uint64_t chunks_freed;
+	uint64_t overflow;	/* buffers allocated outside the pool */
+};
+
+/*
+ * Memory budgets for received requests and queued replies (rpc_control).
+ * When over budget, the transport stops receiving until it drains.
+ */
+struct rpc_mem_budget {
+	size_t xprt_recv;	/* per transport limits, 0: unlimited */
+	size_t xprt_send;
+	size_t total_recv;	/* global limits, 0: unlimited */
+	size_t total_send;
+	size_t recv_pending;	/* global bytes charged */
+	size_t send_pending;
+	uint64_t throttled;	/* times receive was stopped */
+	uint64_t resumed;	/* times receive was restarted */
+};
+
+/*
+ * Shared client cache, clnt_cache_ncreate_timed() (rpc_control).
+ */
+struct rpc_clnt_cache {
+	u_int max_clients;	/* idle handles evicted when over */
+	u_int idle_sec;		/* idle handles evicted after, 0: never */
+	u_int clients;
+	uint64_t hits;
+	uint64_t misses;	/* new handles */
+	uint64_t evictions;
+	uint64_t reconnects;
+};
+
+/* SVCGET_XP_MEM_STAT */
+struct rpc_xprt_mem_stat {
+	size_t recv_pending;	/* bytes in requests not yet released */
+	size_t send_pending;	/* bytes in replies not yet sent */
+	uint32_t throttled;	/* times receive was stopped */
+};
 
 typedef enum xprt_stat (*svc_xprt_fun_t) (SVCXPRT *);
 typedef void (*svc_xprt_void_fun_t) (SVCXPRT *);
@@ -178,6 +248,7 @@ typedef struct svc_init_params {
 #define SVC_XPRT_FLAG_UREG		0x0080
 #define SVC_XPRT_TREE_LOCKED		0x0100
 #define SVC_XPRT_FLAG_REMOTE_ADDR_SET	0x0200	/* remote addr was final set */
+#define SVC_XPRT_FLAG_RECV_THROTTLED	0x0400	/* over memory budget */
 
 #define SVC_XPRT_FLAG_DESTROYED (SVC_XPRT_FLAG_DESTROYING \
 				| SVC_XPRT_FLAG_RELEASING)
@@ -392,6 +463,15 @@ struct svc_req {
 	struct blkin_trace bl_trace;
 #endif
 	uint32_t rq_refcnt;
+
+	/* New with libntirpc 7.0 */
+
+	/* decoded arguments, with RPC_SVC_XDR_ARENA_SET; not to XDR_FREE */
+	struct xdr_arena *rq_arena;
+
+	/* rq_msg.cb_cred contents: its oa_body, or borrowed from the
+	 * request buffers (XDR_FLAG_BORROW), valid until the free_cb */
+	char *rq_cred_ref;
 };
 
 /*
@@ -561,8 +641,9 @@ static inline void svc_destroy_it(SVCXPRT *xprt,
 	}
 
 	/* Let's shutdown the sockets so that FIN-ACK could be sent to the
-	 * client immediately. */
-	if (xprt->xp_fd != RPC_ANYFD) {
+	 * client immediately.  Per-datagram UDP transports share the fd of
+	 * their rendezvous, so leave that alone. */
+	if (xprt->xp_fd != RPC_ANYFD && xprt->xp_type != XPRT_UDP) {
 		(void)shutdown(xprt->xp_fd, SHUT_RDWR);
 		if (xprt->xp_fd_send != RPC_ANYFD)
 			(void)shutdown(xprt->xp_fd_send, SHUT_RDWR);
@@ -774,6 +855,20 @@ svc_dg_ncreate(const int fd, const u_int sendsize, const u_int recvsize)
 	return (svc_dg_ncreatef(fd, sendsize, recvsize, SVC_CREATE_FLAG_CLOSE));
 }
 
+extern int svc_dg_ncreate_reuseport(const struct sockaddr *, const socklen_t,
+				    const u_int, const u_int, const uint32_t,
+				    const u_int, svc_xprt_fun_t, SVCXPRT **);
+/*
+ *      const struct sockaddr *addr;            -- local address to bind
+ *      const socklen_t addrlen;                -- its length
+ *      const u_int sendsize;                   -- max send size
+ *      const u_int recvsize;                   -- max recv size
+ *      const uint32_t flags;                   -- flags
+ *      const u_int count;                      -- sockets to open
+ *      svc_xprt_fun_t rendezvous_cb;           -- set on each transport
+ *      SVCXPRT **xprts;                        -- OUT: count transports
+ */
+
 /*
  * the routine takes any *open* connection
  */
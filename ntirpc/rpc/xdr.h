@@ -173,6 +173,8 @@ typedef struct xdr_uio {
 #define XDR_FLAG_CKSUM		0x0001
 #define XDR_FLAG_FREE		0x0002
 #define XDR_FLAG_VIO		0x0004
+#define XDR_FLAG_BORROW		0x0008	/* buffers outlive the decode */
+#define XDR_FLAG_ARENA		0x0010	/* x_arena is set */
 
 /*
  * The XDR handle.
@@ -223,6 +225,7 @@ typedef struct rpc_xdr {
 	u_int x_handy; /* extra private word */
 	u_int x_flags; /* shared flags */
 	enum xdr_op x_op;  /* operation; fast additional param */
+	struct xdr_arena *x_arena; /* decode allocations, with XDR_FLAG_ARENA */
 } XDR;
 
 #define XDR_VIO(x) ((xdr_vio *)((x)->x_base))
@@ -671,6 +674,12 @@ extern bool xdr_wrapstring(XDR *, char **);
 extern bool xdr_longlong_t(XDR *, quad_t *);
 extern bool xdr_u_longlong_t(XDR *, u_quad_t *);
 
+/* bulk conversion of XDR integers, see xdr_swap.c */
+extern void xdr_swap32(uint32_t *, const uint32_t *, u_int);
+extern void xdr_swap64(uint64_t *, const uint64_t *, u_int);
+extern bool xdr_uint32_vector(XDR *, uint32_t *, u_int);
+extern bool xdr_uint64_vector(XDR *, uint64_t *, u_int);
+
 __END_DECLS
 
 /*
@@ -695,6 +704,81 @@ struct netobj {
 typedef struct netobj netobj;
 extern bool xdr_nnetobj(XDR *, struct netobj *);
 
+/*
+ * Bulk opaque<> data (e.g., WRITE or READ payloads).  Encoded from the
+ * caller's xb_uio segments without copying, or decoded directly into the
+ * caller's buffer at xb_base; see xdr_bulk().
+ */
+struct xdr_bulk {
+	xdr_uio *xb_uio;	/* encode: segments to send, or NULL */
+	char *xb_base;		/* decode: destination (encode: if no xb_uio) */
+	u_int xb_size;		/* decode: room at xb_base */
+	u_int xb_len;		/* length of data */
+};
+extern bool xdr_bulk(XDR *, struct xdr_bulk *);
+
+/*
+ * A stream that copies XDR_PUTBUFS (or xdr_bulk()) data, rather than
+ * keeping segment references, holds the uio only while copying.  That
+ * reference is also dropped through uio_release(), so the caller learns
+ * that its memory is free the same way on every stream.
+ */
+static inline void
+xdr_uio_copied(xdr_uio *uio)
+{
+	if (!uio->uio_release)
+		return;
+	(uio->uio_references)++;
+	uio->uio_release(uio, UIO_FLAG_NONE);
+}
+
+/*
+ * Borrowed opaque data: decoded as a reference into the stream buffer
+ * (XDR_FLAG_BORROW), rather than copied; see xdr_opaque_ref().  A
+ * borrowed string is not NUL terminated.
+ */
+#define XDR_REF_ALLOC		0x0001	/* copied to xr_base, to be freed */
+
+struct xdr_ref {
+	char *xr_base;
+	u_int xr_len;
+	u_int xr_flags;
+};
+extern bool xdr_opaque_ref(XDR *, struct xdr_ref *, u_int);
+extern bool xdr_bytes_ref(XDR *, struct xdr_ref *, u_int);
+
+/*
+ * Decode arena: while a stream has XDR_FLAG_ARENA, objects decoded by
+ * the xdr primitives (strings, bytes, arrays, references) are carved
+ * from its x_arena rather than allocated each, and all are released at
+ * once by xdr_arena_destroy().  Such objects must not be passed to
+ * XDR_FREE.  Streams without the flag never read x_arena.
+ */
+#define XDR_ARENA_ALIGN		16
+
+struct xdr_arena {
+	uint8_t *xa_next;	/* free space of the current chunk */
+	uint8_t *xa_end;
+	void *xa_chunks;	/* further chunks */
+	size_t xa_size;		/* bytes per chunk */
+};
+
+extern struct xdr_arena *xdr_arena_create(size_t);
+extern void *xdr_arena_grow(struct xdr_arena *, size_t);
+extern void xdr_arena_destroy(struct xdr_arena *);
+
+static inline void *
+xdr_arena_alloc(struct xdr_arena *xa, size_t size)
+{
+	uint8_t *p = xa->xa_next;
+
+	size = (size + XDR_ARENA_ALIGN - 1) & ~((size_t)XDR_ARENA_ALIGN - 1);
+	if (unlikely(size > (size_t)(xa->xa_end - p)))
+		return (xdr_arena_grow(xa, size));
+	xa->xa_next = p + size;
+	return (p);
+}
+
 /*
  * These are the public routines for the various implementations of
  * xdr streams.
@@ -706,6 +790,24 @@ extern void xdrmem_ncreate(XDR *, char *, u_int, enum xdr_op);
 /* intrinsic checksum (be careful) */
 extern uint64_t xdrmem_cksum(XDR *, u_int);
 
+/* XDR sizing an encode, storing nothing */
+extern void xdrsize_create(XDR *);
+extern u_long xdr_sizeof(xdrproc_t, void *);
+
+/* bytes encoded, including those by reference */
+static inline u_int
+xdrsize_length(XDR *xdrs)
+{
+	return (xdrs->x_v.vio_length);
+}
+
+/* bytes passed by reference (XDR_PUTBUFS) */
+static inline u_int
+xdrsize_refer(XDR *xdrs)
+{
+	return ((uintptr_t)xdrs->x_private);
+}
+
 __END_DECLS
 /* For backward compatibility */
 #include <rpc/tirpc_compat.h>
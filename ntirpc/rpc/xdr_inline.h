@@ -52,6 +52,118 @@
 #include <rpc/types.h>
 #include <rpc/xdr.h>
 
+/*
+ * Decode allocations, from the stream's arena when it has one.  Arena
+ * memory is not freed on a decode error; it goes with the arena.
+ */
+static inline void *
+xdr_alloc(XDR *xdrs, size_t size)
+{
+	if (xdrs->x_flags & XDR_FLAG_ARENA)
+		return (xdr_arena_alloc(xdrs->x_arena, size));
+	return (mem_alloc(size));
+}
+
+static inline void *
+xdr_zalloc(XDR *xdrs, size_t size)
+{
+	if (xdrs->x_flags & XDR_FLAG_ARENA)
+		return (memset(xdr_arena_alloc(xdrs->x_arena, size), 0, size));
+	return (mem_zalloc(size));
+}
+
+static inline void
+xdr_unalloc(XDR *xdrs, void *p, size_t size)
+{
+	if (!(xdrs->x_flags & XDR_FLAG_ARENA))
+		mem_free(p, size);
+}
+
+/*
+ * Direct stream access
+ *
+ * The buffered streams (xdr_ioq, xdrmem) keep their current buffer in
+ * x_data and x_v, so anything that fits in it can be coded in line;
+ * only the buffer boundary needs a call through x_ops.  The 32-bit
+ * routines of xdr.h have always worked this way.
+ *
+ * A codec that defines XDR_DIRECT before its first rpc include also has
+ * its hypers, opaques, counted bytes, and strings coded this way.  The
+ * choice is per translation unit, as these are all static inline.
+ */
+static inline bool
+xdr_getbytes_direct(XDR *xdrs, char *addr, u_int len)
+{
+	uint8_t *future = xdrs->x_data + len;
+
+	if (future <= xdrs->x_v.vio_tail) {
+		memcpy(addr, xdrs->x_data, len);
+		xdrs->x_data = future;
+		return (true);
+	}
+	return (XDR_GETBYTES(xdrs, addr, len));
+}
+
+static inline bool
+xdr_putbytes_direct(XDR *xdrs, const char *addr, u_int len)
+{
+	uint8_t *future = xdrs->x_data + len;
+
+	if (future <= xdrs->x_v.vio_wrap) {
+		memcpy(xdrs->x_data, addr, len);
+		xdrs->x_data = future;
+		return (true);
+	}
+	return (XDR_PUTBYTES(xdrs, addr, len));
+}
+
+static inline bool
+xdr_getuint64_direct(XDR *xdrs, uint64_t *up)
+{
+	uint8_t *future = xdrs->x_data + 2 * BYTES_PER_XDR_UNIT;
+	uint32_t u[2];
+
+	if (future <= xdrs->x_v.vio_tail) {
+		memcpy(u, xdrs->x_data, sizeof(u));
+		xdrs->x_data = future;
+		*up = ((uint64_t) ntohl(u[0]) << 32) | ((uint64_t) ntohl(u[1]));
+		return (true);
+	}
+	if (!XDR_GETUINT32(xdrs, &u[0])
+	 || !XDR_GETUINT32(xdrs, &u[1]))
+		return (false);
+	*up = ((uint64_t) u[0] << 32) | ((uint64_t) u[1]);
+	return (true);
+}
+
+static inline bool
+xdr_putuint64_direct(XDR *xdrs, uint64_t v)
+{
+	uint8_t *future = xdrs->x_data + 2 * BYTES_PER_XDR_UNIT;
+	uint32_t u[2];
+
+	if (future <= xdrs->x_v.vio_wrap) {
+		u[0] = htonl((uint32_t) (v >> 32));
+		u[1] = htonl((uint32_t) v);
+		memcpy(xdrs->x_data, u, sizeof(u));
+		xdrs->x_data = future;
+		return (true);
+	}
+	if (!XDR_PUTUINT32(xdrs, (uint32_t) (v >> 32)))
+		return (false);
+	return (XDR_PUTUINT32(xdrs, (uint32_t) v));
+}
+
+#ifdef XDR_DIRECT
+#define XDR_INLINE_GETBYTES(xdrs, addr, len) \
+	xdr_getbytes_direct(xdrs, addr, len)
+#define XDR_INLINE_PUTBYTES(xdrs, addr, len) \
+	xdr_putbytes_direct(xdrs, addr, len)
+#else
+#define XDR_INLINE_GETBYTES(xdrs, addr, len) XDR_GETBYTES(xdrs, addr, len)
+#define XDR_INLINE_PUTBYTES(xdrs, addr, len) XDR_PUTBYTES(xdrs, addr, len)
+#endif
+
 /*
  * XDR integers
  */
@@ -151,21 +263,31 @@ inline_xdr_u_long(XDR *xdrs, u_long *ulp)
 static inline bool
 xdr_uint64_t(XDR *xdrs, uint64_t *uint64_p)
 {
+#ifndef XDR_DIRECT
 	uint32_t u[2];
+#endif
 
 	switch (xdrs->x_op) {
 	case XDR_ENCODE:
+#ifdef XDR_DIRECT
+		return (xdr_putuint64_direct(xdrs, *uint64_p));
+#else
 		u[0] = (uint32_t) (*uint64_p >> 32) & 0xffffffff;
 		u[1] = (uint32_t) (*uint64_p) & 0xffffffff;
 		if (!XDR_PUTUINT32(xdrs, u[0]))
 			return (false);
 		return (XDR_PUTUINT32(xdrs, u[1]));
+#endif
 	case XDR_DECODE:
+#ifdef XDR_DIRECT
+		return (xdr_getuint64_direct(xdrs, uint64_p));
+#else
 		if (!XDR_GETUINT32(xdrs, &u[0])
 		 || !XDR_GETUINT32(xdrs, &u[1]))
 			return (false);
 		*uint64_p = (((uint64_t) u[0] << 32) | ((uint64_t) u[1]));
 		return (true);
+#endif
 	case XDR_FREE:
 		return (true);
 	}
@@ -433,9 +555,9 @@ xdr_opaque_decode(XDR *xdrs, char *cp, u_int cnt)
 
 	/*
 	 * XDR_INLINE is just as likely to do a function call,
-	 * so don't bother with it here.
+	 * so don't bother with it here (see XDR_DIRECT).
 	 */
-	if (!XDR_GETBYTES(xdrs, cp, cnt)) {
+	if (!XDR_INLINE_GETBYTES(xdrs, cp, cnt)) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s:%u ERROR opaque",
 			__func__, __LINE__);
@@ -450,8 +572,8 @@ xdr_opaque_decode(XDR *xdrs, char *cp, u_int cnt)
 	if (rndup > 0) {
 		uint32_t crud;
 
-		if (!XDR_GETBYTES(xdrs, (char *) &crud,
-				  BYTES_PER_XDR_UNIT - rndup)) {
+		if (!XDR_INLINE_GETBYTES(xdrs, (char *) &crud,
+					 BYTES_PER_XDR_UNIT - rndup)) {
 			__warnx(TIRPC_DEBUG_FLAG_ERROR,
 				"%s:%u ERROR crud",
 				__func__, __LINE__);
@@ -480,9 +602,9 @@ xdr_opaque_encode(XDR *xdrs, const char *cp, u_int cnt)
 
 	/*
 	 * XDR_INLINE is just as likely to do a function call,
-	 * so don't bother with it here.
+	 * so don't bother with it here (see XDR_DIRECT).
 	 */
-	if (!XDR_PUTBYTES(xdrs, cp, cnt))
+	if (!XDR_INLINE_PUTBYTES(xdrs, cp, cnt))
 		return (false);
 
 	/*
@@ -493,8 +615,8 @@ xdr_opaque_encode(XDR *xdrs, const char *cp, u_int cnt)
 	if (rndup > 0) {
 		uint32_t zero = 0;
 
-		if (!XDR_PUTBYTES(xdrs, (char *) &zero,
-				  BYTES_PER_XDR_UNIT - rndup))
+		if (!XDR_INLINE_PUTBYTES(xdrs, (char *) &zero,
+					 BYTES_PER_XDR_UNIT - rndup))
 			return (false);
 	}
 
@@ -595,13 +717,13 @@ xdr_bytes_decode(XDR *xdrs, char **cpp, u_int *sizep, u_int maxsize)
 	if (!size)
 		return (true);
 	if (!sp)
-		sp = (char *)mem_alloc(size);
+		sp = (char *)xdr_alloc(xdrs, size);
 
 	ret = xdr_opaque_decode(xdrs, sp, size);
 	if (!ret) {
 		if (!*cpp) {
 			/* Only free if we allocated */
-			mem_free(sp, size);
+			xdr_unalloc(xdrs, sp, size);
 		}
 		return (ret);
 	}
@@ -718,6 +840,41 @@ xdr_union(XDR *xdrs,
 }
 #define inline_xdr_union xdr_union
 
+/*
+ * Vectors and arrays of plain 32- and 64-bit integers are converted in
+ * bulk (xdr_uint32_vector, xdr_uint64_vector), rather than element by
+ * element.  Static inline element routines only compare equal within
+ * their translation unit, so elsewhere those fall back to the loop.
+ */
+static inline int
+xdr_elem_bulk(u_int selem, xdrproc_t xdr_elem)
+{
+	if (selem == sizeof(uint32_t)
+	 && (xdr_elem == (xdrproc_t) xdr_int
+	  || xdr_elem == (xdrproc_t) xdr_u_int
+	  || xdr_elem == (xdrproc_t) xdr_int32_t
+	  || xdr_elem == (xdrproc_t) xdr_uint32_t
+	  || xdr_elem == (xdrproc_t) xdr_u_int32_t
+	  || xdr_elem == (xdrproc_t) xdr_enum))
+		return (sizeof(uint32_t));
+	if (selem == sizeof(uint64_t)
+	 && (xdr_elem == (xdrproc_t) xdr_longlong_t
+	  || xdr_elem == (xdrproc_t) xdr_u_longlong_t
+	  || xdr_elem == (xdrproc_t) xdr_int64_t
+	  || xdr_elem == (xdrproc_t) xdr_uint64_t
+	  || xdr_elem == (xdrproc_t) xdr_u_int64_t))
+		return (sizeof(uint64_t));
+	return (0);
+}
+
+static inline bool
+xdr_elem_bulk_vector(XDR *xdrs, char *basep, u_int nelem, int bulk)
+{
+	if (bulk == sizeof(uint32_t))
+		return (xdr_uint32_vector(xdrs, (uint32_t *)basep, nelem));
+	return (xdr_uint64_vector(xdrs, (uint64_t *)basep, nelem));
+}
+
 /*
  * XDR a fixed length array. Unlike variable-length arrays,
  * the storage of fixed length arrays is static and unfreeable.
@@ -732,6 +889,10 @@ xdr_vector(XDR *xdrs, char *basep, u_int nelem, u_int selem,
 {
 	char *target = basep;
 	u_int i = 0;
+	int bulk = xdr_elem_bulk(selem, xdr_elem);
+
+	if (bulk)
+		return (xdr_elem_bulk_vector(xdrs, basep, nelem, bulk));
 
 	for (; i < nelem; i++) {
 		if (!(*xdr_elem) (xdrs, target))
@@ -759,6 +920,7 @@ xdr_array_decode(XDR *xdrs, char **cpp, u_int *sizep, u_int maxsize,
 	u_int i = 0;
 	uint32_t size;
 	bool stat = true;
+	int bulk;
 
 	if (maxsize > (UINT_MAX / selem)) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
@@ -792,7 +954,11 @@ xdr_array_decode(XDR *xdrs, char **cpp, u_int *sizep, u_int maxsize,
 	if (!size)
 		return (true);
 	if (!target)
-		*cpp = target = (char*) mem_zalloc(size * selem);
+		*cpp = target = (char*) xdr_zalloc(xdrs, size * selem);
+
+	bulk = xdr_elem_bulk(selem, xdr_elem);
+	if (bulk)
+		return (xdr_elem_bulk_vector(xdrs, target, size, bulk));
 
 	for (; (i < size) && stat; i++) {
 		stat = (*xdr_elem) (xdrs, target);
@@ -810,6 +976,7 @@ xdr_array_encode(XDR *xdrs, char **cpp, u_int *sizep, u_int maxsize,
 	u_int i = 0;
 	uint32_t size = (uint32_t)*sizep;
 	bool stat = true;
+	int bulk;
 
 	if (*sizep > maxsize) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
@@ -831,6 +998,10 @@ xdr_array_encode(XDR *xdrs, char **cpp, u_int *sizep, u_int maxsize,
 	if (!XDR_PUTUINT32(xdrs, size))
 		return (false);
 
+	bulk = xdr_elem_bulk(selem, xdr_elem);
+	if (bulk)
+		return (xdr_elem_bulk_vector(xdrs, target, size, bulk));
+
 	for (; (i < size) && stat; i++) {
 		stat = (*xdr_elem) (xdrs, target);
 		target += selem;
@@ -942,11 +1113,11 @@ xdr_string_decode(XDR *xdrs, char **cpp, u_int maxsize)
 	 * now deal with the actual bytes
 	 */
 	if (!sp)
-		sp = (char *)mem_alloc(nodesize);
+		sp = (char *)xdr_alloc(xdrs, nodesize);
 
 	ret = xdr_opaque_decode(xdrs, sp, size);
 	if (!ret) {
-		mem_free(sp, nodesize);
+		xdr_unalloc(xdrs, sp, nodesize);
 		return (ret);
 	}
 	sp[size] = '\0';
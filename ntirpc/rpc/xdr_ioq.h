@@ -98,6 +98,22 @@ struct xdr_ioq_uv
 
 struct xdr_ioq;
 
+/* segment index entry: stream offset of uv->v.vio_head */
+struct xdr_ioq_seg {
+	struct xdr_ioq_uv *uv;
+	size_t off;
+};
+
+/* segment index of longer streams, extended as segments are appended;
+ * see xdr_ioq_seek().
+ */
+struct xdr_ioq_seg_index {
+	struct xdr_ioq_seg *segv;
+	u_int segc;		/* entries valid */
+	u_int segmax;		/* entries allocated */
+	u_int segcur;		/* cursor, last entry found */
+};
+
 struct xdr_ioq_uv_head {
 	struct poolq_head uvqh;
 
@@ -134,6 +150,11 @@ struct xdr_ioq {
 #endif
 
 	struct rpc_dplx_rec *rec;
+
+	/* New with libntirpc 7.0 */
+	uint32_t recv_budget;	/* bytes charged to rec receive budget */
+	uint32_t send_budget;	/* bytes charged to rec send budget */
+	struct xdr_ioq_seg_index ioq_segs;	/* of ioq_uv */
 };
 
 #define _IOQ(p) (opr_containerof((p), struct xdr_ioq, ioq_s))
@@ -162,10 +183,15 @@ extern struct poolq_entry *xdr_ioq_uv_fetch_nothing(struct xdr_ioq *xioq,
 						     u_int ioq_flags);
 extern void xdr_ioq_uv_release(struct xdr_ioq_uv *uv);
 
+struct rpc_ioq_pool_stat;
+extern bool xdr_ioq_pool_control(int what, struct rpc_ioq_pool_stat *stat);
+extern size_t xdr_ioq_pool_trim(void);
+
 extern struct xdr_ioq *xdr_ioq_create(size_t min_bsize, size_t max_bsize,
 				      u_int uio_flags);
 extern void xdr_ioq_release(struct poolq_head *ioqh);
 extern void xdr_ioq_reset(struct xdr_ioq *xioq, u_int wh_pos);
+extern u_int xdr_ioq_extent(struct xdr_ioq *xioq, u_int start, u_int count);
 extern void xdr_ioq_setup(struct xdr_ioq *xioq);
 
 extern void xdr_ioq_destroy(struct xdr_ioq *xioq, size_t qsize);
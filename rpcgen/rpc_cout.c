@@ -0,0 +1,723 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * rpc_cout.c, codec output: an XDR routine and a size routine for each
+ * type.
+ *
+ * Consecutive fields of fixed external size (integers, enums, booleans,
+ * hypers, and fixed vectors and opaques of them) form a run, reserved
+ * with one xdr_inline_encode() or xdr_inline_decode() bounds check and
+ * coded with the IXDR_* macros.  Only when the run crosses a buffer
+ * boundary (or when freeing) are the fields coded one call at a time.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rpc_gen.h"
+
+#define LV_LEN 256
+#define PROC_LEN 256
+
+/* the code of one routine, declarations decided after */
+static struct {
+	char *text;
+	size_t len;
+	FILE *f;
+	bool need_buf;
+	bool need_i;
+} body;
+
+static const char *
+tabs(int n)
+{
+	static const char t[] = "\t\t\t\t\t\t\t\t";
+
+	return (&t[sizeof(t) - 1 - n]);
+}
+
+static void
+lv_format(char *buf, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(buf, LV_LEN, fmt, ap);
+	va_end(ap);
+	if (n >= LV_LEN)
+		fatal("expression too long: %s", buf);
+}
+
+/*
+ * An lvalue is either a member expression (objp->f, objp->u_u.f), or
+ * "*objp" for a typedef, which reads better as objp-> and objp.
+ */
+static void
+lv_member(char *buf, const char *lv, const char *member)
+{
+	if (!strcmp(lv, "*objp"))
+		lv_format(buf, "objp->%s", member);
+	else
+		lv_format(buf, "%s.%s", lv, member);
+}
+
+static void
+lv_addr(char *buf, const char *lv)
+{
+	if (!strcmp(lv, "*objp"))
+		lv_format(buf, "objp");
+	else
+		lv_format(buf, "&%s", lv);
+}
+
+/* the argument naming an object of type, whose lvalue is lv */
+static void
+lv_arg(char *buf, const char *lv, const char *type)
+{
+	if (vector_param(type))
+		lv_format(buf, "%s", lv);
+	else
+		lv_addr(buf, lv);
+}
+
+static void
+emit_call(int t, const char *call)
+{
+	fprintf(body.f, "%sif (!%s)\n%sreturn (false);\n",
+		tabs(t), call, tabs(t + 1));
+}
+
+/*
+ * One declaration, coded by calls (any direction).
+ */
+static void
+emit_xdr_decl(const struct decl *dp, const char *lv, int t)
+{
+	char proc[PROC_LEN];
+	char call[PROC_LEN + 3 * LV_LEN];
+	char arg[LV_LEN];
+	char len[LV_LEN];
+	char val[LV_LEN];
+	const char *max = dp->bound ? dp->bound : "~0";
+
+	if (!strcmp(dp->type, "void"))
+		return;
+	xdr_proc(proc, sizeof(proc), dp->type);
+
+	switch (dp->rel) {
+	case REL_ALIAS:
+		lv_arg(arg, lv, dp->type);
+		snprintf(call, sizeof(call), "%s(xdrs, %s)", proc, arg);
+		break;
+	case REL_VECTOR:
+		if (!strcmp(dp->type, "opaque")) {
+			snprintf(call, sizeof(call),
+				 "xdr_opaque(xdrs, %s, %s)", lv, dp->bound);
+			break;
+		}
+		snprintf(call, sizeof(call),
+			 "xdr_vector(xdrs, (char *)%s, %s,\n%s%ssizeof(%s), "
+			 "(xdrproc_t)%s)",
+			 lv, dp->bound, tabs(t + 1), "    ", c_type(dp), proc);
+		break;
+	case REL_ARRAY:
+		if (!strcmp(dp->type, "string")) {
+			lv_addr(arg, lv);
+			snprintf(call, sizeof(call),
+				 "xdr_string(xdrs, %s, %s)", arg, max);
+			break;
+		}
+		lv_member(val, lv, dp->name);
+		strcat(val, "_val");
+		lv_member(len, lv, dp->name);
+		strcat(len, "_len");
+		if (!strcmp(dp->type, "opaque")) {
+			snprintf(call, sizeof(call),
+				 "xdr_bytes(xdrs, (char **)&%s,\n%s%s"
+				 "(u_int *)&%s, %s)",
+				 val, tabs(t + 1), "    ", len, max);
+			break;
+		}
+		snprintf(call, sizeof(call),
+			 "xdr_array(xdrs, (char **)&%s,\n%s%s"
+			 "(u_int *)&%s, %s,\n%s%ssizeof(%s), (xdrproc_t)%s)",
+			 val, tabs(t + 1), "    ", len, max,
+			 tabs(t + 1), "    ", c_type(dp), proc);
+		break;
+	case REL_POINTER:
+		lv_addr(arg, lv);
+		snprintf(call, sizeof(call),
+			 "xdr_pointer(xdrs, (void **)%s, sizeof(%s),\n%s%s"
+			 "(xdrproc_t)%s)",
+			 arg, c_type(dp), tabs(t + 1), "    ", proc);
+		break;
+	}
+	emit_call(t, call);
+}
+
+/*
+ * External units of a declaration that can be coded in line, else 0.
+ */
+static long
+inline_units(const struct decl *dp)
+{
+	enum inline_kind kind = inline_type(dp->type);
+	long n;
+
+	switch (dp->rel) {
+	case REL_ALIAS:
+		if (kind == INL_NONE)
+			return (0);
+		return ((kind == INL_INT64 || kind == INL_UINT64) ? 2 : 1);
+	case REL_VECTOR:
+		if (!resolve_value(dp->bound, &n) || n <= 0)
+			return (0);
+		if (!strcmp(dp->type, "opaque"))
+			return ((n + 3) / 4);
+		if (kind == INL_NONE)
+			return (0);
+		return ((kind == INL_INT64 || kind == INL_UINT64) ? 2 * n : n);
+	default:
+		return (0);
+	}
+}
+
+static void
+emit_put(enum inline_kind kind, const char *v, int t)
+{
+	switch (kind) {
+	case INL_INT32:
+		fprintf(body.f, "%sIXDR_PUT_INT32(buf, %s);\n", tabs(t), v);
+		break;
+	case INL_UINT32:
+		fprintf(body.f, "%sIXDR_PUT_U_INT32(buf, %s);\n", tabs(t), v);
+		break;
+	case INL_LONG:
+		fprintf(body.f, "%sIXDR_PUT_LONG(buf, %s);\n", tabs(t), v);
+		break;
+	case INL_ULONG:
+		fprintf(body.f, "%sIXDR_PUT_U_LONG(buf, %s);\n", tabs(t), v);
+		break;
+	case INL_BOOL:
+		fprintf(body.f, "%sIXDR_PUT_BOOL(buf, %s);\n", tabs(t), v);
+		break;
+	case INL_ENUM:
+		fprintf(body.f, "%sIXDR_PUT_ENUM(buf, %s);\n", tabs(t), v);
+		break;
+	case INL_INT64:
+	case INL_UINT64:
+		fprintf(body.f, "%sIXDR_PUT_U_INT32(buf, ((uint64_t)%s >> 32));\n",
+			tabs(t), v);
+		fprintf(body.f, "%sIXDR_PUT_U_INT32(buf, %s);\n", tabs(t), v);
+		break;
+	case INL_NONE:
+		break;
+	}
+}
+
+static void
+emit_get(enum inline_kind kind, const char *v, const char *ctype, int t)
+{
+	switch (kind) {
+	case INL_INT32:
+		fprintf(body.f, "%s%s = IXDR_GET_INT32(buf);\n", tabs(t), v);
+		break;
+	case INL_UINT32:
+		fprintf(body.f, "%s%s = IXDR_GET_U_INT32(buf);\n", tabs(t), v);
+		break;
+	case INL_LONG:
+		fprintf(body.f, "%s%s = IXDR_GET_LONG(buf);\n", tabs(t), v);
+		break;
+	case INL_ULONG:
+		fprintf(body.f, "%s%s = IXDR_GET_U_LONG(buf);\n", tabs(t), v);
+		break;
+	case INL_BOOL:
+		fprintf(body.f, "%s%s = IXDR_GET_BOOL(buf);\n", tabs(t), v);
+		break;
+	case INL_ENUM:
+		fprintf(body.f, "%s%s = IXDR_GET_ENUM(buf, %s);\n",
+			tabs(t), v, ctype);
+		break;
+	case INL_INT64:
+	case INL_UINT64:
+		fprintf(body.f, "%s%s = (uint64_t)IXDR_GET_U_INT32(buf) << 32;\n",
+			tabs(t), v);
+		fprintf(body.f, "%s%s |= IXDR_GET_U_INT32(buf);\n", tabs(t), v);
+		break;
+	case INL_NONE:
+		break;
+	}
+}
+
+/*
+ * One declaration of a run, in line; encode (or decode) into buf.
+ */
+static void
+emit_inline_decl(const struct decl *dp, const char *lv, bool encode, int t)
+{
+	enum inline_kind kind = inline_type(dp->type);
+	const char *ctype = c_type(dp);
+	bool wide = (kind == INL_INT64 || kind == INL_UINT64);
+	char elem[LV_LEN];
+	long n;
+
+	if (dp->rel == REL_ALIAS) {
+		if (encode)
+			emit_put(kind, lv, t);
+		else
+			emit_get(kind, lv, ctype, t);
+		return;
+	}
+
+	resolve_value(dp->bound, &n);
+	if (!strcmp(dp->type, "opaque")) {
+		if (encode) {
+			fprintf(body.f, "%smemcpy(buf, %s, %s);\n",
+				tabs(t), lv, dp->bound);
+			if (n & 3)
+				fprintf(body.f,
+					"%smemset((char *)buf + %ld, 0, %ld);\n",
+					tabs(t), n, 4 - (n & 3));
+		} else {
+			fprintf(body.f, "%smemcpy(%s, buf, %s);\n",
+				tabs(t), lv, dp->bound);
+		}
+		fprintf(body.f, "%sbuf += %ld;\n", tabs(t), (n + 3) / 4);
+		return;
+	}
+
+	body.need_i = true;
+	lv_format(elem, "%s[i]", lv);
+	fprintf(body.f, "%sfor (i = 0; i < %s; i++)%s\n",
+		tabs(t), dp->bound, wide ? " {" : "");
+	if (encode)
+		emit_put(kind, elem, t + 1);
+	else
+		emit_get(kind, elem, ctype, t + 1);
+	if (wide)
+		fprintf(body.f, "%s}\n", tabs(t));
+}
+
+static void
+emit_run(struct decl **run, const char **lvs, int count, long units, int t)
+{
+	int j;
+
+	body.need_buf = true;
+	fprintf(body.f, "%sif (xdrs->x_op == XDR_ENCODE\n", tabs(t));
+	fprintf(body.f, "%s    && (buf = xdr_inline_encode(xdrs, "
+		"%ld * BYTES_PER_XDR_UNIT)) != NULL) {\n", tabs(t), units);
+	for (j = 0; j < count; j++)
+		emit_inline_decl(run[j], lvs[j], true, t + 1);
+	fprintf(body.f, "%s} else if (xdrs->x_op == XDR_DECODE\n", tabs(t));
+	fprintf(body.f, "%s    && (buf = xdr_inline_decode(xdrs, "
+		"%ld * BYTES_PER_XDR_UNIT)) != NULL) {\n", tabs(t), units);
+	for (j = 0; j < count; j++)
+		emit_inline_decl(run[j], lvs[j], false, t + 1);
+	fprintf(body.f, "%s} else {\n", tabs(t));
+	fprintf(body.f, "%s/* across buffers, or freeing */\n", tabs(t + 1));
+	for (j = 0; j < count; j++)
+		emit_xdr_decl(run[j], lvs[j], t + 1);
+	fprintf(body.f, "%s}\n", tabs(t));
+}
+
+/*
+ * A sequence of declarations, with runs of more than one unit in line.
+ * A lone scalar gains nothing from it.
+ */
+static void
+emit_xdr_decls(struct decl **dv, const char **lvs, int count, int t)
+{
+	long units;
+	long u;
+	int start;
+	int j;
+
+	for (j = 0; j < count; ) {
+		if (!inline_units(dv[j])) {
+			emit_xdr_decl(dv[j], lvs[j], t);
+			j++;
+			continue;
+		}
+		for (start = j, units = 0;
+		     j < count && (u = inline_units(dv[j])); j++)
+			units += u;
+		if (units < 2 || (j - start == 1 && dv[start]->rel == REL_ALIAS))
+			while (start < j) {
+				emit_xdr_decl(dv[start], lvs[start], t);
+				start++;
+			}
+		else
+			emit_run(&dv[start], &lvs[start], j - start, units, t);
+	}
+}
+
+/*
+ * Size of one declaration, added to size.  Fixed sizes are summed by
+ * the caller.
+ */
+static void
+emit_size_decl(const struct decl *dp, const char *lv, int t)
+{
+	char proc[PROC_LEN];
+	char arg[LV_LEN];
+	char len[LV_LEN];
+	char val[LV_LEN];
+	char elem[LV_LEN];
+	long f;
+
+	if (fixed_size(dp) >= 0)
+		return;
+	size_proc(proc, sizeof(proc), dp->type);
+	f = fixed_type_size(dp->type);
+
+	switch (dp->rel) {
+	case REL_ALIAS:
+		lv_arg(arg, lv, dp->type);
+		fprintf(body.f, "%ssize += %s(%s);\n", tabs(t), proc, arg);
+		break;
+	case REL_VECTOR:
+		if (!strcmp(dp->type, "opaque")) {
+			fprintf(body.f, "%ssize += RNDUP(%s);\n",
+				tabs(t), dp->bound);
+			break;
+		}
+		if (f >= 0) {
+			fprintf(body.f, "%ssize += %s * %ld;\n",
+				tabs(t), dp->bound, f);
+			break;
+		}
+		body.need_i = true;
+		lv_format(elem, "%s[i]", lv);
+		lv_arg(arg, elem, dp->type);
+		fprintf(body.f, "%sfor (i = 0; i < %s; i++)\n", tabs(t),
+			dp->bound);
+		fprintf(body.f, "%ssize += %s(%s);\n", tabs(t + 1), proc, arg);
+		break;
+	case REL_ARRAY:
+		if (!strcmp(dp->type, "string")) {
+			fprintf(body.f, "%ssize += xdr_string_size(%s);\n",
+				tabs(t), lv);
+			break;
+		}
+		lv_member(val, lv, dp->name);
+		strcat(val, "_val");
+		lv_member(len, lv, dp->name);
+		strcat(len, "_len");
+		if (!strcmp(dp->type, "opaque")) {
+			fprintf(body.f, "%ssize += BYTES_PER_XDR_UNIT + "
+				"RNDUP(%s);\n", tabs(t), len);
+			break;
+		}
+		if (f >= 0) {
+			fprintf(body.f, "%ssize += BYTES_PER_XDR_UNIT + "
+				"%s * %ld;\n", tabs(t), len, f);
+			break;
+		}
+		body.need_i = true;
+		lv_format(elem, "%s[i]", val);
+		lv_arg(arg, elem, dp->type);
+		fprintf(body.f, "%ssize += BYTES_PER_XDR_UNIT;\n", tabs(t));
+		fprintf(body.f, "%sfor (i = 0; i < %s; i++)\n", tabs(t), len);
+		fprintf(body.f, "%ssize += %s(%s);\n", tabs(t + 1), proc, arg);
+		break;
+	case REL_POINTER:
+		fprintf(body.f, "%ssize += BYTES_PER_XDR_UNIT;\n", tabs(t));
+		fprintf(body.f, "%sif (%s)\n", tabs(t), lv);
+		if (f >= 0)
+			fprintf(body.f, "%ssize += %ld;\n", tabs(t + 1), f);
+		else if (vector_param(dp->type))
+			fprintf(body.f, "%ssize += %s(*%s);\n",
+				tabs(t + 1), proc, lv);
+		else
+			fprintf(body.f, "%ssize += %s(%s);\n",
+				tabs(t + 1), proc, lv);
+		break;
+	}
+}
+
+static void
+body_begin(void)
+{
+	body.f = open_memstream(&body.text, &body.len);
+	if (!body.f)
+		fatal("out of memory");
+	body.need_buf = false;
+	body.need_i = false;
+}
+
+static void
+body_end(FILE *fout, const char *locals)
+{
+	fclose(body.f);
+	if (body.need_buf)
+		fprintf(fout, "\tint32_t *buf;\n");
+	if (body.need_i)
+		fprintf(fout, "\tu_int i;\n");
+	if (locals)
+		fprintf(fout, "%s", locals);
+	if (body.need_buf || body.need_i || locals)
+		fprintf(fout, "\n");
+	fputs(body.text, fout);
+	free(body.text);
+}
+
+static void
+print_signature(FILE *fout, const char *name, bool sizeof_fn, bool proto)
+{
+	const char *star = vector_param(name) ? "" : "*";
+
+	if (sizeof_fn)
+		fprintf(fout, "u_int%s%sxdr_sizeof_%s(const %s %sobjp)%s",
+			proto ? " " : "\n", prefix, name, name, star,
+			proto ? ";\n" : "\n");
+	else
+		fprintf(fout, "bool%s%sxdr_%s(XDR *xdrs, %s %sobjp)%s",
+			proto ? " " : "\n", prefix, name, name, star,
+			proto ? ";\n" : "\n");
+}
+
+static void
+emit_enum(FILE *fout, const struct definition *defp)
+{
+	print_signature(fout, defp->name, false, false);
+	fprintf(fout, "{\n");
+	fprintf(fout, "\tif (!xdr_enum(xdrs, (enum_t *)objp))\n"
+		      "\t\treturn (false);\n");
+	fprintf(fout, "\treturn (true);\n}\n\n");
+
+	print_signature(fout, defp->name, true, false);
+	fprintf(fout, "{\n\treturn (BYTES_PER_XDR_UNIT);\n}\n\n");
+}
+
+static void
+emit_struct(FILE *fout, const struct definition *defp)
+{
+	struct decl *dv[256];
+	const char *lvs[256];
+	char lv[LV_LEN];
+	struct decl *dp;
+	long fixed = 0;
+	long f;
+	int count = 0;
+
+	for (dp = defp->def.fields; dp; dp = dp->next) {
+		if (count == 256)
+			fatal("struct %s: too many fields", defp->name);
+		lv_format(lv, "objp->%s", dp->name);
+		dv[count] = dp;
+		lvs[count++] = xstrdup(lv);
+	}
+
+	print_signature(fout, defp->name, false, false);
+	fprintf(fout, "{\n");
+	body_begin();
+	emit_xdr_decls(dv, lvs, count, 1);
+	fprintf(body.f, "\treturn (true);\n}\n\n");
+	body_end(fout, NULL);
+
+	print_signature(fout, defp->name, true, false);
+	fprintf(fout, "{\n");
+	body_begin();
+	for (dp = defp->def.fields; dp; dp = dp->next) {
+		f = fixed_size(dp);
+		if (f >= 0)
+			fixed += f;
+	}
+	for (count = 0, dp = defp->def.fields; dp; dp = dp->next, count++)
+		emit_size_decl(dp, lvs[count], 1);
+	fprintf(body.f, "\treturn (size);\n}\n\n");
+	lv_format(lv, "\tu_int size = %ld;\n", fixed);
+	body_end(fout, lv);
+}
+
+static void
+emit_arms(const struct definition *defp, bool sizes)
+{
+	const char *dname = defp->def.un.disc->name;
+	char lv[LV_LEN];
+	struct caseval *cv;
+	struct arm *ap;
+	struct decl *dp;
+	long f;
+
+	fprintf(body.f, "\tswitch (objp->%s) {\n", dname);
+	for (ap = defp->def.un.arms; ; ap = ap->next) {
+		if (ap) {
+			for (cv = ap->values; cv; cv = cv->next)
+				fprintf(body.f, "\tcase %s:\n", cv->value);
+			dp = ap->decl;
+		} else {
+			dp = defp->def.un.dflt;
+			fprintf(body.f, "\tdefault:\n");
+			if (!dp) {
+				fprintf(body.f, "\t\t%s;\n",
+					sizes ? "break" : "return (false)");
+				break;
+			}
+		}
+		lv_format(lv, "objp->%s_u.%s", defp->name,
+			 dp->name);
+		if (!strcmp(dp->type, "void"))
+			;
+		else if (!sizes)
+			emit_xdr_decl(dp, lv, 2);
+		else if ((f = fixed_size(dp)) > 0)
+			fprintf(body.f, "\t\tsize += %ld;\n", f);
+		else
+			emit_size_decl(dp, lv, 2);
+		fprintf(body.f, "\t\tbreak;\n");
+		if (!ap)
+			break;
+	}
+	fprintf(body.f, "\t}\n");
+}
+
+static void
+emit_union(FILE *fout, const struct definition *defp)
+{
+	struct decl *disc = defp->def.un.disc;
+	char lv[LV_LEN];
+	long f;
+
+	lv_format(lv, "objp->%s", disc->name);
+
+	print_signature(fout, defp->name, false, false);
+	fprintf(fout, "{\n");
+	body_begin();
+	emit_xdr_decl(disc, lv, 1);
+	emit_arms(defp, false);
+	fprintf(body.f, "\treturn (true);\n}\n\n");
+	body_end(fout, NULL);
+
+	print_signature(fout, defp->name, true, false);
+	fprintf(fout, "{\n");
+	body_begin();
+	f = fixed_size(disc);
+	if (f < 0)
+		emit_size_decl(disc, lv, 1);
+	emit_arms(defp, true);
+	fprintf(body.f, "\treturn (size);\n}\n\n");
+	lv_format(lv, "\tu_int size = %ld;\n", f < 0 ? 0 : f);
+	body_end(fout, lv);
+}
+
+static void
+emit_typedef(FILE *fout, const struct definition *defp)
+{
+	struct decl *dp = defp->def.decl;
+	const char *lv = vector_param(defp->name) ? "objp" : "*objp";
+	long f = fixed_size(dp);
+	char locals[LV_LEN];
+
+	print_signature(fout, defp->name, false, false);
+	fprintf(fout, "{\n");
+	body_begin();
+	emit_xdr_decls(&dp, &lv, 1, 1);
+	fprintf(body.f, "\treturn (true);\n}\n\n");
+	body_end(fout, NULL);
+
+	print_signature(fout, defp->name, true, false);
+	fprintf(fout, "{\n");
+	if (f >= 0) {
+		fprintf(fout, "\treturn (%ld);\n}\n\n", f);
+		return;
+	}
+	body_begin();
+	emit_size_decl(dp, lv, 1);
+	fprintf(body.f, "\treturn (size);\n}\n\n");
+	lv_format(locals, "\tu_int size = 0;\n");
+	body_end(fout, locals);
+}
+
+void
+emit_codecs(FILE *fout, const char *include)
+{
+	struct definition *defp;
+	bool protos = false;
+
+	fprintf(fout, "/*\n"
+		      " * Please do not edit this file.\n"
+		      " * It was generated using ntirpcgen.\n"
+		      " */\n\n");
+	fprintf(fout, "#define XDR_DIRECT\n\n");
+	fprintf(fout, "#include <string.h>\n\n");
+	fprintf(fout, "#include <rpc/rpc.h>\n");
+	if (include[0] == '<')
+		fprintf(fout, "#include %s\n", include);
+	else
+		fprintf(fout, "#include \"%s\"\n", include);
+	fprintf(fout, "#include <rpc/xdr_inline.h>\n\n");
+
+	fprintf(fout, "static inline u_int\n"
+		      "xdr_string_size(const char *sp)\n"
+		      "{\n"
+		      "\treturn (BYTES_PER_XDR_UNIT + RNDUP(sp ? strlen(sp) : 0));\n"
+		      "}\n\n");
+
+	/* routines may refer to those defined later */
+	for (defp = defined; defp; defp = defp->next) {
+		switch (defp->kind) {
+		case DEF_ENUM:
+		case DEF_STRUCT:
+		case DEF_UNION:
+		case DEF_TYPEDEF:
+			print_signature(fout, defp->name, false, true);
+			print_signature(fout, defp->name, true, true);
+			protos = true;
+			break;
+		default:
+			break;
+		}
+	}
+	if (protos)
+		fprintf(fout, "\n");
+
+	for (defp = defined; defp; defp = defp->next) {
+		switch (defp->kind) {
+		case DEF_PASS:
+			fprintf(fout, "%s\n", defp->name);
+			break;
+		case DEF_ENUM:
+			emit_enum(fout, defp);
+			break;
+		case DEF_STRUCT:
+			emit_struct(fout, defp);
+			break;
+		case DEF_UNION:
+			emit_union(fout, defp);
+			break;
+		case DEF_TYPEDEF:
+			emit_typedef(fout, defp);
+			break;
+		case DEF_CONST:
+		case DEF_PROGRAM:
+			break;
+		}
+	}
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * rpc_gen.h, definitions shared by the ntirpcgen parser and emitters.
+ *
+ * The parse tree follows the classic rpcgen one: a list of definitions,
+ * in file order, where each declaration is a base type, a name, and its
+ * relation to the base type (alias, fixed vector, counted array, or
+ * optional pointer).
+ */
+
+#ifndef RPC_GEN_H
+#define RPC_GEN_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+enum defkind {
+	DEF_PASS,		/* % line, copied to the output */
+	DEF_CONST,
+	DEF_ENUM,
+	DEF_STRUCT,
+	DEF_UNION,
+	DEF_TYPEDEF,
+	DEF_PROGRAM,
+};
+
+enum relation {
+	REL_ALIAS,		/* T name */
+	REL_VECTOR,		/* T name[bound] */
+	REL_ARRAY,		/* T name<bound> */
+	REL_POINTER,		/* T *name */
+};
+
+struct decl {
+	struct decl *next;
+	const char *prefix;	/* "struct", "union", "enum", or NULL */
+	const char *type;	/* base type, "void" for a void arm */
+	const char *name;
+	enum relation rel;
+	const char *bound;	/* vector size, or array maximum (or NULL) */
+};
+
+struct enumval {
+	struct enumval *next;
+	const char *name;
+	const char *value;	/* or NULL, following the previous */
+};
+
+struct caseval {
+	struct caseval *next;
+	const char *value;
+};
+
+struct arm {
+	struct arm *next;
+	struct caseval *values;
+	struct decl *decl;	/* void arms have type "void" */
+};
+
+struct proc {
+	struct proc *next;
+	const char *name;
+	const char *num;
+};
+
+struct version {
+	struct version *next;
+	const char *name;
+	const char *num;
+	struct proc *procs;
+};
+
+struct definition {
+	struct definition *next;
+	enum defkind kind;
+	const char *name;	/* or the text of a % line */
+	union {
+		const char *value;		/* DEF_CONST */
+		struct enumval *vals;		/* DEF_ENUM */
+		struct decl *fields;		/* DEF_STRUCT */
+		struct decl *decl;		/* DEF_TYPEDEF */
+		struct {
+			struct decl *disc;
+			struct arm *arms;
+			struct decl *dflt;	/* or NULL */
+		} un;				/* DEF_UNION */
+		struct {
+			const char *num;
+			struct version *vers;
+		} prog;				/* DEF_PROGRAM */
+	} def;
+};
+
+/* rpc_parse.c */
+extern struct definition *parse_file(const char *path, const char *define);
+
+/* rpc_util.c */
+extern const char *prefix;		/* of generated function names */
+extern struct definition *defined;	/* the parse tree */
+
+extern void *xzalloc(size_t size);
+extern char *xstrdup(const char *s);
+extern void fatal(const char *fmt, ...)
+	__attribute__ ((format(printf, 1, 2), noreturn));
+
+extern struct definition *find_def(const char *name);
+extern bool resolve_value(const char *value, long *result);
+extern const char *c_type(const struct decl *dp);
+extern void xdr_proc(char *buf, size_t len, const char *type);
+extern void size_proc(char *buf, size_t len, const char *type);
+extern bool vector_param(const char *type);
+
+/*
+ * Fixed-size types have a known external size (bytes); those of one or
+ * two units may also be coded in line, between one bounds check.
+ */
+enum inline_kind {
+	INL_NONE,
+	INL_INT32,
+	INL_UINT32,
+	INL_LONG,
+	INL_ULONG,
+	INL_BOOL,
+	INL_ENUM,
+	INL_INT64,
+	INL_UINT64,
+};
+
+extern enum inline_kind inline_type(const char *type);
+extern long fixed_size(const struct decl *dp);
+extern long fixed_type_size(const char *type);
+
+/* rpc_hout.c */
+extern void emit_header(FILE *fout, const char *guard);
+
+/* rpc_cout.c */
+extern void emit_codecs(FILE *fout, const char *include);
+
+#endif				/* RPC_GEN_H */
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * rpc_hout.c, header output: C types, constants, program numbers, and
+ * the prototypes of the generated routines.
+ */
+
+#include <string.h>
+
+#include "rpc_gen.h"
+
+static void
+print_decl(FILE *fout, const struct decl *dp, const char *indent)
+{
+	const char *ctype = c_type(dp);
+
+	switch (dp->rel) {
+	case REL_ALIAS:
+		fprintf(fout, "%s %s;\n", ctype, dp->name);
+		break;
+	case REL_VECTOR:
+		fprintf(fout, "%s %s[%s];\n", ctype, dp->name, dp->bound);
+		break;
+	case REL_POINTER:
+		fprintf(fout, "%s *%s;\n", ctype, dp->name);
+		break;
+	case REL_ARRAY:
+		if (!strcmp(dp->type, "string")) {
+			fprintf(fout, "char *%s;\n", dp->name);
+			break;
+		}
+		fprintf(fout, "struct {\n");
+		fprintf(fout, "%s\tu_int %s_len;\n", indent, dp->name);
+		fprintf(fout, "%s\t%s *%s_val;\n", indent, ctype, dp->name);
+		fprintf(fout, "%s} %s;\n", indent, dp->name);
+		break;
+	}
+}
+
+static void
+print_prototypes(FILE *fout, const char *name)
+{
+	if (vector_param(name)) {
+		fprintf(fout, "extern bool %sxdr_%s(XDR *, %s);\n",
+			prefix, name, name);
+		fprintf(fout, "extern u_int %sxdr_sizeof_%s(const %s);\n\n",
+			prefix, name, name);
+		return;
+	}
+	fprintf(fout, "extern bool %sxdr_%s(XDR *, %s *);\n",
+		prefix, name, name);
+	fprintf(fout, "extern u_int %sxdr_sizeof_%s(const %s *);\n\n",
+		prefix, name, name);
+}
+
+static void
+print_enum(FILE *fout, const struct definition *defp)
+{
+	struct enumval *ev;
+
+	fprintf(fout, "enum %s {\n", defp->name);
+	for (ev = defp->def.vals; ev; ev = ev->next) {
+		if (ev->value)
+			fprintf(fout, "\t%s = %s,\n", ev->name, ev->value);
+		else
+			fprintf(fout, "\t%s,\n", ev->name);
+	}
+	fprintf(fout, "};\n");
+	fprintf(fout, "typedef enum %s %s;\n\n", defp->name, defp->name);
+}
+
+static void
+print_struct(FILE *fout, const struct definition *defp)
+{
+	struct decl *dp;
+
+	fprintf(fout, "struct %s {\n", defp->name);
+	for (dp = defp->def.fields; dp; dp = dp->next) {
+		fprintf(fout, "\t");
+		print_decl(fout, dp, "\t");
+	}
+	fprintf(fout, "};\n");
+	fprintf(fout, "typedef struct %s %s;\n\n", defp->name, defp->name);
+}
+
+static void
+print_union(FILE *fout, const struct definition *defp)
+{
+	struct arm *ap;
+	bool any = false;
+
+	fprintf(fout, "struct %s {\n\t", defp->name);
+	print_decl(fout, defp->def.un.disc, "\t");
+
+	for (ap = defp->def.un.arms; ap; ap = ap->next)
+		any |= strcmp(ap->decl->type, "void") != 0;
+	if (defp->def.un.dflt)
+		any |= strcmp(defp->def.un.dflt->type, "void") != 0;
+
+	if (any) {
+		fprintf(fout, "\tunion {\n");
+		for (ap = defp->def.un.arms; ap; ap = ap->next) {
+			if (!strcmp(ap->decl->type, "void"))
+				continue;
+			fprintf(fout, "\t\t");
+			print_decl(fout, ap->decl, "\t\t");
+		}
+		if (defp->def.un.dflt
+		 && strcmp(defp->def.un.dflt->type, "void")) {
+			fprintf(fout, "\t\t");
+			print_decl(fout, defp->def.un.dflt, "\t\t");
+		}
+		fprintf(fout, "\t} %s_u;\n", defp->name);
+	}
+	fprintf(fout, "};\n");
+	fprintf(fout, "typedef struct %s %s;\n\n", defp->name, defp->name);
+}
+
+static void
+print_program(FILE *fout, const struct definition *defp)
+{
+	struct version *vp;
+	struct proc *pp;
+
+	fprintf(fout, "#define %s %s\n", defp->name, defp->def.prog.num);
+	for (vp = defp->def.prog.vers; vp; vp = vp->next) {
+		fprintf(fout, "#define %s %s\n", vp->name, vp->num);
+		for (pp = vp->procs; pp; pp = pp->next)
+			fprintf(fout, "#define %s %s\n", pp->name, pp->num);
+	}
+	fprintf(fout, "\n");
+}
+
+void
+emit_header(FILE *fout, const char *guard)
+{
+	struct definition *defp;
+
+	fprintf(fout, "/*\n"
+		      " * Please do not edit this file.\n"
+		      " * It was generated using ntirpcgen.\n"
+		      " */\n\n");
+	fprintf(fout, "#ifndef %s\n#define %s\n\n", guard, guard);
+	fprintf(fout, "#include <rpc/rpc.h>\n\n");
+	fprintf(fout, "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n");
+
+	for (defp = defined; defp; defp = defp->next) {
+		switch (defp->kind) {
+		case DEF_PASS:
+			fprintf(fout, "%s\n", defp->name);
+			break;
+		case DEF_CONST:
+			fprintf(fout, "#define %s %s\n\n",
+				defp->name, defp->def.value);
+			break;
+		case DEF_ENUM:
+			print_enum(fout, defp);
+			print_prototypes(fout, defp->name);
+			break;
+		case DEF_STRUCT:
+			print_struct(fout, defp);
+			print_prototypes(fout, defp->name);
+			break;
+		case DEF_UNION:
+			print_union(fout, defp);
+			print_prototypes(fout, defp->name);
+			break;
+		case DEF_TYPEDEF:
+			fprintf(fout, "typedef ");
+			print_decl(fout, defp->def.decl, "");
+			fprintf(fout, "\n");
+			print_prototypes(fout, defp->name);
+			break;
+		case DEF_PROGRAM:
+			print_program(fout, defp);
+			break;
+		}
+	}
+
+	fprintf(fout, "#ifdef __cplusplus\n}\n#endif\n\n");
+	fprintf(fout, "#endif\t\t\t\t/* !%s */\n", guard);
+}
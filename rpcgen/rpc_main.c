@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * ntirpcgen, an XDR compiler for the rpcgen language that emits codecs
+ * for this library: bool results, xdr_inline_encode()/xdr_inline_decode()
+ * runs over xdr_ioq segments, and an exact xdr_sizeof_*() per type.
+ *
+ *	ntirpcgen -h [-o out.h] [-p prefix] file.x
+ *	ntirpcgen -c [-o out.c] [-p prefix] [-i header] file.x
+ *
+ * Only types are compiled; programs yield their numbers, and no client
+ * or server stubs are generated.
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rpc_gen.h"
+
+static void
+usage(void)
+{
+	fprintf(stderr,
+		"usage: ntirpcgen -h [-o outfile] [-p prefix] infile\n"
+		"       ntirpcgen -c [-o outfile] [-p prefix] [-i include] "
+		"infile\n");
+	exit(1);
+}
+
+/* rpcb_prot.x => rpcb_prot.h, or _RPCB_PROT_H_RPCGEN */
+static char *
+derive(const char *path, const char *suffix, bool guard)
+{
+	const char *base = strrchr(path, '/');
+	const char *dot;
+	char *s;
+	char *p;
+	size_t len;
+
+	base = base ? base + 1 : path;
+	dot = strrchr(base, '.');
+	len = dot ? (size_t)(dot - base) : strlen(base);
+	s = xzalloc(len + 16);
+	if (!guard) {
+		memcpy(s, base, len);
+		strcpy(s + len, suffix);
+		return (s);
+	}
+	s[0] = '_';
+	for (p = s + 1; len; len--, base++)
+		*p++ = isalnum((unsigned char)*base)
+			? toupper((unsigned char)*base) : '_';
+	strcpy(p, "_H_RPCGEN");
+	return (s);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *outfile = NULL;
+	const char *include = NULL;
+	const char *infile;
+	FILE *fout;
+	int hflag = 0;
+	int cflag = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "hci:o:p:")) != -1) {
+		switch (c) {
+		case 'h':
+			hflag = 1;
+			break;
+		case 'c':
+			cflag = 1;
+			break;
+		case 'i':
+			include = optarg;
+			break;
+		case 'o':
+			outfile = optarg;
+			break;
+		case 'p':
+			prefix = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (hflag + cflag != 1 || optind != argc - 1)
+		usage();
+	infile = argv[optind];
+
+	defined = parse_file(infile, hflag ? "RPC_HDR" : "RPC_XDR");
+
+	if (outfile) {
+		fout = fopen(outfile, "w");
+		if (!fout)
+			fatal("cannot create %s", outfile);
+	} else
+		fout = stdout;
+
+	if (hflag)
+		emit_header(fout, derive(infile, NULL, true));
+	else
+		emit_codecs(fout, include ? include : derive(infile, ".h",
+							     false));
+
+	if (ferror(fout) || (fout != stdout && fclose(fout))) {
+		if (outfile)
+			unlink(outfile);
+		fatal("cannot write %s", outfile ? outfile : "output");
+	}
+	return (0);
+}
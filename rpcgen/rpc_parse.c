@@ -0,0 +1,603 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * rpc_parse.c, scanner and parser for the RPC Language.
+ *
+ * Rather than running cpp, the few directives found in .x files are
+ * handled here: #ifdef, #ifndef, #if <number>, #else and #endif, with
+ * only the output's RPC_HDR or RPC_XDR defined.  Other directives are
+ * ignored.
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rpc_gen.h"
+
+enum tokkind {
+	TOK_EOF,
+	TOK_IDENT,
+	TOK_NUMBER,
+	TOK_PUNCT,
+	TOK_PASS,
+};
+
+struct token {
+	enum tokkind kind;
+	char *str;
+	int punct;
+};
+
+#define COND_MAX 32
+
+static struct {
+	const char *path;
+	const char *define;
+	char *text;
+	char *p;
+	int line;
+	bool bol;		/* at beginning of line */
+	int depth;
+	bool active[COND_MAX];
+	bool seen_else[COND_MAX];
+	struct token peeked;
+	bool have_peeked;
+} scan;
+
+static void
+perror_at(const char *msg, const char *what)
+{
+	fatal("%s:%d: %s%s%s", scan.path, scan.line, msg,
+	      what ? " " : "", what ? what : "");
+}
+
+static bool
+skipping(void)
+{
+	int i;
+
+	for (i = 0; i < scan.depth; i++)
+		if (!scan.active[i])
+			return (true);
+	return (false);
+}
+
+static char *
+scan_word(char **pp)
+{
+	char *p = *pp;
+	char *start;
+
+	while (*p == ' ' || *p == '\t')
+		p++;
+	start = p;
+	while (isalnum((unsigned char)*p) || *p == '_')
+		p++;
+	*pp = p;
+	return (strndup(start, p - start));
+}
+
+static void
+skip_line(void)
+{
+	while (*scan.p && *scan.p != '\n')
+		scan.p++;
+}
+
+static void
+directive(void)
+{
+	char *p = scan.p + 1;	/* after '#' */
+	char *word = scan_word(&p);
+	char *arg;
+	bool is_defined;
+	bool is_ifdef = !strcmp(word, "ifdef");
+
+	if (is_ifdef || !strcmp(word, "ifndef")) {
+		if (scan.depth == COND_MAX)
+			perror_at("conditionals nested too deep", NULL);
+		arg = scan_word(&p);
+		is_defined = !strcmp(arg, scan.define);
+		scan.active[scan.depth] = (is_defined == is_ifdef);
+		scan.seen_else[scan.depth++] = false;
+		free(arg);
+	} else if (!strcmp(word, "if")) {
+		if (scan.depth == COND_MAX)
+			perror_at("conditionals nested too deep", NULL);
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (!isdigit((unsigned char)*p))
+			perror_at("#if supports only a number", NULL);
+		scan.active[scan.depth] = strtol(p, NULL, 0) != 0;
+		scan.seen_else[scan.depth++] = false;
+	} else if (!strcmp(word, "else")) {
+		if (!scan.depth || scan.seen_else[scan.depth - 1])
+			perror_at("unexpected #else", NULL);
+		scan.active[scan.depth - 1] = !scan.active[scan.depth - 1];
+		scan.seen_else[scan.depth - 1] = true;
+	} else if (!strcmp(word, "endif")) {
+		if (!scan.depth)
+			perror_at("unexpected #endif", NULL);
+		scan.depth--;
+	}
+	/* else #define, #include, #pragma, ... are for cpp, ignored */
+	free(word);
+	skip_line();
+}
+
+static void
+next_token(struct token *tp)
+{
+	char *p;
+	char *start;
+
+	for (;;) {
+		p = scan.p;
+
+		if (scan.bol) {
+			scan.bol = false;
+
+			if (*p == '%') {
+				skip_line();
+				if (skipping())
+					continue;
+				tp->kind = TOK_PASS;
+				tp->str = strndup(p + 1, scan.p - (p + 1));
+				return;
+			}
+			while (*p == ' ' || *p == '\t')
+				p++;
+			if (*p == '#') {
+				scan.p = p;
+				directive();
+				continue;
+			}
+			if (skipping()) {
+				skip_line();
+				continue;
+			}
+		}
+
+		if (*p == '\0') {
+			if (scan.depth)
+				perror_at("missing #endif", NULL);
+			tp->kind = TOK_EOF;
+			tp->str = NULL;
+			return;
+		}
+		if (*p == '\n') {
+			scan.line++;
+			scan.bol = true;
+			scan.p = p + 1;
+			continue;
+		}
+		if (isspace((unsigned char)*p)) {
+			scan.p = p + 1;
+			continue;
+		}
+		if (p[0] == '/' && p[1] == '*') {
+			for (p += 2; *p && !(p[0] == '*' && p[1] == '/'); p++)
+				if (*p == '\n')
+					scan.line++;
+			if (!*p)
+				perror_at("unterminated comment", NULL);
+			scan.p = p + 2;
+			continue;
+		}
+		break;
+	}
+
+	start = p;
+	if (isalpha((unsigned char)*p) || *p == '_') {
+		while (isalnum((unsigned char)*p) || *p == '_')
+			p++;
+		tp->kind = TOK_IDENT;
+	} else if (isdigit((unsigned char)*p)
+		   || (*p == '-' && isdigit((unsigned char)p[1]))) {
+		p++;
+		while (isalnum((unsigned char)*p))
+			p++;
+		tp->kind = TOK_NUMBER;
+	} else if (strchr("{}()[]<>;,=*:", *p)) {
+		tp->kind = TOK_PUNCT;
+		tp->punct = *p++;
+	} else {
+		char what[2] = { *p, '\0' };
+
+		perror_at("unexpected character", what);
+	}
+	tp->str = strndup(start, p - start);
+	scan.p = p;
+}
+
+static struct token *
+peek(void)
+{
+	if (!scan.have_peeked) {
+		next_token(&scan.peeked);
+		scan.have_peeked = true;
+	}
+	return (&scan.peeked);
+}
+
+static struct token
+get(void)
+{
+	struct token t = *peek();
+
+	scan.have_peeked = false;
+	if (t.kind == TOK_PASS)
+		perror_at("%-line inside a definition", NULL);
+	return (t);
+}
+
+static bool
+peek_punct(int c)
+{
+	struct token *tp = peek();
+
+	return (tp->kind == TOK_PUNCT && tp->punct == c);
+}
+
+static bool
+peek_word(const char *word)
+{
+	struct token *tp = peek();
+
+	return (tp->kind == TOK_IDENT && !strcmp(tp->str, word));
+}
+
+static void
+expect_punct(int c)
+{
+	struct token t = get();
+	char what[2] = { c, '\0' };
+
+	if (t.kind != TOK_PUNCT || t.punct != c)
+		perror_at("expected", what);
+}
+
+static bool
+accept_punct(int c)
+{
+	if (!peek_punct(c))
+		return (false);
+	get();
+	return (true);
+}
+
+static const char *
+expect_ident(void)
+{
+	struct token t = get();
+
+	if (t.kind != TOK_IDENT)
+		perror_at("expected an identifier, found", t.str);
+	return (t.str);
+}
+
+static const char *
+expect_value(void)
+{
+	struct token t = get();
+
+	if (t.kind != TOK_IDENT && t.kind != TOK_NUMBER)
+		perror_at("expected a value, found", t.str);
+	return (t.str);
+}
+
+/*
+ * type-specifier, with unsigned forms made one word (u_int, u_hyper, ...)
+ */
+static void
+get_type(struct decl *dp)
+{
+	const char *word = expect_ident();
+
+	if (!strcmp(word, "struct") || !strcmp(word, "union")
+	 || !strcmp(word, "enum")) {
+		dp->prefix = word;
+		dp->type = expect_ident();
+		return;
+	}
+	if (!strcmp(word, "unsigned")) {
+		if (peek_word("int") || peek_word("long") || peek_word("hyper")
+		 || peek_word("short") || peek_word("char")) {
+			char buf[32];
+
+			snprintf(buf, sizeof(buf), "u_%s", expect_ident());
+			dp->type = xstrdup(buf);
+		} else {
+			dp->type = "u_int";
+		}
+		return;
+	}
+	dp->type = word;
+}
+
+/*
+ * declaration:
+ *	type-specifier identifier
+ *	type-specifier identifier "[" value "]"
+ *	type-specifier identifier "<" [ value ] ">"
+ *	"opaque" identifier "[" value "]"
+ *	"opaque" identifier "<" [ value ] ">"
+ *	"string" identifier "<" [ value ] ">"
+ *	type-specifier "*" identifier
+ *	"void"
+ */
+static struct decl *
+get_decl(bool allow_void)
+{
+	struct decl *dp = xzalloc(sizeof(*dp));
+
+	get_type(dp);
+	dp->rel = REL_ALIAS;
+
+	if (!strcmp(dp->type, "void")) {
+		if (!allow_void)
+			perror_at("void is only allowed in a union arm", NULL);
+		return (dp);
+	}
+	if (accept_punct('*')) {
+		dp->rel = REL_POINTER;
+		dp->name = expect_ident();
+	} else {
+		dp->name = expect_ident();
+		if (accept_punct('[')) {
+			dp->rel = REL_VECTOR;
+			dp->bound = expect_value();
+			expect_punct(']');
+		} else if (accept_punct('<')) {
+			dp->rel = REL_ARRAY;
+			if (!peek_punct('>'))
+				dp->bound = expect_value();
+			expect_punct('>');
+		}
+	}
+
+	if (!strcmp(dp->type, "string") && dp->rel != REL_ARRAY)
+		perror_at("string must be counted: string", dp->name);
+	if (!strcmp(dp->type, "opaque")
+	 && dp->rel != REL_VECTOR && dp->rel != REL_ARRAY)
+		perror_at("opaque must be a vector or array:", dp->name);
+	return (dp);
+}
+
+static void
+def_const(struct definition *defp)
+{
+	defp->kind = DEF_CONST;
+	defp->name = expect_ident();
+	expect_punct('=');
+	defp->def.value = expect_value();
+	expect_punct(';');
+}
+
+static void
+def_enum(struct definition *defp)
+{
+	struct enumval **tail = &defp->def.vals;
+	struct enumval *ev;
+
+	defp->kind = DEF_ENUM;
+	defp->name = expect_ident();
+	expect_punct('{');
+	do {
+		ev = xzalloc(sizeof(*ev));
+		ev->name = expect_ident();
+		if (accept_punct('='))
+			ev->value = expect_value();
+		*tail = ev;
+		tail = &ev->next;
+	} while (accept_punct(','));
+	expect_punct('}');
+	expect_punct(';');
+}
+
+static void
+def_struct(struct definition *defp)
+{
+	struct decl **tail = &defp->def.fields;
+
+	defp->kind = DEF_STRUCT;
+	defp->name = expect_ident();
+	expect_punct('{');
+	do {
+		*tail = get_decl(false);
+		tail = &(*tail)->next;
+		expect_punct(';');
+	} while (!peek_punct('}'));
+	expect_punct('}');
+	expect_punct(';');
+}
+
+static void
+def_union(struct definition *defp)
+{
+	struct arm **tail = &defp->def.un.arms;
+	struct caseval **vtail;
+	struct arm *ap;
+
+	defp->kind = DEF_UNION;
+	defp->name = expect_ident();
+	if (strcmp(expect_ident(), "switch"))
+		perror_at("expected switch in union", defp->name);
+	expect_punct('(');
+	defp->def.un.disc = get_decl(false);
+	expect_punct(')');
+	expect_punct('{');
+
+	while (peek_word("case")) {
+		ap = xzalloc(sizeof(*ap));
+		vtail = &ap->values;
+		while (peek_word("case")) {
+			get();
+			*vtail = xzalloc(sizeof(**vtail));
+			(*vtail)->value = expect_value();
+			vtail = &(*vtail)->next;
+			expect_punct(':');
+		}
+		ap->decl = get_decl(true);
+		expect_punct(';');
+		*tail = ap;
+		tail = &ap->next;
+	}
+	if (!defp->def.un.arms)
+		perror_at("union without cases:", defp->name);
+	if (peek_word("default")) {
+		get();
+		expect_punct(':');
+		defp->def.un.dflt = get_decl(true);
+		expect_punct(';');
+	}
+	expect_punct('}');
+	expect_punct(';');
+}
+
+static void
+def_typedef(struct definition *defp)
+{
+	defp->kind = DEF_TYPEDEF;
+	defp->def.decl = get_decl(false);
+	defp->name = defp->def.decl->name;
+	expect_punct(';');
+}
+
+/*
+ * Only the program, version and procedure numbers are used: the argument
+ * and result types are read and dropped.
+ */
+static void
+def_program(struct definition *defp)
+{
+	struct version **vtail = &defp->def.prog.vers;
+	struct version *vp;
+	struct proc **ptail;
+	struct proc *pp;
+	struct decl scratch;
+
+	defp->kind = DEF_PROGRAM;
+	defp->name = expect_ident();
+	expect_punct('{');
+	do {
+		if (strcmp(expect_ident(), "version"))
+			perror_at("expected version in program", defp->name);
+		vp = xzalloc(sizeof(*vp));
+		vp->name = expect_ident();
+		ptail = &vp->procs;
+		expect_punct('{');
+		do {
+			pp = xzalloc(sizeof(*pp));
+			get_type(&scratch);
+			accept_punct('*');
+			pp->name = expect_ident();
+			expect_punct('(');
+			do {
+				get_type(&scratch);
+				accept_punct('*');
+			} while (accept_punct(','));
+			expect_punct(')');
+			expect_punct('=');
+			pp->num = expect_value();
+			expect_punct(';');
+			*ptail = pp;
+			ptail = &pp->next;
+		} while (!peek_punct('}'));
+		expect_punct('}');
+		expect_punct('=');
+		vp->num = expect_value();
+		expect_punct(';');
+		*vtail = vp;
+		vtail = &vp->next;
+	} while (!peek_punct('}'));
+	expect_punct('}');
+	expect_punct('=');
+	defp->def.prog.num = expect_value();
+	expect_punct(';');
+}
+
+struct definition *
+parse_file(const char *path, const char *define)
+{
+	struct definition *head = NULL;
+	struct definition **tail = &head;
+	struct definition *defp;
+	struct token *tp;
+	const char *word;
+	FILE *fin;
+	long len;
+
+	fin = fopen(path, "r");
+	if (!fin)
+		fatal("cannot open %s", path);
+	fseek(fin, 0, SEEK_END);
+	len = ftell(fin);
+	fseek(fin, 0, SEEK_SET);
+	scan.text = xzalloc(len + 1);
+	if (fread(scan.text, 1, len, fin) != (size_t)len)
+		fatal("cannot read %s", path);
+	fclose(fin);
+
+	scan.path = path;
+	scan.define = define;
+	scan.p = scan.text;
+	scan.line = 1;
+	scan.bol = true;
+
+	for (;;) {
+		tp = peek();
+		if (tp->kind == TOK_EOF)
+			break;
+
+		defp = xzalloc(sizeof(*defp));
+		if (tp->kind == TOK_PASS) {
+			defp->kind = DEF_PASS;
+			defp->name = tp->str;
+			scan.have_peeked = false;
+		} else {
+			word = expect_ident();
+			if (!strcmp(word, "const"))
+				def_const(defp);
+			else if (!strcmp(word, "enum"))
+				def_enum(defp);
+			else if (!strcmp(word, "struct"))
+				def_struct(defp);
+			else if (!strcmp(word, "union"))
+				def_union(defp);
+			else if (!strcmp(word, "typedef"))
+				def_typedef(defp);
+			else if (!strcmp(word, "program"))
+				def_program(defp);
+			else
+				perror_at("expected a definition, found", word);
+		}
+		*tail = defp;
+		tail = &defp->next;
+	}
+	return (head);
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * rpc_util.c, type lookups shared by the ntirpcgen emitters.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rpc_gen.h"
+
+const char *prefix = "";
+struct definition *defined;
+
+/*
+ * Base types known without a definition, with their C type, the
+ * library's XDR routine, and their external size.
+ */
+static const struct prim {
+	const char *type;
+	const char *ctype;
+	const char *proc;
+	enum inline_kind kind;
+	long size;
+} prims[] = {
+	{ "int", "int", "xdr_int", INL_INT32, 4 },
+	{ "u_int", "u_int", "xdr_u_int", INL_UINT32, 4 },
+	{ "long", "long", "xdr_long", INL_LONG, 4 },
+	{ "u_long", "u_long", "xdr_u_long", INL_ULONG, 4 },
+	{ "short", "int16_t", "xdr_int16_t", INL_INT32, 4 },
+	{ "u_short", "uint16_t", "xdr_uint16_t", INL_UINT32, 4 },
+	{ "char", "int8_t", "xdr_int8_t", INL_INT32, 4 },
+	{ "u_char", "uint8_t", "xdr_uint8_t", INL_UINT32, 4 },
+	{ "hyper", "int64_t", "xdr_int64_t", INL_INT64, 8 },
+	{ "u_hyper", "uint64_t", "xdr_uint64_t", INL_UINT64, 8 },
+	{ "bool", "bool_t", "xdr_bool", INL_BOOL, 4 },
+	{ "float", "float", "xdr_float", INL_NONE, 4 },
+	{ "double", "double", "xdr_double", INL_NONE, 8 },
+	{ "int32_t", "int32_t", "xdr_int32_t", INL_INT32, 4 },
+	{ "uint32_t", "uint32_t", "xdr_uint32_t", INL_UINT32, 4 },
+	{ "u_int32_t", "u_int32_t", "xdr_u_int32_t", INL_UINT32, 4 },
+	{ "int64_t", "int64_t", "xdr_int64_t", INL_INT64, 8 },
+	{ "uint64_t", "uint64_t", "xdr_uint64_t", INL_UINT64, 8 },
+	{ "u_int64_t", "u_int64_t", "xdr_u_int64_t", INL_UINT64, 8 },
+	{ "rpcprog_t", "rpcprog_t", "xdr_rpcprog", INL_UINT32, 4 },
+	{ "rpcvers_t", "rpcvers_t", "xdr_rpcvers", INL_UINT32, 4 },
+	{ "rpcproc_t", "rpcproc_t", "xdr_rpcproc", INL_UINT32, 4 },
+	{ "rpcprot_t", "rpcprot_t", "xdr_rpcprot", INL_UINT32, 4 },
+	{ "rpcport_t", "rpcport_t", "xdr_rpcport", INL_UINT32, 4 },
+	{ "opaque", "char", NULL, INL_NONE, -1 },
+	{ "string", "char *", NULL, INL_NONE, -1 },
+	{ NULL, NULL, NULL, INL_NONE, -1 },
+};
+
+static const struct prim *
+find_prim(const char *type)
+{
+	const struct prim *pp;
+
+	for (pp = prims; pp->type; pp++)
+		if (!strcmp(pp->type, type))
+			return (pp);
+	return (NULL);
+}
+
+void *
+xzalloc(size_t size)
+{
+	void *p = calloc(1, size);
+
+	if (!p)
+		fatal("out of memory");
+	return (p);
+}
+
+char *
+xstrdup(const char *s)
+{
+	char *p = strdup(s);
+
+	if (!p)
+		fatal("out of memory");
+	return (p);
+}
+
+void
+fatal(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	fprintf(stderr, "ntirpcgen: ");
+	vfprintf(stderr, fmt, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+	exit(1);
+}
+
+/*
+ * A type (or constant) defined in this file.
+ */
+struct definition *
+find_def(const char *name)
+{
+	struct definition *defp;
+
+	for (defp = defined; defp; defp = defp->next)
+		if (defp->kind != DEF_PASS && defp->kind != DEF_PROGRAM
+		 && !strcmp(defp->name, name))
+			return (defp);
+	return (NULL);
+}
+
+/*
+ * Numbers, constants and enumerators known to this file.
+ */
+bool
+resolve_value(const char *value, long *result)
+{
+	struct definition *defp;
+	struct enumval *ev;
+	char *end;
+	long n;
+
+	n = strtol(value, &end, 0);
+	if (end != value && !*end) {
+		*result = n;
+		return (true);
+	}
+
+	for (defp = defined; defp; defp = defp->next) {
+		if (defp->kind == DEF_CONST && !strcmp(defp->name, value))
+			return (resolve_value(defp->def.value, result));
+		if (defp->kind != DEF_ENUM)
+			continue;
+		for (n = 0, ev = defp->def.vals; ev; ev = ev->next, n++) {
+			if (ev->value && !resolve_value(ev->value, &n))
+				break;
+			if (!strcmp(ev->name, value)) {
+				*result = n;
+				return (true);
+			}
+		}
+	}
+	return (false);
+}
+
+const char *
+c_type(const struct decl *dp)
+{
+	const struct prim *pp;
+	char buf[256];
+
+	if (dp->prefix) {
+		snprintf(buf, sizeof(buf), "%s %s", dp->prefix, dp->type);
+		return (xstrdup(buf));
+	}
+	pp = find_prim(dp->type);
+	return (pp ? pp->ctype : dp->type);
+}
+
+void
+xdr_proc(char *buf, size_t len, const char *type)
+{
+	const struct prim *pp = find_prim(type);
+
+	if (pp && pp->proc)
+		snprintf(buf, len, "%s", pp->proc);
+	else if (find_def(type))
+		snprintf(buf, len, "%sxdr_%s", prefix, type);
+	else
+		snprintf(buf, len, "xdr_%s", type);
+}
+
+void
+size_proc(char *buf, size_t len, const char *type)
+{
+	if (find_def(type))
+		snprintf(buf, len, "%sxdr_sizeof_%s", prefix, type);
+	else
+		snprintf(buf, len, "xdr_sizeof_%s", type);
+}
+
+/*
+ * Vector typedefs are passed as arrays (decayed to pointers), as rpcgen
+ * has always done; all other types by pointer.
+ */
+bool
+vector_param(const char *type)
+{
+	struct definition *defp = find_def(type);
+
+	return (defp && defp->kind == DEF_TYPEDEF
+		&& defp->def.decl->rel == REL_VECTOR);
+}
+
+enum inline_kind
+inline_type(const char *type)
+{
+	const struct prim *pp = find_prim(type);
+	struct definition *defp;
+
+	if (pp)
+		return (pp->kind);
+	defp = find_def(type);
+	if (!defp)
+		return (INL_NONE);
+	if (defp->kind == DEF_ENUM)
+		return (INL_ENUM);
+	if (defp->kind == DEF_TYPEDEF && defp->def.decl->rel == REL_ALIAS
+	 && !defp->def.decl->prefix)
+		return (inline_type(defp->def.decl->type));
+	return (INL_NONE);
+}
+
+long
+fixed_type_size(const char *type)
+{
+	const struct prim *pp = find_prim(type);
+	struct definition *defp;
+	struct decl *dp;
+	long size;
+	long total;
+
+	if (pp)
+		return (pp->size);
+	defp = find_def(type);
+	if (!defp)
+		return (-1);
+
+	switch (defp->kind) {
+	case DEF_ENUM:
+		return (4);
+	case DEF_TYPEDEF:
+		return (fixed_size(defp->def.decl));
+	case DEF_STRUCT:
+		total = 0;
+		for (dp = defp->def.fields; dp; dp = dp->next) {
+			size = fixed_size(dp);
+			if (size < 0)
+				return (-1);
+			total += size;
+		}
+		return (total);
+	default:
+		return (-1);
+	}
+}
+
+/*
+ * The external size of a declaration, when it does not depend on the
+ * data; else -1.
+ */
+long
+fixed_size(const struct decl *dp)
+{
+	long n;
+	long size;
+
+	if (!strcmp(dp->type, "void"))
+		return (0);
+
+	switch (dp->rel) {
+	case REL_ALIAS:
+		return (fixed_type_size(dp->type));
+	case REL_VECTOR:
+		if (!resolve_value(dp->bound, &n))
+			return (-1);
+		if (!strcmp(dp->type, "opaque"))
+			return ((n + 3) & ~3L);
+		size = fixed_type_size(dp->type);
+		return (size < 0 ? -1 : n * size);
+	default:
+		return (-1);
+	}
+}
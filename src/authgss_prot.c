@@ -1009,6 +1009,8 @@ xdr_rpc_gss_unwrap(XDR *xdrs, xdrproc_t xdr_func, void *xdr_ptr,
 			/* We need to create an xdrmem from the DATA buffer */
 			xdrmem_create(&tmpxdrs, gss_iov[1].buffer.value,
 				      gss_iov[1].buffer.length, XDR_DECODE);
+			tmpxdrs.x_flags |= xdrs->x_flags & XDR_FLAG_ARENA;
+			tmpxdrs.x_arena = xdrs->x_arena;
 			usexdrs = &tmpxdrs;
 		}
 	}
@@ -0,0 +1,526 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file clnt_cache.c
+ * @brief Shared client handle cache
+ *
+ * @section DESCRIPTION
+ *
+ * Entries are hashed by (host, program, version, nettype), and kept in
+ * least recently used order.  Each holds one reference on its CLIENT;
+ * the handle is idle when that is the only one.  All under cc_mtx:
+ * references are only taken there, so an idle handle stays idle.
+ *
+ * Connecting is done without the lock: by the first caller, or by a
+ * work pool task replacing a lost connection.  Meanwhile, other callers
+ * wait on cc_cv for it.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/city.h>
+#include <misc/portable.h>
+#include <misc/queue.h>
+#include <misc/timespec.h>
+#include <rpc/rpc.h>
+#include <rpc/svc.h>
+#include <rpc/work_pool.h>
+
+#include "rpc_com.h"
+#include "clnt_internal.h"
+
+#define CLNT_CACHE_BUCKETS	64	/* power of 2 */
+#define CLNT_CACHE_MAX		64
+#define CLNT_CACHE_IDLE_SEC	300
+#define CLNT_CACHE_WAIT_SEC	25	/* for a connection, by default */
+
+#define CE_FLAG_NONE		0x0000
+#define CE_FLAG_CONNECTING	0x0001
+
+struct clnt_cache_entry {
+	struct work_pool_entry ce_wpe;	/* reconnect task */
+	TAILQ_ENTRY(clnt_cache_entry) ce_hq;
+	TAILQ_ENTRY(clnt_cache_entry) ce_lru;
+	CLIENT *ce_clnt;		/* referenced, or NULL */
+	struct rpc_err ce_error;	/* of the last connect */
+	struct timeval ce_timeout;	/* for connecting */
+	char *ce_host;
+	char *ce_nettype;		/* or NULL */
+	rpcprog_t ce_prog;
+	rpcvers_t ce_vers;
+	uint64_t ce_hash;
+	int32_t ce_used_s;		/* last returned (monotonic) */
+	uint32_t ce_waiters;		/* for a connect */
+	uint16_t ce_flags;
+};
+
+TAILQ_HEAD(clnt_cache_head, clnt_cache_entry);
+
+static struct {
+	mutex_t cc_mtx;
+	cond_t cc_cv;			/* connects completed */
+	struct clnt_cache_head cc_lru;	/* most recent first */
+	struct clnt_cache_head cc_t[CLNT_CACHE_BUCKETS];
+	struct rpc_clnt_cache cc_stat;
+	bool cc_initialized;
+} clnt_cache = {
+	.cc_mtx = MUTEX_INITIALIZER,
+	.cc_cv = PTHREAD_COND_INITIALIZER,
+	.cc_stat = {
+		.max_clients = CLNT_CACHE_MAX,
+		.idle_sec = CLNT_CACHE_IDLE_SEC,
+	},
+};
+
+/*
+ * Called with cc_mtx held.
+ */
+static inline void
+clnt_cache_init(void)
+{
+	int i;
+
+	if (likely(clnt_cache.cc_initialized))
+		return;
+
+	TAILQ_INIT(&clnt_cache.cc_lru);
+	for (i = 0; i < CLNT_CACHE_BUCKETS; i++)
+		TAILQ_INIT(&clnt_cache.cc_t[i]);
+	clnt_cache.cc_initialized = true;
+}
+
+static inline int32_t
+clnt_cache_now(void)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &ts);
+	return (ts.tv_sec);
+}
+
+static inline uint64_t
+clnt_cache_hash(const char *host, rpcprog_t prog, rpcvers_t vers,
+		const char *nettype)
+{
+	uint64_t hk = CityHash64WithSeed(host, strlen(host),
+					 ((uint64_t)prog << 32) | vers);
+
+	if (nettype)
+		hk = CityHash64WithSeed(nettype, strlen(nettype), hk);
+	return (hk);
+}
+
+/*
+ * A handle not to be returned: destroyed, or its connection lost.  A
+ * multi-connection handle replaces its own connections.
+ */
+static bool
+clnt_cache_dead(CLIENT *clnt)
+{
+	struct rpc_dplx_rec *rec;
+
+	if (!clnt
+	 || (atomic_fetch_uint16_t(&clnt->cl_flags) & CLNT_FLAG_DESTROYED))
+		return (true);
+	if (clnt->cl_ops->cl_select)
+		return (false);
+
+	rec = CX_DATA(clnt)->cx_rec;
+	return (!rec
+		|| (atomic_fetch_uint16_t(&rec->xprt.xp_flags)
+		    & SVC_XPRT_FLAG_DESTROYED));
+}
+
+static void
+clnt_cache_free(struct clnt_cache_entry *ce)
+{
+	if (ce->ce_clnt)
+		CLNT_DESTROY(ce->ce_clnt);
+	mem_free(ce->ce_host, strlen(ce->ce_host) + 1);
+	if (ce->ce_nettype)
+		mem_free(ce->ce_nettype, strlen(ce->ce_nettype) + 1);
+	mem_free(ce, sizeof(*ce));
+}
+
+/*
+ * Called with cc_mtx held.  Neither connecting, awaited, nor in use.
+ */
+static inline bool
+clnt_cache_idle(struct clnt_cache_entry *ce)
+{
+	return (!(ce->ce_flags & CE_FLAG_CONNECTING)
+		&& !ce->ce_waiters
+		&& (!ce->ce_clnt
+		    || atomic_fetch_int32_t(&ce->ce_clnt->cl_refcnt) <= 1));
+}
+
+/*
+ * Called with cc_mtx held.
+ */
+static inline void
+clnt_cache_victim(struct clnt_cache_head *victims,
+		  struct clnt_cache_entry *ce)
+{
+	TAILQ_REMOVE(&clnt_cache.cc_lru, ce, ce_lru);
+	TAILQ_REMOVE(&clnt_cache.cc_t[ce->ce_hash & (CLNT_CACHE_BUCKETS - 1)],
+		     ce, ce_hq);
+	TAILQ_INSERT_TAIL(victims, ce, ce_lru);
+	clnt_cache.cc_stat.clients--;
+	clnt_cache.cc_stat.evictions++;
+}
+
+/*
+ * Called with cc_mtx held.  Idle entries are moved to victims, while
+ * over the cache size or (all) past their idle time.
+ */
+static void
+clnt_cache_evict(struct clnt_cache_head *victims, int32_t now, bool all)
+{
+	struct clnt_cache_entry *ce;
+	struct clnt_cache_entry *prev;
+	struct rpc_clnt_cache *stat = &clnt_cache.cc_stat;
+
+	TAILQ_FOREACH_REVERSE_SAFE(ce, &clnt_cache.cc_lru, clnt_cache_head,
+				   ce_lru, prev) {
+		if (!all
+		 && stat->clients <= stat->max_clients
+		 && (!stat->idle_sec
+		     || now - ce->ce_used_s < (int32_t)stat->idle_sec))
+			break;	/* the rest were used since */
+
+		if (!clnt_cache_idle(ce))
+			continue;
+
+		clnt_cache_victim(victims, ce);
+	}
+}
+
+/*
+ * Called with cc_mtx held.  Unlike clnt_cache_evict(), walks every
+ * entry, so idle handles that lost their connection are dropped even
+ * when the LRU tail is still fresh.
+ */
+static void
+clnt_cache_evict_dead(struct clnt_cache_head *victims)
+{
+	struct clnt_cache_entry *ce;
+	struct clnt_cache_entry *next;
+
+	TAILQ_FOREACH_SAFE(ce, &clnt_cache.cc_lru, ce_lru, next) {
+		if (clnt_cache_idle(ce)
+		 && clnt_cache_dead(ce->ce_clnt))
+			clnt_cache_victim(victims, ce);
+	}
+}
+
+static void
+clnt_cache_evicted(struct clnt_cache_head *victims)
+{
+	struct clnt_cache_entry *ce;
+
+	while ((ce = TAILQ_FIRST(victims))) {
+		TAILQ_REMOVE(victims, ce, ce_lru);
+		__warnx(TIRPC_DEBUG_FLAG_CLNT,
+			"%s: %s prog %" PRIu32 " vers %" PRIu32 " evicted",
+			__func__, ce->ce_host, ce->ce_prog, ce->ce_vers);
+		clnt_cache_free(ce);
+	}
+}
+
+/*
+ * A connect finished (unlocked).  The new handle replaces any previous.
+ */
+static void
+clnt_cache_connected(struct clnt_cache_entry *ce, CLIENT *clnt)
+{
+	CLIENT *old = NULL;
+
+	if (CLNT_SUCCESS(clnt))
+		atomic_set_uint16_t_bits(&clnt->cl_flags, CLNT_FLAG_CACHED);
+
+	mutex_lock(&clnt_cache.cc_mtx);
+	if (CLNT_SUCCESS(clnt)) {
+		old = ce->ce_clnt;
+		ce->ce_clnt = clnt;
+		ce->ce_error.re_status = RPC_SUCCESS;
+		clnt = NULL;
+	} else {
+		ce->ce_error = clnt->cl_error;
+	}
+	ce->ce_flags &= ~CE_FLAG_CONNECTING;
+	cond_broadcast(&clnt_cache.cc_cv);
+	mutex_unlock(&clnt_cache.cc_mtx);
+
+	if (old)
+		CLNT_DESTROY(old);
+	if (clnt)
+		CLNT_DESTROY(clnt);
+}
+
+static void
+clnt_cache_connect_task(struct work_pool_entry *wpe)
+{
+	struct clnt_cache_entry *ce =
+		opr_containerof(wpe, struct clnt_cache_entry, ce_wpe);
+
+	clnt_cache_connected(ce, clnt_ncreate_timed(ce->ce_host, ce->ce_prog,
+						    ce->ce_vers,
+						    ce->ce_nettype,
+						    &ce->ce_timeout));
+}
+
+/*
+ * Called with cc_mtx held.
+ */
+static void
+clnt_cache_reconnect(struct clnt_cache_entry *ce)
+{
+	if (ce->ce_flags & CE_FLAG_CONNECTING)
+		return;
+
+	__warnx(TIRPC_DEBUG_FLAG_CLNT,
+		"%s: %s prog %" PRIu32 " vers %" PRIu32 " reconnecting",
+		__func__, ce->ce_host, ce->ce_prog, ce->ce_vers);
+
+	ce->ce_flags |= CE_FLAG_CONNECTING;
+	clnt_cache.cc_stat.reconnects++;
+	ce->ce_wpe.fun = clnt_cache_connect_task;
+	ce->ce_wpe.arg = NULL;
+	work_pool_submit(&svc_work_pool, &ce->ce_wpe);
+}
+
+CLIENT *
+clnt_cache_ncreate_timed(const char *host, const rpcprog_t prog,
+			 const rpcvers_t vers, const char *nettype,
+			 const struct timeval *tp)
+{
+	struct clnt_cache_head victims = TAILQ_HEAD_INITIALIZER(victims);
+	struct clnt_cache_head *bucket;
+	struct clnt_cache_entry *ce;
+	struct rpc_err err;
+	struct timespec ts;
+	CLIENT *clnt = NULL;
+	uint64_t hk = clnt_cache_hash(host, prog, vers, nettype);
+	int32_t now = clnt_cache_now();
+	bool create = false;
+
+	memset(&err, 0, sizeof(err));
+	mutex_lock(&clnt_cache.cc_mtx);
+	clnt_cache_init();
+	bucket = &clnt_cache.cc_t[hk & (CLNT_CACHE_BUCKETS - 1)];
+
+	TAILQ_FOREACH(ce, bucket, ce_hq) {
+		if (ce->ce_hash == hk
+		 && ce->ce_prog == prog
+		 && ce->ce_vers == vers
+		 && !strcmp(ce->ce_host, host)
+		 && (nettype ? (ce->ce_nettype
+				&& !strcmp(ce->ce_nettype, nettype))
+			     : !ce->ce_nettype))
+			break;
+	}
+
+	if (!ce) {
+		ce = mem_zalloc(sizeof(*ce));
+		ce->ce_host = mem_strdup(host);
+		ce->ce_nettype = nettype ? mem_strdup(nettype) : NULL;
+		ce->ce_prog = prog;
+		ce->ce_vers = vers;
+		ce->ce_hash = hk;
+		if (tp)
+			ce->ce_timeout = *tp;
+		else
+			ce->ce_timeout.tv_sec = CLNT_CACHE_WAIT_SEC;
+		ce->ce_flags = CE_FLAG_CONNECTING;
+		TAILQ_INSERT_HEAD(bucket, ce, ce_hq);
+		TAILQ_INSERT_HEAD(&clnt_cache.cc_lru, ce, ce_lru);
+		clnt_cache.cc_stat.clients++;
+		clnt_cache.cc_stat.misses++;
+		create = true;
+	} else {
+		if (!(ce->ce_flags & CE_FLAG_CONNECTING)
+		 && !clnt_cache_dead(ce->ce_clnt)) {
+			clnt = ce->ce_clnt;
+			CLNT_REF(clnt, CLNT_REF_FLAG_NONE);
+			clnt_cache.cc_stat.hits++;
+		} else {
+			clnt_cache_reconnect(ce);
+		}
+		TAILQ_REMOVE(&clnt_cache.cc_lru, ce, ce_lru);
+		TAILQ_INSERT_HEAD(&clnt_cache.cc_lru, ce, ce_lru);
+	}
+	ce->ce_used_s = now;
+
+	if (!clnt) {
+		/* held (not evicted) while unlocked */
+		ce->ce_waiters++;
+
+		if (create) {
+			mutex_unlock(&clnt_cache.cc_mtx);
+			clnt_cache_connected(ce, clnt_ncreate_timed(host, prog,
+								    vers,
+								    nettype,
+								    tp));
+			mutex_lock(&clnt_cache.cc_mtx);
+		}
+
+		/* a second more, for the connect to report its own error */
+		(void)clock_gettime(CLOCK_REALTIME_FAST, &ts);
+		ts.tv_sec += ce->ce_timeout.tv_sec + 1;
+		ts.tv_nsec += ce->ce_timeout.tv_usec * 1000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		while (ce->ce_flags & CE_FLAG_CONNECTING) {
+			if (cond_timedwait(&clnt_cache.cc_cv,
+					   &clnt_cache.cc_mtx, &ts)
+			    == ETIMEDOUT)
+				break;
+		}
+
+		if (ce->ce_flags & CE_FLAG_CONNECTING) {
+			err.re_status = RPC_TIMEDOUT;
+		} else if (!clnt_cache_dead(ce->ce_clnt)) {
+			clnt = ce->ce_clnt;
+			CLNT_REF(clnt, CLNT_REF_FLAG_NONE);
+		} else if (ce->ce_error.re_status != RPC_SUCCESS) {
+			err = ce->ce_error;
+		} else {
+			/* lost again */
+			err.re_status = RPC_SYSTEMERROR;
+			err.re_errno = ECONNRESET;
+		}
+		ce->ce_waiters--;
+	}
+
+	clnt_cache_evict(&victims, now, false);
+	mutex_unlock(&clnt_cache.cc_mtx);
+	clnt_cache_evicted(&victims);
+
+	if (!clnt) {
+		__warnx(TIRPC_DEBUG_FLAG_CLNT,
+			"%s: %s prog %" PRIu32 " vers %" PRIu32 " failed (%d)",
+			__func__, host, prog, vers, err.re_status);
+		clnt = clnt_raw_ncreate(prog, vers);
+		clnt->cl_error = err;
+	}
+	return (clnt);
+}
+
+/*
+ * Give back a handle from clnt_cache_ncreate_timed().  When its
+ * connection was lost, the next is made now (in background).
+ */
+void
+clnt_cache_release(CLIENT *clnt)
+{
+	struct clnt_cache_entry *ce;
+
+	if (!(atomic_fetch_uint16_t(&clnt->cl_flags) & CLNT_FLAG_CACHED)) {
+		/* failed, never cached */
+		CLNT_DESTROY(clnt);
+		return;
+	}
+
+	if (clnt_cache_dead(clnt)) {
+		mutex_lock(&clnt_cache.cc_mtx);
+		TAILQ_FOREACH(ce, &clnt_cache.cc_lru, ce_lru) {
+			if (ce->ce_clnt == clnt) {
+				clnt_cache_reconnect(ce);
+				break;
+			}
+		}
+		mutex_unlock(&clnt_cache.cc_mtx);
+	}
+	CLNT_RELEASE(clnt, CLNT_RELEASE_FLAG_NONE);
+}
+
+/*
+ * Evict every idle handle.
+ */
+void
+clnt_cache_flush(void)
+{
+	struct clnt_cache_head victims = TAILQ_HEAD_INITIALIZER(victims);
+
+	mutex_lock(&clnt_cache.cc_mtx);
+	clnt_cache_init();
+	clnt_cache_evict(&victims, clnt_cache_now(), true);
+	mutex_unlock(&clnt_cache.cc_mtx);
+	clnt_cache_evicted(&victims);
+}
+
+/*
+ * Periodic (svc_rqst idle processing).  Handles are otherwise only
+ * evicted as a side effect of a lookup or control call.
+ */
+void
+clnt_cache_gc_idle(void)
+{
+	struct clnt_cache_head victims = TAILQ_HEAD_INITIALIZER(victims);
+
+	mutex_lock(&clnt_cache.cc_mtx);
+	if (!clnt_cache.cc_initialized) {
+		mutex_unlock(&clnt_cache.cc_mtx);
+		return;
+	}
+	clnt_cache_evict_dead(&victims);
+	clnt_cache_evict(&victims, clnt_cache_now(), false);
+	mutex_unlock(&clnt_cache.cc_mtx);
+	clnt_cache_evicted(&victims);
+}
+
+bool
+clnt_cache_control(int what, struct rpc_clnt_cache *arg)
+{
+	struct clnt_cache_head victims = TAILQ_HEAD_INITIALIZER(victims);
+
+	mutex_lock(&clnt_cache.cc_mtx);
+	clnt_cache_init();
+	switch (what) {
+	case RPC_SVC_CLNT_CACHE_GET:
+		*arg = clnt_cache.cc_stat;
+		break;
+	case RPC_SVC_CLNT_CACHE_SET:
+		clnt_cache.cc_stat.max_clients = arg->max_clients;
+		clnt_cache.cc_stat.idle_sec = arg->idle_sec;
+		clnt_cache_evict(&victims, clnt_cache_now(), false);
+		break;
+	default:
+		mutex_unlock(&clnt_cache.cc_mtx);
+		return (false);
+	}
+	mutex_unlock(&clnt_cache.cc_mtx);
+	clnt_cache_evicted(&victims);
+	return (true);
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file clnt_cq.c
+ * @brief Client completion queues
+ *
+ * @section DESCRIPTION
+ *
+ * Completed calls are pushed by the receiving (or expiring) threads on
+ * an intrusive multi-producer, single-consumer queue (D. Vyukov): a push
+ * is one atomic exchange, and never fails or blocks.  The consumer side
+ * is serialized by cq_mtx, taken once per clnt_cq_poll() batch.
+ *
+ * A consumer finding the queue empty arms it; the next producer
+ * disarms it and wakes the consumer (and the eventfd).  Each checks the
+ * other's side after its own update, so a wakeup cannot be lost.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <errno.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/abstract_atomic.h>
+#include <misc/timespec.h>
+#include <rpc/rpc.h>
+#include "rpc_com.h"
+
+struct clnt_cq {
+	struct clnt_cq_entry *cq_head;	/* producers (last pushed) */
+	struct clnt_cq_entry *cq_tail;	/* consumer (next popped) */
+	struct clnt_cq_entry cq_stub;
+	mutex_t cq_mtx;			/* consumer side */
+	cond_t cq_cv;
+	uint32_t cq_armed;		/* consumer waiting */
+	int cq_fd;			/* eventfd, or -1 */
+};
+
+struct clnt_cq *
+clnt_cq_create(uint32_t flags)
+{
+	struct clnt_cq *cq = mem_zalloc(sizeof(struct clnt_cq));
+
+	cq->cq_head = &cq->cq_stub;
+	cq->cq_tail = &cq->cq_stub;
+	mutex_init(&cq->cq_mtx, NULL);
+	cond_init(&cq->cq_cv, 0, NULL);
+	cq->cq_armed = 1;
+	cq->cq_fd = -1;
+
+	if (flags & CLNT_CQ_FLAG_EVENTFD) {
+#if defined(__linux__)
+		cq->cq_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+		errno = ENOTSUP;
+#endif
+		if (cq->cq_fd < 0) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: eventfd failed (%d)",
+				__func__, errno);
+			clnt_cq_destroy(cq);
+			return (NULL);
+		}
+	}
+	return (cq);
+}
+
+/*
+ * No calls may be outstanding to the queue.
+ */
+void
+clnt_cq_destroy(struct clnt_cq *cq)
+{
+	if (cq->cq_fd >= 0)
+		(void)close(cq->cq_fd);
+	cond_destroy(&cq->cq_cv);
+	mutex_destroy(&cq->cq_mtx);
+	mem_free(cq, sizeof(struct clnt_cq));
+}
+
+int
+clnt_cq_fd(struct clnt_cq *cq)
+{
+	return (cq->cq_fd);
+}
+
+void
+clnt_cq_attach(struct clnt_req *cc, struct clnt_cq *cq)
+{
+	cc->cc_cq = cq;
+	cc->cc_process_cb = clnt_cq_complete;
+}
+
+static inline void
+clnt_cq_push(struct clnt_cq *cq, struct clnt_cq_entry *cqe)
+{
+	struct clnt_cq_entry *prev;
+
+	atomic_store_voidptr((void **)&cqe->cqe_next, NULL);
+	prev = atomic_exchange_voidptr((void **)&cq->cq_head, cqe);
+	atomic_store_voidptr((void **)&prev->cqe_next, cqe);
+}
+
+/*
+ * Called with cq_mtx held.  NULL when empty, or a push is in progress
+ * (its producer will wake the consumer when armed).
+ */
+static struct clnt_cq_entry *
+clnt_cq_pop(struct clnt_cq *cq)
+{
+	struct clnt_cq_entry *tail = cq->cq_tail;
+	struct clnt_cq_entry *next = atomic_fetch_voidptr(
+					(void **)&tail->cqe_next);
+
+	if (tail == &cq->cq_stub) {
+		if (!next)
+			return (NULL);
+		cq->cq_tail = next;
+		tail = next;
+		next = atomic_fetch_voidptr((void **)&next->cqe_next);
+	}
+	if (next) {
+		cq->cq_tail = next;
+		return (tail);
+	}
+	if (tail != atomic_fetch_voidptr((void **)&cq->cq_head))
+		return (NULL);
+
+	/* tail is the last: put the stub behind it */
+	clnt_cq_push(cq, &cq->cq_stub);
+	next = atomic_fetch_voidptr((void **)&tail->cqe_next);
+	if (next) {
+		cq->cq_tail = next;
+		return (tail);
+	}
+	return (NULL);
+}
+
+/*
+ * cc_process_cb of an attached call.  The reference of its caller
+ * passes to the queue (and clnt_cq_poll()).
+ */
+void
+clnt_cq_complete(struct clnt_req *cc)
+{
+	struct clnt_cq *cq = cc->cc_cq;
+	uint64_t one = 1;
+
+	clnt_cq_push(cq, &cc->cc_cqe);
+
+	if (!atomic_fetch_uint32_t(&cq->cq_armed)
+	 || !atomic_postclear_uint32_t_bits(&cq->cq_armed, 1))
+		return;
+
+	if (cq->cq_fd >= 0
+	 && write(cq->cq_fd, &one, sizeof(one)) != sizeof(one)) {
+		__warnx(TIRPC_DEBUG_FLAG_WARN,
+			"%s: eventfd %d write failed (%d)",
+			__func__, cq->cq_fd, errno);
+	}
+	mutex_lock(&cq->cq_mtx);
+	cond_signal(&cq->cq_cv);
+	mutex_unlock(&cq->cq_mtx);
+}
+
+/*
+ * Called with cq_mtx held.  Arms the queue when it is drained.
+ */
+static int
+clnt_cq_drain(struct clnt_cq *cq, struct clnt_req **ccv, int n)
+{
+	struct clnt_cq_entry *cqe;
+	uint64_t count;
+	int i = 0;
+
+	while (i < n && (cqe = clnt_cq_pop(cq)))
+		ccv[i++] = opr_containerof(cqe, struct clnt_req, cc_cqe);
+
+	if (i < n) {
+		atomic_store_uint32_t(&cq->cq_armed, 1);
+		if (cq->cq_fd >= 0)
+			(void)read(cq->cq_fd, &count, sizeof(count));
+
+		/* pushed before arming? */
+		while (i < n && (cqe = clnt_cq_pop(cq)))
+			ccv[i++] = opr_containerof(cqe, struct clnt_req,
+						   cc_cqe);
+	}
+	return (i);
+}
+
+/*
+ * Collect up to n completed calls, waiting up to timeout_ms (-1 without
+ * limit) while none has completed.
+ *
+ * @return the number of calls in ccv.
+ */
+int
+clnt_cq_poll(struct clnt_cq *cq, struct clnt_req **ccv, int n,
+	     int timeout_ms)
+{
+	struct timespec ts;
+	int i;
+
+	mutex_lock(&cq->cq_mtx);
+	i = clnt_cq_drain(cq, ccv, n);
+
+	if (!i && timeout_ms > 0) {
+		(void)clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += timeout_ms / 1000;
+		ts.tv_nsec += (timeout_ms % 1000) * 1000000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+	}
+	while (!i && timeout_ms) {
+		if (timeout_ms < 0)
+			cond_wait(&cq->cq_cv, &cq->cq_mtx);
+		else if (cond_timedwait(&cq->cq_cv, &cq->cq_mtx, &ts)
+			 == ETIMEDOUT)
+			timeout_ms = 0;
+		i = clnt_cq_drain(cq, ccv, n);
+	}
+	mutex_unlock(&cq->cq_mtx);
+
+	return (i);
+}
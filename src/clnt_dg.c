@@ -67,6 +67,7 @@ struct cu_data {
 	struct cx_data cu_cx;
 	struct sockaddr_storage cu_raddr;	/* remote address */
 	int cu_rlen;
+	bool cu_connected;	/* fd connected to cu_raddr */
 };
 #define CU_DATA(p) (opr_containerof((p), struct cu_data, cu_cx))
 
@@ -114,6 +115,7 @@ clnt_dg_ncreatef(const int fd,	/* open file descriptor */
 	struct svc_dg_xprt *su;
 	struct rpc_msg call_msg;
 	XDR cu_xdrs[1];		/* temp XDR stream */
+	bool sole = false;
 
 	clnt->cl_ops = clnt_dg_ops();
 
@@ -135,8 +137,11 @@ clnt_dg_ncreatef(const int fd,	/* open file descriptor */
 		return (clnt);
 	}
 
-	/* find or create shared fd state; ref+1 */
-	xprt = svc_dg_ncreatef(fd, sendsz, recvsz, flags);
+	/* find or create shared fd state; ref+1; registered below,
+	 * after the rendezvous callback is set.
+	 */
+	xprt = svc_dg_ncreatef(fd, sendsz, recvsz,
+			       flags | SVC_CREATE_FLAG_XPRT_NOREG);
 	if (!xprt) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s: fd %d svc_dg_ncreatef failed",
@@ -147,6 +152,7 @@ clnt_dg_ncreatef(const int fd,	/* open file descriptor */
 	su = su_data(xprt);
 
 	if (!su->su_dr.ev_p) {
+		sole = (flags & CLNT_CREATE_FLAG_CLOSE);
 		xprt->xp_dispatch.rendezvous_cb = clnt_dg_rendezvous;
 		svc_rqst_evchan_reg(__svc_params->ev_u.evchan.id, xprt,
 				    SVC_RQST_FLAG_CHAN_AFFINITY);
@@ -156,6 +162,21 @@ clnt_dg_ncreatef(const int fd,	/* open file descriptor */
 	(void)memcpy(&cu->cu_raddr, svcaddr->buf, (size_t) svcaddr->len);
 	cu->cu_rlen = svcaddr->len;
 
+	/*
+	 * When the library opened this fd for a single server, connect it.
+	 * The kernel then skips the per-datagram route lookup, and filters
+	 * out datagrams from other peers.
+	 */
+	if (sole && (flags & CLNT_CREATE_FLAG_CONNECT)) {
+		if (connect(fd, (struct sockaddr *)&cu->cu_raddr,
+			    cu->cu_rlen) < 0) {
+			__warnx(TIRPC_DEBUG_FLAG_WARN,
+				"%s: fd %d connect failed (%d), unconnected",
+				__func__, fd, errno);
+		} else
+			cu->cu_connected = true;
+	}
+
 	/*
 	 * initialize call message
 	 */
@@ -181,6 +202,8 @@ clnt_dg_ncreatef(const int fd,	/* open file descriptor */
 	cu->cu_cx.cx_mpos = XDR_GETPOS(cu_xdrs);
 	XDR_DESTROY(cu_xdrs);
 
+	clnt_rtt_init(&cu->cu_cx);
+
 	__warnx(TIRPC_DEBUG_FLAG_CLNT_DG,
 		"%s: fd %d completed",
 		__func__, fd);
@@ -205,69 +228,282 @@ clnt_dg_rendezvous(SVCXPRT *xprt)
 	return SVC_RECV(xprt);
 }
 
-static enum clnt_stat
-clnt_dg_call(struct clnt_req *cc)
+/*
+ * Point msg at the call's buffers.  Usually there is one, but a call
+ * larger than it, or with xdr_bulk() data by reference, has several.
+ *
+ * @return an iovec array to free, or NULL
+ */
+static struct iovec *
+clnt_dg_iov(XDR *xdrs, struct msghdr *msg, struct iovec *iov)
+{
+	u_int len = XDR_GETPOS(xdrs);
+	int count = XDR_IOVCOUNT(xdrs, 0, len);
+	struct xdr_vio *vio;
+	int i;
+
+	msg->msg_iov = iov;
+	msg->msg_iovlen = 1;
+	if (count <= 1) {
+		iov->iov_base = xdrs->x_v.vio_head;
+		iov->iov_len = len;
+		return (NULL);
+	}
+
+	vio = mem_alloc(count * sizeof(struct xdr_vio));
+	iov = mem_alloc(count * sizeof(struct iovec));
+	if (!XDR_FILLBUFS(xdrs, 0, vio, len)) {
+		/* sent empty, the call is left to retransmission */
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s() XDR_FILLBUFS failed", __func__);
+		count = 0;
+	}
+	for (i = 0; i < count; i++) {
+		iov[i].iov_base = vio[i].vio_head;
+		iov[i].iov_len = vio[i].vio_length;
+	}
+	mem_free(vio, 0);
+
+	msg->msg_iov = iov;
+	msg->msg_iovlen = count;
+	return (iov);
+}
+
+/*
+ * Drain the duplex record's writeq.  Calls stay queued until sent, so
+ * callers that arrive meanwhile append to the queue, and are sent in the
+ * next batch with a single sendmmsg(2).
+ *
+ * Returns the errno for the caller's own call (mine), or 0.
+ */
+static int
+clnt_dg_write(struct rpc_dplx_rec *rec, struct xdr_ioq *mine)
+{
+	struct mmsghdr msgs[SVC_DG_BATCH_MAX];
+	struct iovec iov[SVC_DG_BATCH_MAX];
+	struct iovec *iovv[SVC_DG_BATCH_MAX];
+	struct xdr_ioq *xioq[SVC_DG_BATCH_MAX];
+	struct poolq_entry *have;
+	CLIENT *clnt;
+	struct cu_data *cu;
+	XDR *xdrs;
+	int fd = rec->xprt.xp_fd;
+	int result = 0;
+	int i;
+	int n;
+	int rc;
+	int sent;
+
+	mutex_lock(&rec->writeq.qmutex);
+	have = TAILQ_FIRST(&rec->writeq.qh);
+
+	while (have) {
+		for (n = 0; have && n < SVC_DG_BATCH_MAX; n++) {
+			xioq[n] = _IOQ(have);
+			have = TAILQ_NEXT(have, q);
+		}
+		mutex_unlock(&rec->writeq.qmutex);
+
+		memset(msgs, 0, n * sizeof(struct mmsghdr));
+		for (i = 0; i < n; i++) {
+			xdrs = xioq[i]->xdrs;
+			cu = CU_DATA(CX_DATA((CLIENT *)xdrs->x_lib[0]));
+
+			iovv[i] = clnt_dg_iov(xdrs, &msgs[i].msg_hdr, &iov[i]);
+			if (!cu->cu_connected) {
+				msgs[i].msg_hdr.msg_name = &cu->cu_raddr;
+				msgs[i].msg_hdr.msg_namelen = cu->cu_rlen;
+			}
+		}
+
+		for (sent = 0; sent < n;) {
+			rc = sendmmsg(fd, &msgs[sent], n - sent, 0);
+			if (rc > 0) {
+				sent += rc;
+				continue;
+			}
+			if (rc < 0 && errno == EINTR)
+				continue;
+
+			/* skip the failed datagram, left to retransmission */
+			if (xioq[sent] == mine)
+				result = rc < 0 ? errno : EIO;
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: fd %d sendmmsg failed (%d)",
+				__func__, fd, rc < 0 ? errno : EIO);
+			sent++;
+		}
+		__warnx(TIRPC_DEBUG_FLAG_CLNT_DG,
+			"%s: fd %d sent %d calls",
+			__func__, fd, n);
+
+		mutex_lock(&rec->writeq.qmutex);
+		for (i = 0; i < n; i++) {
+			TAILQ_REMOVE(&rec->writeq.qh, &(xioq[i]->ioq_s), q);
+			(rec->writeq.qcount)--;
+		}
+		/* when empty, the next caller becomes the writer */
+		have = TAILQ_FIRST(&rec->writeq.qh);
+		mutex_unlock(&rec->writeq.qmutex);
+
+		for (i = 0; i < n; i++) {
+			if (iovv[i])
+				mem_free(iovv[i], 0);
+			clnt = xioq[i]->xdrs[0].x_lib[0];
+			XDR_DESTROY(xioq[i]->xdrs);
+			CLNT_RELEASE(clnt, CLNT_RELEASE_FLAG_NONE);
+		}
+
+		if (have)
+			mutex_lock(&rec->writeq.qmutex);
+	}
+
+	return (result);
+}
+
+/*
+ * Encode a call, ready to queue on its transport.
+ * Each queued call holds its CLIENT until sent.
+ */
+static struct xdr_ioq *
+clnt_dg_encode(struct clnt_req *cc)
 {
 	CLIENT *clnt = cc->cc_clnt;
 	struct cx_data *cx = CX_DATA(clnt);
-	struct cu_data *cu = CU_DATA(cx);
 	struct rpc_dplx_rec *rec = cx->cx_rec;
 	SVCXPRT *xprt = &rec->xprt;
 	struct xdr_ioq *xioq;
 	XDR *xdrs;
-	u_int32_t *uint32p;
-	size_t outlen;
+	bool gss;
+	u_int max = __svc_params->ioq.send_max + RPC_MAXDATA_DEFAULT;
 
 	/* XXX Until gss_get_mic and gss_wrap can be replaced with
 	 * iov equivalents, replies with RPCSEC_GSS security must be
-	 * encoded in a contiguous buffer.
+	 * encoded in a contiguous buffer, sized beforehand rather
+	 * than reallocated and copied.
 	 *
 	 * Nb, we should probably use getpagesize() on Unix.  Need
 	 * an equivalent for Windows.
 	 */
-	xioq = xdr_ioq_create(RPC_MAXDATA_DEFAULT,
-			      __svc_params->ioq.send_max + RPC_MAXDATA_DEFAULT,
-			      (cc->cc_auth->ah_cred.oa_flavor == RPCSEC_GSS)
-			      ? UIO_FLAG_REALLOC | UIO_FLAG_FREE
-			      : UIO_FLAG_FREE);
+	gss = (cc->cc_auth->ah_cred.oa_flavor == RPCSEC_GSS);
+	xioq = gss
+		? xdr_ioq_create(clnt_req_size(cx, cc, max), max,
+				 UIO_FLAG_REALLOC | UIO_FLAG_FREE)
+		: xdr_ioq_create(RPC_MAXDATA_DEFAULT, max, UIO_FLAG_FREE);
 
 	xdrs = xioq->xdrs;
-	cc->cc_error.re_status = RPC_SUCCESS;
 
-	mutex_lock(&clnt->cl_lock);
-	uint32p = (u_int32_t *)&cx->cx_mcallc[0];
-	*uint32p = htonl(cc->cc_xid);
+	/* RPCSEC_GSS updates its AUTH while marshalling */
+	if (gss)
+		mutex_lock(&clnt->cl_lock);
 
-	if ((!XDR_PUTBYTES(xdrs, cx->cx_mcallc, cx->cx_mpos))
-	    || (!XDR_PUTUINT32(xdrs, cc->cc_proc))
+	if ((!clnt_req_marshal_hdr(cx, cc, xdrs))
 	    || (!AUTH_MARSHALL(cc->cc_auth, xdrs))
 	    || (!AUTH_WRAP(cc->cc_auth, xdrs,
 			   cc->cc_call.proc, cc->cc_call.where))) {
 		/* error case */
-		mutex_unlock(&clnt->cl_lock);
+		if (gss)
+			mutex_unlock(&clnt->cl_lock);
 		__warnx(TIRPC_DEBUG_FLAG_CLNT_DG,
 			"%s: fd %d failed",
 			__func__, xprt->xp_fd);
 		XDR_DESTROY(xdrs);
-		return (RPC_CANTENCODEARGS);
+		return (NULL);
 	}
-	outlen = (size_t) XDR_GETPOS(xdrs);
-	mutex_unlock(&clnt->cl_lock);
+	if (gss)
+		mutex_unlock(&clnt->cl_lock);
+	clnt_window_charge(cx, cc, XDR_GETPOS(xdrs));
 
-	if (sendto(xprt->xp_fd, xdrs->x_v.vio_head, outlen, 0,
-		   (struct sockaddr *)&cu->cu_raddr, cu->cu_rlen) != outlen) {
-		clnt->cl_error.re_errno = errno;
-		__warnx(TIRPC_DEBUG_FLAG_ERROR,
-			"%s: fd %d sendto failed (%d)\n",
-			__func__, xprt->xp_fd, clnt->cl_error.re_errno);
-		XDR_DESTROY(xdrs);
+	(void)clock_gettime(CLOCK_MONOTONIC, &cc->cc_sent);
+
+	CLNT_REF(clnt, CLNT_REF_FLAG_NONE);
+	xdrs->x_lib[0] = clnt;
+	return (xioq);
+}
+
+/*
+ * Queue encoded calls in order.
+ *
+ * @return true when the caller has become the writer.
+ */
+static inline bool
+clnt_dg_enqueue(struct rpc_dplx_rec *rec, struct xdr_ioq **xioqv, int n)
+{
+	bool was_empty;
+	int i;
+
+	mutex_lock(&rec->writeq.qmutex);
+
+	was_empty = TAILQ_FIRST(&rec->writeq.qh) == NULL;
+
+	/* always queue output requests on the duplex record's writeq */
+	for (i = 0; i < n; i++)
+		TAILQ_INSERT_TAIL(&rec->writeq.qh, &(xioqv[i]->ioq_s), q);
+	rec->writeq.qcount += n;
+
+	mutex_unlock(&rec->writeq.qmutex);
+
+	/* otherwise, the current writer will send these with its batch;
+	 * any loss is recovered by the normal retransmission.
+	 */
+	return (was_empty && n);
+}
+
+static enum clnt_stat
+clnt_dg_call(struct clnt_req *cc)
+{
+	CLIENT *clnt = cc->cc_clnt;
+	struct rpc_dplx_rec *rec = CX_DATA(clnt)->cx_rec;
+	struct xdr_ioq *xioq;
+	int error;
+
+	cc->cc_error.re_status = RPC_SUCCESS;
+
+	xioq = clnt_dg_encode(cc);
+	if (!xioq)
+		return (RPC_CANTENCODEARGS);
+
+	if (!clnt_dg_enqueue(rec, &xioq, 1))
+		return (RPC_SUCCESS);
+
+	error = clnt_dg_write(rec, xioq);
+	if (error) {
+		clnt->cl_error.re_errno = error;
 		return (RPC_CANTSEND);
 	}
-	XDR_DESTROY(xdrs);
-
 	return (RPC_SUCCESS);
 }
 
+/*
+ * All on the same CLIENT.  Send failures are left to retransmission.
+ */
+static enum clnt_stat
+clnt_dg_call_batch(struct clnt_req **ccv, int count)
+{
+	struct xdr_ioq *xioqv[CLNT_BATCH_MAX];
+	struct rpc_dplx_rec *rec = CX_DATA(ccv[0]->cc_clnt)->cx_rec;
+	enum clnt_stat stat = RPC_SUCCESS;
+	int i;
+	int n;
+
+	while (count > 0) {
+		for (i = 0, n = 0; i < count && i < CLNT_BATCH_MAX; i++) {
+			xioqv[n] = clnt_dg_encode(ccv[i]);
+			if (!xioqv[n]) {
+				ccv[i]->cc_error.re_status = RPC_CANTENCODEARGS;
+				stat = RPC_CANTENCODEARGS;
+				continue;
+			}
+			n++;
+		}
+		if (clnt_dg_enqueue(rec, xioqv, n))
+			(void)clnt_dg_write(rec, NULL);
+		ccv += i;
+		count -= i;
+	}
+	return (stat);
+}
+
 static bool
 clnt_dg_freeres(CLIENT *clnt, xdrproc_t xdr_res, void *res_ptr)
 {
@@ -337,23 +573,34 @@ clnt_dg_control(CLIENT *clnt, u_int request, void *info)
 			break;
 
 		}
+		if (cu->cu_connected
+		    && connect(rec->xprt.xp_fd, (struct sockaddr *)addr->buf,
+			       addr->len) < 0) {
+			rslt = false;
+			break;
+		}
 		(void)memcpy(&cu->cu_raddr, addr->buf, addr->len);
 		cu->cu_rlen = addr->len;
 		break;
 
+	case CLGET_RTT_STATS:
+		clnt_rtt_stats(cx, (struct clnt_rtt_stats *)info);
+		break;
+
+	case CLSET_WINDOW:
+	case CLGET_WINDOW:
+		rslt = clnt_window_control(cx, request, info);
+		break;
+
 	case CLGET_XID:
-		/*
-		 * use the knowledge that xid is the
-		 * first element in the call structure *.
-		 * This will get the xid of the PREVIOUS call
-		 */
-		uint32p = (u_int32_t *)&cx->cx_mcallc[0];
-		*(u_int32_t *)info = ntohl(*uint32p);
+		/* the xid of the PREVIOUS call on this channel */
+		*(u_int32_t *)info = atomic_fetch_uint32_t(&rec->call_xid);
 		break;
 
 	case CLSET_XID:
 		/* This will set the xid of the NEXT call */
-		rec->call_xid = htonl(*(u_int32_t *) info - 1);
+		atomic_store_uint32_t(&rec->call_xid,
+				      *(u_int32_t *)info - 1);
 		/* decrement by 1 as clnt_req_setup() increments once */
 		break;
 
@@ -428,6 +675,7 @@ clnt_dg_ops(void)
 		ops.cl_freeres = clnt_dg_freeres;
 		ops.cl_destroy = clnt_dg_destroy;
 		ops.cl_control = clnt_dg_control;
+		ops.cl_call_batch = clnt_dg_call_batch;
 	}
 	mutex_unlock(&ops_lock);
 	thr_sigsetmask(SIG_SETMASK, &mask, NULL);
@@ -46,8 +46,14 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
 #include "rpc_com.h"
 #include "clnt_internal.h"
+#include "svc_internal.h"
 
 int __rpc_raise_fd(int);
 
@@ -447,23 +453,689 @@ clnt_req_xid_cmpf(const struct opr_rbtree_node *lhs,
 	return (1);
 }
 
+/*
+ * Outstanding calls by xid, partitioned (xid modulo RPC_DPLX_CALL_PARTS)
+ * so that concurrent calls rarely share a spinlock.  Allocated on the
+ * first call of any client sharing the rec.
+ */
+static void
+clnt_req_xid_init(struct rpc_dplx_rec *rec)
+{
+	struct rbtree_x xt;
+
+	rpc_dplx_rli(rec);
+	if (!rec->call_replies.tree) {
+		(void)rbtx_init(&xt, clnt_req_xid_cmpf, RPC_DPLX_CALL_PARTS,
+				RBT_X_FLAG_ALLOC);
+		rec->call_replies.npart = xt.npart;
+		rec->call_replies.flags = xt.flags;
+		atomic_store_voidptr((void **)&rec->call_replies.tree,
+				     xt.tree);
+	}
+	rpc_dplx_rui(rec);
+}
+
+static inline bool
+clnt_req_xid_insert(struct rpc_dplx_rec *rec, struct clnt_req *cc)
+{
+	struct rbtree_x_part *t =
+		rbtx_partition_of_scalar(&rec->call_replies, cc->cc_xid);
+	struct opr_rbtree_node *nv;
+
+	pthread_spin_lock(&t->sp);
+	nv = opr_rbtree_insert(&t->t, &cc->cc_dplx);
+	pthread_spin_unlock(&t->sp);
+
+	if (nv) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: %p fd %d insert failed xid %" PRIu32,
+			__func__, &rec->xprt, rec->xprt.xp_fd, cc->cc_xid);
+		cc->cc_error.re_status = RPC_TLIERROR;
+		return (false);
+	}
+	return (true);
+}
+
+static inline void
+clnt_req_xid_remove(struct rpc_dplx_rec *rec, struct clnt_req *cc)
+{
+	struct rbtree_x_part *t =
+		rbtx_partition_of_scalar(&rec->call_replies, cc->cc_xid);
+
+	pthread_spin_lock(&t->sp);
+	opr_rbtree_remove(&t->t, &cc->cc_dplx);
+	pthread_spin_unlock(&t->sp);
+}
+
+/*
+ * Round trip estimation for datagram clients, per RFC 6298: smoothed
+ * RTT and its variation from replies to calls sent once (Karn), and an
+ * exponential backoff of the retransmit timeout until the next sample.
+ */
+void
+clnt_rtt_init(struct cx_data *cx)
+{
+	memset(&cx->cx_rtt, 0, sizeof(struct clnt_rtt));
+	cx->cx_rtt.cr_rto = CLNT_RTO_INIT_US;
+}
+
+void
+clnt_rtt_sample(struct clnt_req *cc)
+{
+	CLIENT *clnt = cc->cc_clnt;
+	struct clnt_rtt *rtt = &CX_DATA(clnt)->cx_rtt;
+	struct timespec ts;
+	int64_t delta;
+	int64_t r;
+	int i;
+
+	/* not coarse, LAN round trips are well under a tick */
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	timespecsub(&ts, &cc->cc_sent, &ts);
+	r = ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+	if (r < 0)
+		return;
+
+	for (i = 0; i < CLNT_RTT_HIST_MAX - 1 && (r >> i); i++)
+		;
+
+	mutex_lock(&clnt->cl_lock);
+	if (!rtt->cr_samples) {
+		rtt->cr_srtt = r;
+		rtt->cr_rttvar = r / 2;
+	} else {
+		delta = r - rtt->cr_srtt;
+		rtt->cr_rttvar += ((delta < 0 ? -delta : delta)
+				   - rtt->cr_rttvar) / 4;
+		rtt->cr_srtt += delta / 8;
+	}
+	r = rtt->cr_srtt + 4 * rtt->cr_rttvar;
+	if (r < CLNT_RTO_MIN_US)
+		r = CLNT_RTO_MIN_US;
+	if (r > CLNT_RTO_MAX_US)
+		r = CLNT_RTO_MAX_US;
+	rtt->cr_rto = r;
+	rtt->cr_backoff = 0;
+	rtt->cr_samples++;
+	rtt->cr_hist[i]++;
+	mutex_unlock(&clnt->cl_lock);
+}
+
+void
+clnt_rtt_backoff(struct cx_data *cx)
+{
+	mutex_lock(&cx->cx_c.cl_lock);
+	if (cx->cx_rtt.cr_backoff < CLNT_RTO_BACKOFF_MAX)
+		cx->cx_rtt.cr_backoff++;
+	cx->cx_rtt.cr_retrans++;
+	mutex_unlock(&cx->cx_c.cl_lock);
+}
+
+/*
+ * unlocked, racing updates only skew a single timeout
+ */
+int
+clnt_rtt_timeout_ms(struct cx_data *cx)
+{
+	int64_t rto = (int64_t)cx->cx_rtt.cr_rto << cx->cx_rtt.cr_backoff;
+
+	if (rto > CLNT_RTO_MAX_US)
+		rto = CLNT_RTO_MAX_US;
+	return (rto + 999) / 1000;
+}
+
+void
+clnt_rtt_stats(struct cx_data *cx, struct clnt_rtt_stats *rs)
+{
+	struct clnt_rtt *rtt = &cx->cx_rtt;
+
+	rs->rs_srtt_us = rtt->cr_srtt;
+	rs->rs_rttvar_us = rtt->cr_rttvar;
+	rs->rs_rto_us = rtt->cr_rto;
+	rs->rs_backoff = rtt->cr_backoff;
+	rs->rs_samples = rtt->cr_samples;
+	rs->rs_retrans = rtt->cr_retrans;
+	memcpy(rs->rs_hist, rtt->cr_hist, sizeof(rs->rs_hist));
+}
+
+/*
+ * Flow control.  Calls are admitted while below every limit, and no
+ * call is staged ahead of them.
+ */
+static inline bool
+clnt_window_room(struct clnt_win *w)
+{
+	return ((!w->cw.cw_calls || w->cw.cw_inflight < w->cw.cw_cwnd)
+		&& (!w->cw.cw_bytes
+		    || atomic_fetch_uint32_t(&w->cw.cw_inflight_bytes)
+		       < w->cw.cw_bytes));
+}
+
+static inline bool
+clnt_window_open(struct clnt_win *w)
+{
+	return (!w->cw_head && clnt_window_room(w));
+}
+
+/*
+ * Called with cw_mtx held.
+ */
+static void
+clnt_window_decrease(struct clnt_win *w)
+{
+	w->cw.cw_cwnd = MAX(w->cw.cw_cwnd / 2, 1);
+	w->cw_acked = 0;
+	/* those already sent may not reflect the decrease */
+	w->cw_cooldown = w->cw.cw_inflight;
+}
+
+/*
+ * Credit for a call, before it is first sent.  An async call (sent by
+ * CLNT_CALL_BACK()) may be staged, when cw_mode is CLNT_WINDOW_QUEUE;
+ * otherwise QUEUE waits like BLOCK.  With try, only an open window
+ * admits the call.
+ *
+ * @return 0 when admitted; EINPROGRESS when staged; else the error,
+ * also set in cc_error (unless tried).
+ */
+static int
+clnt_window_admit(struct clnt_req *cc, bool async, bool try)
+{
+	struct clnt_win *w = &CX_DATA(cc->cc_clnt)->cx_win;
+	struct timespec ts;
+	bool timed;
+	int code = 0;
+
+	if (!w->cw.cw_calls && !w->cw.cw_bytes)
+		return (0);
+
+	mutex_lock(&w->cw_mtx);
+	if (clnt_window_open(w))
+		goto admit;
+	if (try) {
+		mutex_unlock(&w->cw_mtx);
+		return (EAGAIN);
+	}
+	w->cw.cw_stalls++;
+
+	switch (w->cw.cw_mode) {
+	case CLNT_WINDOW_QUEUE:
+		if (async) {
+			if (w->cw.cw_staged >= w->cw.cw_stage) {
+				code = EAGAIN;
+				break;
+			}
+			cc->cc_cqe.cqe_next = NULL;
+			*w->cw_tailp = &cc->cc_cqe;
+			w->cw_tailp = &cc->cc_cqe.cqe_next;
+			w->cw.cw_staged++;
+			mutex_unlock(&w->cw_mtx);
+			return (EINPROGRESS);
+		}
+		/* fallthru */
+	case CLNT_WINDOW_BLOCK:
+		timed = cc->cc_timeout.tv_sec || cc->cc_timeout.tv_nsec;
+		if (timed) {
+			(void)clock_gettime(CLNT_WIN_CLOCK, &ts);
+			timespecadd(&ts, &cc->cc_timeout, &ts);
+		}
+		w->cw_waiters++;
+		while (!code && !clnt_window_open(w)) {
+			if (!timed)
+				cond_wait(&w->cw_cv, &w->cw_mtx);
+			else if (cond_timedwait(&w->cw_cv, &w->cw_mtx, &ts)
+				 == ETIMEDOUT)
+				code = ETIMEDOUT;
+		}
+		w->cw_waiters--;
+		if (clnt_window_open(w))
+			code = 0;
+		break;
+	default:
+		code = EAGAIN;
+		break;
+	}
+
+	if (code) {
+		mutex_unlock(&w->cw_mtx);
+		__warnx(TIRPC_DEBUG_FLAG_CLNT_REQ,
+			"%s: %p xid %" PRIu32 " window full (%d)",
+			__func__, cc->cc_clnt, cc->cc_xid, code);
+		if (code == ETIMEDOUT) {
+			cc->cc_error.re_status = RPC_TIMEDOUT;
+		} else {
+			cc->cc_error.re_status = RPC_SYSTEMERROR;
+			cc->cc_error.re_errno = code;
+		}
+		return (code);
+	}
+
+ admit:
+	w->cw.cw_inflight++;
+	atomic_set_uint16_t_bits(&cc->cc_flags, CLNT_REQ_FLAG_CREDIT);
+	mutex_unlock(&w->cw_mtx);
+
+	if (w->cw.cw_flags & CLNT_WINDOW_FLAG_ADAPT)
+		(void)clock_gettime(CLOCK_MONOTONIC, &cc->cc_sent);
+	return (0);
+}
+
+/*
+ * Charge the encoded size of a call holding credit, once.
+ */
+void
+clnt_window_charge(struct cx_data *cx, struct clnt_req *cc, u_int bytes)
+{
+	if (cc->cc_bytes
+	 || !(atomic_fetch_uint16_t(&cc->cc_flags) & CLNT_REQ_FLAG_CREDIT))
+		return;
+
+	cc->cc_bytes = bytes;
+	(void)atomic_add_uint32_t(&cx->cx_win.cw.cw_inflight_bytes, bytes);
+}
+
+/*
+ * Reply latency, for CLNT_WINDOW_FLAG_ADAPT.
+ */
+static void
+clnt_window_sample(struct clnt_req *cc)
+{
+	struct clnt_win *w = &CX_DATA(cc->cc_clnt)->cx_win;
+	struct timespec ts;
+	uint32_t target;
+	uint32_t us;
+
+	if (!(w->cw.cw_flags & CLNT_WINDOW_FLAG_ADAPT)
+	 || (atomic_fetch_uint16_t(&cc->cc_flags)
+	     & (CLNT_REQ_FLAG_CREDIT | CLNT_REQ_FLAG_RETRANS))
+	    != CLNT_REQ_FLAG_CREDIT)
+		return;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	timespecsub(&ts, &cc->cc_sent, &ts);
+	us = MAX(ts.tv_sec * 1000000 + ts.tv_nsec / 1000, 1);
+
+	mutex_lock(&w->cw_mtx);
+	if (!w->cw_rtt_min_us || us < w->cw_rtt_min_us)
+		w->cw_rtt_min_us = us;
+	target = w->cw.cw_target_us
+		? w->cw.cw_target_us
+		: MAX(CLNT_WINDOW_TARGET_MUL * w->cw_rtt_min_us,
+		      CLNT_WINDOW_TARGET_MIN_US);
+
+	if (w->cw_cooldown) {
+		w->cw_cooldown--;
+	} else if (us > target) {
+		clnt_window_decrease(w);
+	} else if (++w->cw_acked >= w->cw.cw_cwnd
+		   && w->cw.cw_cwnd < w->cw.cw_calls) {
+		w->cw.cw_cwnd++;
+		w->cw_acked = 0;
+		if (w->cw_waiters)
+			cond_signal(&w->cw_cv);
+	}
+	mutex_unlock(&w->cw_mtx);
+}
+
+static enum clnt_stat clnt_req_submitv(struct clnt_req **, int);
+
+/*
+ * Send a staged call given credit.  Its caller has long returned, so a
+ * failure completes the call now, with its error, as a reply would;
+ * not at its expiry.
+ */
+static void
+clnt_window_send(struct clnt_req *cc)
+{
+	enum clnt_stat stat;
+
+	atomic_inc_int32_t(&cc->cc_refcnt);
+	stat = clnt_req_submitv(&cc, 1);
+	if (stat == RPC_SUCCESS) {
+		clnt_req_release(cc);
+		return;
+	}
+
+	/* order dependent */
+	if (atomic_postclear_uint16_t_bits(&cc->cc_flags,
+					   CLNT_REQ_FLAG_EXPIRING)
+	    & CLNT_REQ_FLAG_EXPIRING) {
+		svc_rqst_expire_remove(cc);
+		cc->cc_expire_ms = 0;	/* atomic barrier(s) */
+	}
+
+	if (!(atomic_postset_uint16_t_bits(&cc->cc_flags,
+					   CLNT_REQ_FLAG_ACKSYNC)
+	      & (CLNT_REQ_FLAG_ACKSYNC | CLNT_REQ_FLAG_BACKSYNC))) {
+		__warnx(TIRPC_DEBUG_FLAG_CLNT_REQ,
+			"%s: %p xid %" PRIu32 " send failed (%d)",
+			__func__, cc->cc_clnt, cc->cc_xid, stat);
+		if (cc->cc_error.re_status == RPC_SUCCESS)
+			cc->cc_error.re_status = stat;
+		(*cc->cc_process_cb)(cc);
+	}
+	clnt_req_release(cc);
+}
+
+/*
+ * Return the credit of a call; it passes to the first staged call.
+ */
+static void
+clnt_window_release(struct clnt_req *cc)
+{
+	struct clnt_win *w = &CX_DATA(cc->cc_clnt)->cx_win;
+	struct clnt_req *next = NULL;
+	struct clnt_cq_entry *cqe;
+
+	if (!(atomic_postclear_uint16_t_bits(&cc->cc_flags,
+					     CLNT_REQ_FLAG_CREDIT)
+	      & CLNT_REQ_FLAG_CREDIT))
+		return;
+
+	(void)atomic_sub_uint32_t(&w->cw.cw_inflight_bytes, cc->cc_bytes);
+	cc->cc_bytes = 0;
+
+	mutex_lock(&w->cw_mtx);
+	w->cw.cw_inflight--;
+	if (cc->cc_error.re_status == RPC_TIMEDOUT
+	 && (w->cw.cw_flags & CLNT_WINDOW_FLAG_ADAPT)
+	 && !w->cw_cooldown)
+		clnt_window_decrease(w);
+
+	cqe = w->cw_head;
+	if (cqe && clnt_window_room(w)) {
+		w->cw_head = cqe->cqe_next;
+		if (!w->cw_head)
+			w->cw_tailp = &w->cw_head;
+		w->cw.cw_staged--;
+		w->cw.cw_inflight++;
+		next = opr_containerof(cqe, struct clnt_req, cc_cqe);
+		atomic_set_uint16_t_bits(&next->cc_flags,
+					 CLNT_REQ_FLAG_CREDIT);
+	} else if (w->cw_waiters) {
+		cond_signal(&w->cw_cv);
+	}
+	mutex_unlock(&w->cw_mtx);
+
+	if (next) {
+		if (w->cw.cw_flags & CLNT_WINDOW_FLAG_ADAPT)
+			(void)clock_gettime(CLOCK_MONOTONIC, &next->cc_sent);
+		clnt_window_send(next);
+	}
+}
+
+/*
+ * CLSET_WINDOW, CLGET_WINDOW
+ */
+bool
+clnt_window_control(struct cx_data *cx, u_int request, void *info)
+{
+	struct clnt_win *w = &cx->cx_win;
+	struct clnt_window *cw = (struct clnt_window *)info;
+
+	switch (request) {
+	case CLSET_WINDOW:
+		if (cw->cw_mode > CLNT_WINDOW_QUEUE
+		 || (cw->cw_flags & ~CLNT_WINDOW_FLAG_ADAPT))
+			return (false);
+		mutex_lock(&w->cw_mtx);
+		w->cw.cw_calls = cw->cw_calls;
+		w->cw.cw_bytes = cw->cw_bytes;
+		w->cw.cw_stage = cw->cw_stage;
+		w->cw.cw_target_us = cw->cw_target_us;
+		w->cw.cw_mode = cw->cw_mode;
+		w->cw.cw_flags = cw->cw_flags;
+		w->cw.cw_cwnd = cw->cw_calls;
+		w->cw_acked = 0;
+		w->cw_cooldown = 0;
+		if (w->cw_waiters)
+			cond_broadcast(&w->cw_cv);
+		mutex_unlock(&w->cw_mtx);
+		return (true);
+	case CLGET_WINDOW:
+		mutex_lock(&w->cw_mtx);
+		*cw = w->cw;
+		cw->cw_inflight_bytes =
+			atomic_fetch_uint32_t(&w->cw.cw_inflight_bytes);
+		mutex_unlock(&w->cw_mtx);
+		return (true);
+	default:
+		return (false);
+	}
+}
+
 enum clnt_stat
 clnt_req_callback(struct clnt_req *cc)
 {
+	struct cx_data *cx = CX_DATA(cc->cc_clnt);
+	struct timespec ts;
+	enum clnt_stat stat;
+
+	switch (clnt_window_admit(cc, true, false)) {
+	case 0:
+		break;
+	case EINPROGRESS:
+		/* sent by clnt_window_release() */
+		return (RPC_SUCCESS);
+	default:
+		return (cc->cc_error.re_status);
+	}
+
+	if (cx->cx_rtt.cr_rto) {
+		/* retransmit on the estimated timeout until cc_timeout */
+		(void)clock_gettime(CLOCK_MONOTONIC_FAST, &ts);
+		timespecadd(&ts, &cc->cc_timeout, &ts);
+		cc->cc_deadline_ms = timespec_ms(&ts);
+	}
+
+	/* once expiring, it may complete (and be released) at any time */
+	atomic_inc_int32_t(&cc->cc_refcnt);
 	svc_rqst_expire_insert(cc);
 
-	return CLNT_CALL_ONCE(cc);
+	stat = CLNT_CALL_ONCE(cc);
+	clnt_req_release(cc);
+	return (stat);
 }
 
 /*
- * waitq_entry is locked in clnt_req_setup()
+ * Send calls holding their credit: expiry is registered in one pass,
+ * and each run of calls on the same CLIENT is handed to its transport
+ * together.
  */
+static enum clnt_stat
+clnt_req_submitv(struct clnt_req **ccv, int count)
+{
+	struct clnt_req *cc;
+	CLIENT *clnt;
+	struct timespec now;
+	struct timespec ts;
+	enum clnt_stat stat = RPC_SUCCESS;
+	enum clnt_stat result;
+	int i, j, k;
+
+	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &now);
+	for (i = 0; i < count; i++) {
+		cc = ccv[i];
+		if (CX_DATA(cc->cc_clnt)->cx_rtt.cr_rto) {
+			/* retransmit on the estimated timeout until cc_timeout */
+			timespecadd(&now, &cc->cc_timeout, &ts);
+			cc->cc_deadline_ms = timespec_ms(&ts);
+		}
+		/* once expiring, it may complete (and be released) at any time */
+		atomic_inc_int32_t(&cc->cc_refcnt);
+	}
+	svc_rqst_expire_insertv(ccv, count);
+
+	for (i = 0; i < count; i = j) {
+		clnt = ccv[i]->cc_clnt;
+		for (j = i + 1; j < count && ccv[j]->cc_clnt == clnt; j++)
+			;
+
+		result = RPC_SUCCESS;
+		if (clnt->cl_ops->cl_call_batch) {
+			result = (*clnt->cl_ops->cl_call_batch)(&ccv[i], j - i);
+		} else {
+			for (k = i; k < j; k++) {
+				enum clnt_stat once = CLNT_CALL_ONCE(ccv[k]);
+
+				if (once != RPC_SUCCESS) {
+					ccv[k]->cc_error.re_status = once;
+					result = once;
+				}
+			}
+		}
+		if (stat == RPC_SUCCESS)
+			stat = result;
+	}
+
+	for (i = 0; i < count; i++)
+		clnt_req_release(ccv[i]);
+	return (stat);
+}
+
+/*
+ * CLNT_CALL_BACK() for several calls, each already set up with its
+ * cc_process_cb.  Calls admitted by their flow control windows are
+ * sent together; before waiting for (or staging) the next call.
+ *
+ * Returns the first failure; each failed call has its own cc_error,
+ * and is not sent.
+ */
+enum clnt_stat
+clnt_req_submit_batch(struct clnt_req **ccv, int count)
+{
+	enum clnt_stat stat = RPC_SUCCESS;
+	enum clnt_stat result;
+	int i = 0;
+	int n;
+
+	while (i < count) {
+		for (n = i; n < count; n++) {
+			if (clnt_window_admit(ccv[n], true, true))
+				break;
+		}
+		if (n > i) {
+			result = clnt_req_submitv(&ccv[i], n - i);
+			if (stat == RPC_SUCCESS)
+				stat = result;
+			i = n;
+			continue;
+		}
+
+		/* ccv[i] found its window full */
+		switch (clnt_window_admit(ccv[i], true, false)) {
+		case 0:
+			result = clnt_req_submitv(&ccv[i], 1);
+			break;
+		case EINPROGRESS:
+			result = RPC_SUCCESS;
+			break;
+		default:
+			result = ccv[i]->cc_error.re_status;
+			break;
+		}
+		if (stat == RPC_SUCCESS)
+			stat = result;
+		i++;
+	}
+	return (stat);
+}
+
+/*
+ * Synchronous completion.  cc_done is a one-shot event: the reply side
+ * stores SIGNALLED, and wakes the waiter only when it went to sleep
+ * (WAITING).  On Linux the waiter sleeps on the word itself (futex), so
+ * neither side takes a lock; elsewhere it sleeps on cc_we.
+ */
+#define CLNT_REQ_DONE_IDLE	0
+#define CLNT_REQ_DONE_WAITING	1
+#define CLNT_REQ_DONE_SIGNALLED	2
+
+#if defined(__linux__)
+static inline int
+clnt_req_futex(uint32_t *uaddr, int op, uint32_t val,
+	       const struct timespec *ts)
+{
+	return syscall(SYS_futex, uaddr, op | FUTEX_PRIVATE_FLAG, val, ts,
+		       NULL, FUTEX_BITSET_MATCH_ANY);
+}
+#endif
+
 void
 clnt_req_callback_default(struct clnt_req *cc)
 {
+	if (atomic_exchange_uint32_t(&cc->cc_done, CLNT_REQ_DONE_SIGNALLED)
+	    != CLNT_REQ_DONE_WAITING)
+		return;
+
+#if defined(__linux__)
+	(void)clnt_req_futex(&cc->cc_done, FUTEX_WAKE, 1, NULL);
+#else
 	mutex_lock(&cc->cc_we.mtx);
 	cond_signal(&cc->cc_we.cv);
 	mutex_unlock(&cc->cc_we.mtx);
+#endif
+}
+
+/*
+ * Wait for clnt_req_callback_default(), until the (CLOCK_MONOTONIC)
+ * deadline; first polling up to __svc_params->clnt.spin times.
+ *
+ * @return 0 when signalled, or ETIMEDOUT.
+ */
+static int
+clnt_req_done_wait(struct clnt_req *cc, const struct timespec *deadline)
+{
+	u_int spin = __svc_params->clnt.spin;
+	int code = 0;
+#if !defined(__linux__)
+	struct timespec now;
+	struct timespec ts;
+#endif
+
+	while (spin--) {
+		if (atomic_fetch_uint32_t(&cc->cc_done)
+		    == CLNT_REQ_DONE_SIGNALLED)
+			return (0);
+	}
+
+	if (!atomic_cmpxchg_uint32_t(&cc->cc_done, CLNT_REQ_DONE_IDLE,
+				     CLNT_REQ_DONE_WAITING))
+		return (0);	/* already signalled */
+
+#if defined(__linux__)
+	while (atomic_fetch_uint32_t(&cc->cc_done) == CLNT_REQ_DONE_WAITING) {
+		/* FUTEX_WAIT_BITSET: absolute CLOCK_MONOTONIC deadline */
+		if (clnt_req_futex(&cc->cc_done, FUTEX_WAIT_BITSET,
+				   CLNT_REQ_DONE_WAITING, deadline) < 0
+		 && errno == ETIMEDOUT) {
+			code = ETIMEDOUT;
+			break;
+		}
+	}
+#else
+	/* cond_timedwait() takes CLOCK_REALTIME */
+	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &now);
+	timespecsub(deadline, &now, &ts);
+	(void)clock_gettime(CLOCK_REALTIME_FAST, &now);
+	timespecadd(&now, &ts, &ts);
+
+	mutex_lock(&cc->cc_we.mtx);
+	while (atomic_fetch_uint32_t(&cc->cc_done) == CLNT_REQ_DONE_WAITING) {
+		if (cond_timedwait(&cc->cc_we.cv, &cc->cc_we.mtx, &ts)
+		    == ETIMEDOUT) {
+			code = ETIMEDOUT;
+			break;
+		}
+	}
+	mutex_unlock(&cc->cc_we.mtx);
+#endif
+
+	if (code == ETIMEDOUT
+	 && !atomic_cmpxchg_uint32_t(&cc->cc_done, CLNT_REQ_DONE_WAITING,
+				     CLNT_REQ_DONE_IDLE))
+		code = 0;	/* signalled meanwhile */
+	return (code);
 }
 
 enum clnt_stat
@@ -471,22 +1143,11 @@ clnt_req_refresh(struct clnt_req *cc)
 {
 	struct cx_data *cx = CX_DATA(cc->cc_clnt);
 	struct rpc_dplx_rec *rec = cx->cx_rec;
-	struct opr_rbtree_node *nv;
 
-	/* this lock protects both xid and rbtree */
-	rpc_dplx_rli(rec);
-	opr_rbtree_remove(&rec->call_replies, &cc->cc_dplx);
-	cc->cc_xid = ++(rec->call_xid);
-	nv = opr_rbtree_insert(&rec->call_replies, &cc->cc_dplx);
-	rpc_dplx_rui(rec);
-	if (nv) {
-		__warnx(TIRPC_DEBUG_FLAG_ERROR,
-			"%s: %p fd %d insert failed xid %" PRIu32,
-			__func__, &rec->xprt, rec->xprt.xp_fd,
-			cc->cc_xid);
-		cc->cc_error.re_status = RPC_TLIERROR;
+	clnt_req_xid_remove(rec, cc);
+	cc->cc_xid = atomic_inc_uint32_t(&rec->call_xid);
+	if (!clnt_req_xid_insert(rec, cc))
 		return (RPC_TLIERROR);
-	}
 
 	cc->cc_error.re_status = RPC_SUCCESS;
 	return (RPC_SUCCESS);
@@ -497,9 +1158,8 @@ clnt_req_reset(struct clnt_req *cc)
 {
 	struct cx_data *cx = CX_DATA(cc->cc_clnt);
 
-	rpc_dplx_rli(cx->cx_rec);
-	opr_rbtree_remove(&cx->cx_rec->call_replies, &cc->cc_dplx);
-	rpc_dplx_rui(cx->cx_rec);
+	if (cx->cx_rec->call_replies.tree)
+		clnt_req_xid_remove(cx->cx_rec, cc);
 
 	if (atomic_postclear_uint16_t_bits(&cc->cc_flags,
 					   CLNT_REQ_FLAG_ACKSYNC |
@@ -508,19 +1168,32 @@ clnt_req_reset(struct clnt_req *cc)
 		svc_rqst_expire_remove(cc);
 		cc->cc_expire_ms = 0;	/* atomic barrier(s) */
 	}
+	clnt_window_release(cc);
 }
 
 enum clnt_stat
 clnt_req_setup(struct clnt_req *cc, struct timespec timeout)
 {
 	CLIENT *clnt = cc->cc_clnt;
-	struct cx_data *cx = CX_DATA(clnt);
-	struct rpc_dplx_rec *rec = cx->cx_rec;
-	struct opr_rbtree_node *nv;
+	struct cx_data *cx;
+	struct rpc_dplx_rec *rec;
+
+	if (clnt->cl_ops->cl_select) {
+		/* the call is carried by one of its connections; ref+1 */
+		clnt = (*clnt->cl_ops->cl_select)(clnt);
+		cc->cc_clnt = clnt;
+	} else {
+		CLNT_REF(clnt, CLNT_REF_FLAG_NONE);
+	}
+	cx = CX_DATA(clnt);
+	rec = cx->cx_rec;
 
 	cc->cc_error.re_errno = 0;
 	cc->cc_error.re_status = RPC_SUCCESS;
 	cc->cc_flags = CLNT_REQ_FLAG_NONE;
+	cc->cc_done = CLNT_REQ_DONE_IDLE;
+	cc->cc_bytes = 0;
+	cc->cc_deadline_ms = 0;
 	cc->cc_process_cb = clnt_req_callback_default;
 	cc->cc_refreshes = 2;
 	cc->cc_timeout = timeout;
@@ -540,20 +1213,13 @@ clnt_req_setup(struct clnt_req *cc, struct timespec timeout)
 			__func__, timeout.tv_sec);
 	}
 
-	/* this lock protects both xid and rbtree */
-	rpc_dplx_rli(rec);
-	cc->cc_xid = ++(rec->call_xid);
-	nv = opr_rbtree_insert(&rec->call_replies, &cc->cc_dplx);
-	rpc_dplx_rui(rec);
-	if (nv) {
-		__warnx(TIRPC_DEBUG_FLAG_ERROR,
-			"%s: %p fd %d insert failed xid %" PRIu32,
-			__func__, &rec->xprt, rec->xprt.xp_fd, cc->cc_xid);
-		cc->cc_error.re_status = RPC_TLIERROR;
+	if (unlikely(!atomic_fetch_voidptr((void **)&rec->call_replies.tree)))
+		clnt_req_xid_init(rec);
+
+	cc->cc_xid = atomic_inc_uint32_t(&rec->call_xid);
+	if (!clnt_req_xid_insert(rec, cc))
 		return (RPC_TLIERROR);
-	}
 
-	CLNT_REF(clnt, CLNT_REF_FLAG_NONE);
 	return (RPC_SUCCESS);
 }
 
@@ -565,14 +1231,26 @@ clnt_req_process_reply(SVCXPRT *xprt, struct svc_req *req)
 {
 	XDR *xdrs = req->rq_xdrs;
 	struct rpc_dplx_rec *rec = REC_XPRT(xprt);
-	struct opr_rbtree_node *nv;
+	struct opr_rbtree_node *nv = NULL;
+	struct rbtree_x_part *t;
 	struct clnt_req *cc;
 	struct clnt_req cc_k;
 
-	rpc_dplx_rli(rec);
 	cc_k.cc_xid = req->rq_msg.rm_xid;
-	nv = opr_rbtree_lookup(&rec->call_replies, &cc_k.cc_dplx);
-	rpc_dplx_rui(rec);
+	if (atomic_fetch_voidptr((void **)&rec->call_replies.tree)) {
+		t = rbtx_partition_of_scalar(&rec->call_replies,
+					     cc_k.cc_xid);
+		pthread_spin_lock(&t->sp);
+		nv = opr_rbtree_lookup(&t->t, &cc_k.cc_dplx);
+		/* hold the call, a duplicate reply may complete it
+		 * meanwhile; unless already released (and removing).
+		 */
+		if (nv && !atomic_inc_unless_zero_int32_t(
+				&opr_containerof(nv, struct clnt_req,
+						 cc_dplx)->cc_refcnt))
+			nv = NULL;
+		pthread_spin_unlock(&t->sp);
+	}
 	if (!nv) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s: %p fd %d lookup failed xid %" PRIu32,
@@ -596,11 +1274,26 @@ clnt_req_process_reply(SVCXPRT *xprt, struct svc_req *req)
 			__func__, xprt, xprt->xp_fd, cc->cc_xid,
 			cc->cc_error.re_status);
 		cc->cc_refreshes = 0;
+		clnt_req_release(cc);
 		return SVC_STAT(xprt);
 	}
 
+	if (CX_DATA(cc->cc_clnt)->cx_rtt.cr_rto
+	 && !(atomic_fetch_uint16_t(&cc->cc_flags) & CLNT_REQ_FLAG_RETRANS))
+		clnt_rtt_sample(cc);
+	clnt_window_sample(cc);
+
 	_seterr_reply(&req->rq_msg, &(cc->cc_error));
 	if (cc->cc_error.re_status == RPC_SUCCESS) {
+		/* results outlive the request (and its arena) */
+		u_int arena = xdrs->x_flags & XDR_FLAG_ARENA;
+		struct xdr_arena *xa = xdrs->x_arena;
+
+		xdrs->x_flags &= ~XDR_FLAG_ARENA;
+		if (cc->cc_arena) {
+			xdrs->x_flags |= XDR_FLAG_ARENA;
+			xdrs->x_arena = cc->cc_arena;
+		}
 		if (!AUTH_VALIDATE(cc->cc_auth, &(cc->cc_verf))) {
 			cc->cc_error.re_status = RPC_AUTHERROR;
 			cc->cc_error.re_why = AUTH_INVALIDRESP;
@@ -611,6 +1304,8 @@ clnt_req_process_reply(SVCXPRT *xprt, struct svc_req *req)
 			if (cc->cc_error.re_status == RPC_SUCCESS)
 				cc->cc_error.re_status = RPC_CANTDECODERES;
 		}
+		xdrs->x_flags = (xdrs->x_flags & ~XDR_FLAG_ARENA) | arena;
+		xdrs->x_arena = xa;
 		cc->cc_refreshes = 0;
 	}
 
@@ -620,6 +1315,7 @@ clnt_req_process_reply(SVCXPRT *xprt, struct svc_req *req)
 		cc->cc_error.re_status);
 
 	(*cc->cc_process_cb)(cc);
+	clnt_req_release(cc);
 	return SVC_STAT(xprt);
 }
 
@@ -628,14 +1324,28 @@ clnt_req_wait_reply(struct clnt_req *cc)
 {
 	struct cx_data *cx = CX_DATA(cc->cc_clnt);
 	struct rpc_dplx_rec *rec = cx->cx_rec;
+	struct timespec deadline;
 	struct timespec ts;
 	int code;
+	int ms;
+	int i;
+	bool resend = false;
 
 	__warnx(TIRPC_DEBUG_FLAG_CLNT_REQ,
 		"%s: %p fd %d xid %" PRIu32 " (%ld.%09ld)",
 		__func__, &rec->xprt, rec->xprt.xp_fd, cc->cc_xid,
 		cc->cc_timeout.tv_sec, cc->cc_timeout.tv_nsec);
 
+	if (cx->cx_rtt.cr_rto) {
+		/* same overall limit as cc_timeout per refresh */
+		(void)clock_gettime(CLOCK_MONOTONIC_FAST, &deadline);
+		for (i = 0; i <= cc->cc_refreshes; i++)
+			timespecadd(&deadline, &cc->cc_timeout, &deadline);
+	}
+
+	if (clnt_window_admit(cc, false, false))
+		return (cc->cc_error.re_status);
+
  call_again:
 	cc->cc_error.re_status = CLNT_CALL_ONCE(cc);
 	if (cc->cc_error.re_status != RPC_SUCCESS) {
@@ -646,9 +1356,23 @@ clnt_req_wait_reply(struct clnt_req *cc)
 		return (RPC_SUCCESS);
 	}
 
-	(void)clock_gettime(CLOCK_REALTIME_FAST, &ts);
-	timespecadd(&ts, &cc->cc_timeout, &ts);
-	code = cond_timedwait(&cc->cc_we.cv, &cc->cc_we.mtx, &ts);
+	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &ts);
+	if (cx->cx_rtt.cr_rto) {
+		/* wait for the estimated timeout, then retransmit */
+		ms = clnt_rtt_timeout_ms(cx);
+		ts.tv_sec += ms / 1000;
+		ts.tv_nsec += (ms % 1000) * 1000000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		resend = timespeccmp(&ts, &deadline, <);
+		if (!resend)
+			ts = deadline;
+	} else {
+		timespecadd(&ts, &cc->cc_timeout, &ts);
+	}
+	code = clnt_req_done_wait(cc, &ts);
 
 	__warnx(TIRPC_DEBUG_FLAG_CLNT_REQ,
 		"%s: %p fd %d replied xid %" PRIu32,
@@ -662,6 +1386,17 @@ clnt_req_wait_reply(struct clnt_req *cc)
 			cc->cc_error.re_status = RPC_TIMEDOUT;
 			return (RPC_TIMEDOUT);
 		}
+		if (resend) {
+			/* same xid; Karn: no sample from its reply */
+			clnt_rtt_backoff(cx);
+			atomic_set_uint16_t_bits(&cc->cc_flags,
+						 CLNT_REQ_FLAG_RETRANS);
+			goto call_again;
+		}
+		if (cx->cx_rtt.cr_rto) {
+			cc->cc_error.re_status = RPC_TIMEDOUT;
+			return (RPC_TIMEDOUT);
+		}
 	}
 
 	if (cc->cc_refreshes-- > 0) {
@@ -673,6 +1408,8 @@ clnt_req_wait_reply(struct clnt_req *cc)
 				return (cc->cc_error.re_status);
 			}
 		}
+		/* no reply is taken until ACKSYNC is cleared */
+		atomic_store_uint32_t(&cc->cc_done, CLNT_REQ_DONE_IDLE);
 		atomic_clear_uint16_t_bits(&cc->cc_flags,
 					   CLNT_REQ_FLAG_ACKSYNC);
 		goto call_again;
@@ -705,6 +1442,8 @@ clnt_req_release(struct clnt_req *cc)
 
 	clnt_req_reset(cc);
 	clnt_req_fini(cc);
+	if (cc->cc_arena)
+		xdr_arena_destroy(cc->cc_arena);
 	CLNT_RELEASE(cc->cc_clnt, CLNT_RELEASE_FLAG_NONE);
 
 	(*cc->cc_free_cb)(cc, cc->cc_size);
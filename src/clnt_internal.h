@@ -32,12 +32,65 @@
 
 #define MCALL_MSG_SIZE 24
 
+/* calls encoded per pass of cl_call_batch */
+#define CLNT_BATCH_MAX 32
+
+/* Retransmit timeout bounds (RFC 6298), microseconds */
+#define CLNT_RTO_INIT_US	1000000
+#define CLNT_RTO_MIN_US		10000
+#define CLNT_RTO_MAX_US		60000000
+#define CLNT_RTO_BACKOFF_MAX	6
+
+/*
+ * Jacobson/Karn round trip estimator, per CLIENT (destination).
+ * Only datagram clients enable it (cr_rto != 0).  Updated under cl_lock.
+ */
+struct clnt_rtt {
+	int64_t cr_srtt;	/* usec */
+	int64_t cr_rttvar;	/* usec */
+	int32_t cr_rto;		/* usec */
+	uint32_t cr_backoff;
+	uint64_t cr_samples;
+	uint64_t cr_retrans;
+	uint64_t cr_hist[CLNT_RTT_HIST_MAX];
+};
+
+/* default reply latency target of an adaptive window */
+#define CLNT_WINDOW_TARGET_MIN_US	1000
+#define CLNT_WINDOW_TARGET_MUL		4
+
+/*
+ * Flow control window, per CLIENT.  Counted under cw_mtx, except the
+ * bytes (charged as encoded, atomic).  Staged calls are linked FIFO by
+ * cc_cqe, and sent as credit is returned.
+ */
+struct clnt_win {
+	mutex_t cw_mtx;
+	cond_t cw_cv;
+	struct clnt_window cw;		/* limits and counts */
+	struct clnt_cq_entry *cw_head;	/* staged */
+	struct clnt_cq_entry **cw_tailp;
+	uint32_t cw_waiters;
+	uint32_t cw_acked;		/* replies since cw_cwnd changed */
+	uint32_t cw_cooldown;		/* replies sent before a decrease */
+	uint32_t cw_rtt_min_us;
+};
+
+/* clock of cw_cv deadlines: monotonic, where a condvar can take it */
+#if defined(__APPLE__) || defined(_WIN32)
+#define CLNT_WIN_CLOCK CLOCK_REALTIME
+#else
+#define CLNT_WIN_CLOCK CLOCK_MONOTONIC
+#endif
+
 struct cx_data {
 	struct rpc_client cx_c;		/**< Transport Independent handle */
 	struct rpc_dplx_rec *cx_rec;	/* unified sync */
 
 	char cx_mcallc[MCALL_MSG_SIZE];	/* marshalled callmsg */
 	u_int cx_mpos;		/* pos after marshal */
+	struct clnt_rtt cx_rtt;
+	struct clnt_win cx_win;
 };
 #define CX_DATA(p) (opr_containerof((p), struct cx_data, cx_c))
 
@@ -45,14 +98,31 @@ struct cx_data {
 static inline void
 clnt_data_init(struct cx_data *cx)
 {
+#if !defined(__APPLE__) && !defined(_WIN32)
+	pthread_condattr_t attr;
+#endif
+
 	mutex_init(&cx->cx_c.cl_lock, NULL);
 	cx->cx_c.cl_refcnt = 1;
+
+	mutex_init(&cx->cx_win.cw_mtx, NULL);
+#if !defined(__APPLE__) && !defined(_WIN32)
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLNT_WIN_CLOCK);
+	cond_init(&cx->cx_win.cw_cv, &attr, NULL);
+	pthread_condattr_destroy(&attr);
+#else
+	cond_init(&cx->cx_win.cw_cv, 0, NULL);
+#endif
+	cx->cx_win.cw_tailp = &cx->cx_win.cw_head;
 }
 
 static inline void
 clnt_data_destroy(struct cx_data *cx)
 {
 	mutex_destroy(&cx->cx_c.cl_lock);
+	cond_destroy(&cx->cx_win.cw_cv);
+	mutex_destroy(&cx->cx_win.cw_mtx);
 
 	/* note seemingly pointers to constant ""? */
 	if (cx->cx_c.cl_netid && cx->cx_c.cl_netid[0])
@@ -61,8 +131,50 @@ clnt_data_destroy(struct cx_data *cx)
 		mem_free(cx->cx_c.cl_tp, strlen(cx->cx_c.cl_tp) + 1);
 }
 
+/*
+ * Marshal the call header with this call's own xid, instead of stamping
+ * it into the shared cx_mcallc (only changed by CLSET_PROG and VERS).
+ */
+static inline bool
+clnt_req_marshal_hdr(struct cx_data *cx, struct clnt_req *cc, XDR *xdrs)
+{
+	return (XDR_PUTUINT32(xdrs, cc->cc_xid)
+		&& XDR_PUTBYTES(xdrs, &cx->cx_mcallc[BYTES_PER_XDR_UNIT],
+				cx->cx_mpos - BYTES_PER_XDR_UNIT)
+		&& XDR_PUTUINT32(xdrs, cc->cc_proc));
+}
+
+/*
+ * Bound a call encoded in one contiguous buffer (RPCSEC_GSS), so that
+ * it is allocated once: header, credential, verifier, databody length
+ * and sequence, arguments, and checksum.
+ */
+static inline u_int
+clnt_req_size(struct cx_data *cx, struct clnt_req *cc, u_int max)
+{
+	u_long size = cx->cx_mpos + 3 * BYTES_PER_XDR_UNIT
+		    + 3 * (2 * BYTES_PER_XDR_UNIT + MAX_AUTH_BYTES)
+		    + xdr_sizeof(cc->cc_call.proc, cc->cc_call.where);
+
+	return (size < max ? size : max);
+}
+
+/* in clnt_generic.c */
+void clnt_rtt_init(struct cx_data *);
+void clnt_rtt_sample(struct clnt_req *);
+void clnt_rtt_backoff(struct cx_data *);
+int clnt_rtt_timeout_ms(struct cx_data *);
+void clnt_rtt_stats(struct cx_data *, struct clnt_rtt_stats *);
+void clnt_window_charge(struct cx_data *, struct clnt_req *, u_int);
+bool clnt_window_control(struct cx_data *, u_int, void *);
+
+/* in clnt_cache.c */
+bool clnt_cache_control(int, struct rpc_clnt_cache *);
+void clnt_cache_gc_idle(void);
+
 /* in svc_rqst.c */
 void svc_rqst_expire_insert(struct clnt_req *);
+void svc_rqst_expire_insertv(struct clnt_req **, int);
 void svc_rqst_expire_remove(struct clnt_req *);
 
 #endif				/* _CLNT_INTERNAL_H */
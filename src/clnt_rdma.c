@@ -163,7 +163,7 @@ clnt_rdma_call(struct clnt_req *cc)
 				 "call context", 1, IOQ_FLAG_NONE);
 	struct rpc_rdma_cbc *cbc = (struct rpc_rdma_cbc *)(_IOQ(have));
 	XDR *xdrs;
-	u_int32_t *uint32p;
+	bool gss;
 
 	/* free old buffers (should do nothing) */
 	xdr_ioq_release(&cbc->recvq.ioq_uv.uvqh);
@@ -180,24 +180,26 @@ clnt_rdma_call(struct clnt_req *cc)
 	xdrs = cbc->sendq.xdrs;
 	cc->cc_error.re_status = RPC_SUCCESS;
 
-	mutex_lock(&cl->cl_lock);
-	uint32p = (u_int32_t *)&cx->cx_mcallc[0];
-	*uint32p = htonl(cc->cc_xid);
+	/* RPCSEC_GSS updates its AUTH while marshalling */
+	gss = (cc->cc_auth->ah_cred.oa_flavor == RPCSEC_GSS);
+	if (gss)
+		mutex_lock(&cl->cl_lock);
 
-	if (!XDR_PUTBYTES(xdrs, cx->cx_mcallc, cx->cx_mpos)
-	 || !XDR_PUTUINT32(xdrs, cc->cc_proc)
+	if (!clnt_req_marshal_hdr(cx, cc, xdrs)
 	 || !AUTH_MARSHALL(cc->cc_auth, xdrs)
 	 || !AUTH_WRAP(cc->cc_auth, xdrs,
 		       cc->cc_call.proc, cc->cc_call.where)) {
 		/* error case */
-		mutex_unlock(&cl->cl_lock);
+		if (gss)
+			mutex_unlock(&cl->cl_lock);
 		__warnx(TIRPC_DEBUG_FLAG_CLNT_RDMA,
 			"%s: %p@%p failed",
 			__func__, cl, cx->cx_rec);
 		xdr_ioq_release(&cbc->sendq.ioq_uv.uvqh);
 		return (RPC_CANTENCODEARGS);
 	}
-	mutex_unlock(&cl->cl_lock);
+	if (gss)
+		mutex_unlock(&cl->cl_lock);
 
 	if (!xdr_rdma_clnt_flushout(cbc)) {
 		cl->cl_error.re_errno = errno;
@@ -255,18 +257,14 @@ clnt_rdma_control(CLIENT *cl, u_int request, void *info)
 		break;
 
 	case CLGET_XID:
-		/*
-		 * use the knowledge that xid is the
-		 * first element in the call structure *.
-		 * This will get the xid of the PREVIOUS call
-		 */
-		uint32p = (u_int32_t *)&cx->cx_mcallc[0];
-		*(u_int32_t *)info = ntohl(*uint32p);
+		/* the xid of the PREVIOUS call on this channel */
+		*(u_int32_t *)info = atomic_fetch_uint32_t(&rec->call_xid);
 		break;
 
 	case CLSET_XID:
 		/* This will set the xid of the NEXT call */
-		rec->call_xid = htonl(*(u_int32_t *) info - 1);
+		atomic_store_uint32_t(&rec->call_xid,
+				      *(u_int32_t *)info - 1);
 		/* decrement by 1 as clnt_req_setup() increments once */
 		break;
 
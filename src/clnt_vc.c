@@ -299,8 +299,11 @@ clnt_vc_process(struct svc_req *req)
 	return SVC_STAT(xprt);
 }
 
-static enum clnt_stat
-clnt_vc_call(struct clnt_req *cc)
+/*
+ * Encode a call, ready to queue on its transport.
+ */
+static struct xdr_ioq *
+clnt_vc_encode(struct clnt_req *cc)
 {
 	CLIENT *clnt = cc->cc_clnt;
 	struct cx_data *cx = CX_DATA(clnt);
@@ -308,49 +311,95 @@ clnt_vc_call(struct clnt_req *cc)
 	SVCXPRT *xprt = &rec->xprt;
 	struct xdr_ioq *xioq;
 	XDR *xdrs;
-	u_int32_t *uint32p;
+	bool gss;
+	u_int max = __svc_params->ioq.send_max + RPC_MAXDATA_DEFAULT;
 
 	/* XXX Until gss_get_mic and gss_wrap can be replaced with
 	 * iov equivalents, replies with RPCSEC_GSS security must be
-	 * encoded in a contiguous buffer.
+	 * encoded in a contiguous buffer, sized beforehand rather
+	 * than reallocated and copied.
 	 *
 	 * Nb, we should probably use getpagesize() on Unix.  Need
 	 * an equivalent for Windows.
 	 */
-	xioq = xdr_ioq_create(RPC_MAXDATA_DEFAULT,
-			      __svc_params->ioq.send_max + RPC_MAXDATA_DEFAULT,
-			      (cc->cc_auth->ah_cred.oa_flavor == RPCSEC_GSS)
-			      ? UIO_FLAG_REALLOC | UIO_FLAG_FREE
-			      : UIO_FLAG_FREE);
+	gss = (cc->cc_auth->ah_cred.oa_flavor == RPCSEC_GSS);
+	xioq = gss
+		? xdr_ioq_create(clnt_req_size(cx, cc, max), max,
+				 UIO_FLAG_REALLOC | UIO_FLAG_FREE)
+		: xdr_ioq_create(RPC_MAXDATA_DEFAULT, max, UIO_FLAG_FREE);
 
 	xdrs = xioq->xdrs;
-	cc->cc_error.re_status = RPC_SUCCESS;
 
-	mutex_lock(&clnt->cl_lock);
-	uint32p = (u_int32_t *)&cx->cx_mcallc[0];
-	*uint32p = htonl(cc->cc_xid);
+	/* RPCSEC_GSS updates its AUTH while marshalling */
+	if (gss)
+		mutex_lock(&clnt->cl_lock);
 
-	if ((!XDR_PUTBYTES(xdrs, cx->cx_mcallc, cx->cx_mpos))
-	    || (!XDR_PUTUINT32(xdrs, cc->cc_proc))
+	if ((!clnt_req_marshal_hdr(cx, cc, xdrs))
 	    || (!AUTH_MARSHALL(cc->cc_auth, xdrs))
 	    || (!AUTH_WRAP(cc->cc_auth, xdrs,
 			   cc->cc_call.proc, cc->cc_call.where))) {
 		/* error case */
-		mutex_unlock(&clnt->cl_lock);
+		if (gss)
+			mutex_unlock(&clnt->cl_lock);
 		__warnx(TIRPC_DEBUG_FLAG_CLNT_VC,
 			"%s: fd %d failed",
 			__func__, xprt->xp_fd);
 		XDR_DESTROY(xdrs);
-		return (RPC_CANTENCODEARGS);
+		return (NULL);
 	}
-	mutex_unlock(&clnt->cl_lock);
+	if (gss)
+		mutex_unlock(&clnt->cl_lock);
+	clnt_window_charge(cx, cc, XDR_GETPOS(xdrs));
 
 	xdrs->x_lib[1] = (void *)xprt;
-	svc_ioq_write_submit(xprt, xioq);
+	return (xioq);
+}
+
+static enum clnt_stat
+clnt_vc_call(struct clnt_req *cc)
+{
+	struct xdr_ioq *xioq;
 
+	cc->cc_error.re_status = RPC_SUCCESS;
+
+	xioq = clnt_vc_encode(cc);
+	if (!xioq)
+		return (RPC_CANTENCODEARGS);
+
+	svc_ioq_write_submit(&CX_DATA(cc->cc_clnt)->cx_rec->xprt, xioq);
 	return (RPC_SUCCESS);
 }
 
+/*
+ * All on the same CLIENT.  Queued together, so the writer may send them
+ * in one sendmsg().
+ */
+static enum clnt_stat
+clnt_vc_call_batch(struct clnt_req **ccv, int count)
+{
+	struct xdr_ioq *xioqv[CLNT_BATCH_MAX];
+	SVCXPRT *xprt = &CX_DATA(ccv[0]->cc_clnt)->cx_rec->xprt;
+	enum clnt_stat stat = RPC_SUCCESS;
+	int i;
+	int n;
+
+	while (count > 0) {
+		for (i = 0, n = 0; i < count && i < CLNT_BATCH_MAX; i++) {
+			xioqv[n] = clnt_vc_encode(ccv[i]);
+			if (!xioqv[n]) {
+				ccv[i]->cc_error.re_status = RPC_CANTENCODEARGS;
+				stat = RPC_CANTENCODEARGS;
+				continue;
+			}
+			n++;
+		}
+		svc_ioq_write_submitv(xprt, xioqv, n);
+		ccv += i;
+		count -= i;
+	}
+	return (stat);
+}
+
 static bool
 clnt_vc_freeres(CLIENT *clnt, xdrproc_t xdr_res, void *res_ptr)
 {
@@ -415,19 +464,20 @@ clnt_vc_control(CLIENT *clnt, u_int request, void *info)
 		addr->maxlen = sizeof(ct->ct_raddr);
 		break;
 
+	case CLSET_WINDOW:
+	case CLGET_WINDOW:
+		rslt = clnt_window_control(cx, request, info);
+		break;
+
 	case CLGET_XID:
-		/*
-		 * use the knowledge that xid is the
-		 * first element in the call structure
-		 * This will get the xid of the PREVIOUS call
-		 */
-		uint32p = (u_int32_t *)&cx->cx_mcallc[0];
-		*(u_int32_t *)info = ntohl(*uint32p);
+		/* the xid of the PREVIOUS call on this channel */
+		*(u_int32_t *)info = atomic_fetch_uint32_t(&rec->call_xid);
 		break;
 
 	case CLSET_XID:
 		/* This will set the xid of the NEXT call */
-		rec->call_xid = htonl(*(u_int32_t *) info - 1);
+		atomic_store_uint32_t(&rec->call_xid,
+				      *(u_int32_t *)info - 1);
 		/* decrement by 1 as clnt_req_setup() increments once */
 		break;
 
@@ -509,6 +559,406 @@ clnt_vc_ops(void)
 		ops.cl_freeres = clnt_vc_freeres;
 		ops.cl_destroy = clnt_vc_destroy;
 		ops.cl_control = clnt_vc_control;
+		ops.cl_call_batch = clnt_vc_call_batch;
+	}
+	mutex_unlock(&ops_lock);
+	thr_sigsetmask(SIG_SETMASK, &(mask), NULL);
+	return (&ops);
+}
+
+/*
+ * Multi-connection (nconnect) client.
+ *
+ * One handle over cm_nconn connections ("legs") to the same server, each
+ * an ordinary clnt_vc CLIENT with its own channel, xids, and outstanding
+ * calls.  clnt_req_setup() asks cl_select for the leg of each call, which
+ * then carries the call and its reply without touching this handle.
+ *
+ * Each outstanding call holds a reference on its leg, so a leg's
+ * cl_refcnt (less the one held here) is its number of calls in flight.
+ * A leg whose transport is destroyed is replaced by a work pool task;
+ * calls already made on it fail as on any broken connection.
+ */
+#define CM_RECONNECT_MS		1000	/* between attempts, per leg */
+
+#define CM_LEG_FLAG_NONE	0x0000
+#define CM_LEG_FLAG_RECONNECT	0x0001
+
+struct cm_leg {
+	struct work_pool_entry lg_wpe;	/* reconnect task */
+	struct cm_data *lg_cm;
+	CLIENT *lg_clnt;
+	int32_t lg_retry_ms;		/* next reconnect (monotonic) */
+	uint16_t lg_flags;
+};
+
+struct cm_data {
+	struct rpc_client cm_c;		/**< Transport Independent handle */
+	rwlock_t cm_lock;		/* legs, prog and vers */
+	struct sockaddr_storage cm_raddr;	/* remote addr */
+	u_int cm_rlen;
+	rpcprog_t cm_prog;
+	rpcvers_t cm_vers;
+	u_int cm_sendsz;
+	u_int cm_recvsz;
+	uint32_t cm_flags;
+	uint32_t cm_next;		/* round robin, or tie break */
+	struct clnt_window cm_window;	/* of each leg */
+	u_int cm_nconn;
+	struct cm_leg cm_legs[];
+};
+#define CM_DATA(p) (opr_containerof((p), struct cm_data, cm_c))
+
+static struct clnt_ops *clnt_vc_multi_ops(void);
+
+/*
+ * Connect a new leg, or NULL with the reason in err.
+ */
+static CLIENT *
+clnt_vc_multi_connect(struct cm_data *cm, rpcprog_t prog, rpcvers_t vers,
+		      struct rpc_err *err)
+{
+	struct netbuf raddr;
+	CLIENT *clnt;
+	int fd;
+
+	fd = socket(cm->cm_raddr.ss_family, SOCK_STREAM, 0);
+	if (fd < 0) {
+		err->re_status = RPC_SYSTEMERROR;
+		err->re_errno = errno;
+		return (NULL);
+	}
+
+	raddr.buf = &cm->cm_raddr;
+	raddr.len = raddr.maxlen = cm->cm_rlen;
+	clnt = clnt_vc_ncreatef(fd, &raddr, prog, vers,
+				cm->cm_sendsz, cm->cm_recvsz,
+				CLNT_CREATE_FLAG_CONNECT |
+				CLNT_CREATE_FLAG_CLOSE);
+
+	if (CLNT_FAILURE(clnt)) {
+		*err = clnt->cl_error;
+		if (CX_DATA(clnt)->cx_rec) {
+			/* the transport owns the fd */
+			SVC_DESTROY(&CX_DATA(clnt)->cx_rec->xprt);
+		} else {
+			(void)close(fd);
+		}
+		CLNT_DESTROY(clnt);
+		return (NULL);
+	}
+
+	/* the leg owns its transport (and fd) */
+	clnt->cl_flags |= CLNT_FLAG_LOCAL;
+	return (clnt);
+}
+
+static void
+clnt_vc_multi_reconnect_task(struct work_pool_entry *wpe)
+{
+	struct cm_leg *lg = opr_containerof(wpe, struct cm_leg, lg_wpe);
+	struct cm_data *cm = lg->lg_cm;
+	CLIENT *clnt = NULL;
+	CLIENT *old;
+	struct rpc_err err;
+	struct timespec ts;
+	rpcprog_t prog;
+	rpcvers_t vers;
+
+	rwlock_rdlock(&cm->cm_lock);
+	prog = cm->cm_prog;
+	vers = cm->cm_vers;
+	rwlock_unlock(&cm->cm_lock);
+
+	if (!(atomic_fetch_uint16_t(&cm->cm_c.cl_flags)
+	      & CLNT_FLAG_DESTROYING))
+		clnt = clnt_vc_multi_connect(cm, prog, vers, &err);
+
+	if (clnt) {
+		rwlock_wrlock(&cm->cm_lock);
+		/* changed while connecting? */
+		if (cm->cm_prog != prog)
+			(void)CLNT_CONTROL(clnt, CLSET_PROG, &cm->cm_prog);
+		if (cm->cm_vers != vers)
+			(void)CLNT_CONTROL(clnt, CLSET_VERS, &cm->cm_vers);
+		if (cm->cm_window.cw_calls || cm->cm_window.cw_bytes)
+			(void)CLNT_CONTROL(clnt, CLSET_WINDOW,
+					   &cm->cm_window);
+		old = lg->lg_clnt;
+		lg->lg_clnt = clnt;
+		rwlock_unlock(&cm->cm_lock);
+
+		__warnx(TIRPC_DEBUG_FLAG_CLNT_VC,
+			"%s: %p leg %td reconnected fd %d",
+			__func__, &cm->cm_c, lg - cm->cm_legs,
+			CX_DATA(clnt)->cx_rec->xprt.xp_fd);
+		CLNT_DESTROY(old);
+	} else {
+		__warnx(TIRPC_DEBUG_FLAG_CLNT_VC,
+			"%s: %p leg %td reconnect failed",
+			__func__, &cm->cm_c, lg - cm->cm_legs);
+		(void)clock_gettime(CLOCK_MONOTONIC_FAST, &ts);
+		atomic_store_int32_t(&lg->lg_retry_ms,
+				     timespec_ms(&ts) + CM_RECONNECT_MS);
+	}
+
+	atomic_clear_uint16_t_bits(&lg->lg_flags, CM_LEG_FLAG_RECONNECT);
+	CLNT_RELEASE(&cm->cm_c, CLNT_RELEASE_FLAG_NONE);
+}
+
+/*
+ * Called with cm_lock held (read).
+ */
+static void
+clnt_vc_multi_reconnect(struct cm_data *cm, struct cm_leg *lg)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &ts);
+	if ((int32_t)((uint32_t)timespec_ms(&ts)
+		      - (uint32_t)atomic_fetch_int32_t(&lg->lg_retry_ms)) < 0)
+		return;
+
+	if (atomic_postset_uint16_t_bits(&lg->lg_flags, CM_LEG_FLAG_RECONNECT)
+	    & CM_LEG_FLAG_RECONNECT) {
+		/* already pending */
+		return;
+	}
+
+	CLNT_REF(&cm->cm_c, CLNT_REF_FLAG_NONE);
+	lg->lg_wpe.fun = clnt_vc_multi_reconnect_task;
+	lg->lg_wpe.arg = NULL;
+	work_pool_submit(&svc_work_pool, &lg->lg_wpe);
+}
+
+static CLIENT *
+clnt_vc_multi_select(CLIENT *clnt)
+{
+	struct cm_data *cm = CM_DATA(clnt);
+	struct cm_leg *lg;
+	CLIENT *best = NULL;
+	int32_t least = INT32_MAX;
+	int32_t refs;
+	u_int start = atomic_inc_uint32_t(&cm->cm_next) % cm->cm_nconn;
+	u_int i;
+
+	rwlock_rdlock(&cm->cm_lock);
+	for (i = 0; i < cm->cm_nconn; i++) {
+		lg = &cm->cm_legs[(start + i) % cm->cm_nconn];
+
+		if (!lg->lg_clnt) {
+			/* failed handle */
+			continue;
+		}
+		if (atomic_fetch_uint16_t(&CX_DATA(lg->lg_clnt)->cx_rec
+					  ->xprt.xp_flags)
+		    & SVC_XPRT_FLAG_DESTROYED) {
+			clnt_vc_multi_reconnect(cm, lg);
+			continue;
+		}
+		if (cm->cm_flags & CLNT_CREATE_FLAG_ROUND_ROBIN) {
+			best = lg->lg_clnt;
+			break;
+		}
+		refs = atomic_fetch_int32_t(&lg->lg_clnt->cl_refcnt);
+		if (refs < least) {
+			least = refs;
+			best = lg->lg_clnt;
+			if (refs <= 1)
+				break;	/* idle */
+		}
+	}
+	if (!best) {
+		/* none connected; fail as a single connection would */
+		best = cm->cm_legs[start].lg_clnt;
+	}
+	if (best)
+		CLNT_REF(best, CLNT_REF_FLAG_NONE);
+	rwlock_unlock(&cm->cm_lock);
+
+	return (best);
+}
+
+/*
+ * Create a client handle over nconn connections to raddr.
+ * The connections are made here; all must succeed.  Otherwise, those
+ * already made are closed, and the handle (CLNT_FAILURE) has no legs.
+ */
+CLIENT *
+clnt_vc_ncreate_multi(const struct netbuf *raddr,	/* servers address */
+		      const rpcprog_t prog,	/* program number */
+		      const rpcvers_t vers,	/* version number */
+		      const u_int sendsz,	/* buffer send size */
+		      const u_int recvsz,	/* buffer recv size */
+		      const u_int nconn,	/* number of connections */
+		      const uint32_t flags)
+{
+	u_int n = nconn ? nconn : 1;
+	struct cm_data *cm = mem_zalloc(sizeof(struct cm_data)
+					+ n * sizeof(struct cm_leg));
+	CLIENT *clnt = &cm->cm_c;
+	u_int i;
+
+	mutex_init(&clnt->cl_lock, NULL);
+	clnt->cl_refcnt = 1;
+	clnt->cl_ops = clnt_vc_multi_ops();
+	rwlock_init(&cm->cm_lock, NULL);
+	cm->cm_nconn = n;
+	for (i = 0; i < n; i++)
+		cm->cm_legs[i].lg_cm = cm;
+
+	if (raddr == NULL
+	 || sizeof(struct sockaddr_storage) < raddr->len) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: missing or invalid servers address",
+			__func__);
+		clnt->cl_error.re_status = RPC_UNKNOWNADDR;
+		return (clnt);
+	}
+	memcpy(&cm->cm_raddr, raddr->buf, raddr->len);
+	cm->cm_rlen = raddr->len;
+	cm->cm_prog = prog;
+	cm->cm_vers = vers;
+	cm->cm_sendsz = sendsz;
+	cm->cm_recvsz = recvsz;
+	cm->cm_flags = flags;
+
+	for (i = 0; i < n; i++) {
+		cm->cm_legs[i].lg_clnt =
+			clnt_vc_multi_connect(cm, prog, vers, &clnt->cl_error);
+		if (!cm->cm_legs[i].lg_clnt) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: %p leg %u of %u failed (%d)",
+				__func__, clnt, i, n,
+				clnt->cl_error.re_status);
+			while (i > 0) {
+				CLNT_DESTROY(cm->cm_legs[--i].lg_clnt);
+				cm->cm_legs[i].lg_clnt = NULL;
+			}
+			return (clnt);
+		}
+	}
+
+	__warnx(TIRPC_DEBUG_FLAG_CLNT_VC,
+		"%s: %p %u connections completed",
+		__func__, clnt, n);
+	return (clnt);
+}
+
+static enum clnt_stat
+clnt_vc_multi_call(struct clnt_req *cc)
+{
+	/* clnt_req_setup() hands every call to a leg */
+	__warnx(TIRPC_DEBUG_FLAG_ERROR,
+		"%s: %p call without clnt_req_setup()",
+		__func__, cc->cc_clnt);
+	return (RPC_SYSTEMERROR);
+}
+
+static bool
+clnt_vc_multi_control(CLIENT *clnt, u_int request, void *info)
+{
+	struct cm_data *cm = CM_DATA(clnt);
+	struct netbuf *addr;
+	bool rslt = true;
+	u_int i;
+
+	switch (request) {
+	case CLSET_FD_CLOSE:
+	case CLSET_FD_NCLOSE:
+		/* its connections are always its own */
+		return (true);
+	default:
+		break;
+	}
+
+	/* for other requests which use info */
+	if (info == NULL)
+		return (false);
+
+	switch (request) {
+	case CLGET_SERVER_ADDR:
+		/* Now obsolete. Only for backward compatibility */
+		(void)memcpy(info, &cm->cm_raddr, (size_t) cm->cm_rlen);
+		break;
+	case CLGET_SVC_ADDR:
+		/* The caller should not free this memory area */
+		addr = (struct netbuf *)info;
+		addr->buf = &cm->cm_raddr;
+		addr->len = cm->cm_rlen;
+		addr->maxlen = sizeof(cm->cm_raddr);
+		break;
+
+	case CLSET_PROG:
+	case CLSET_VERS:
+	case CLSET_XID:
+	case CLSET_WINDOW:
+		/* every leg, and any reconnected later */
+		rwlock_wrlock(&cm->cm_lock);
+		if (request == CLSET_PROG)
+			cm->cm_prog = *(u_int32_t *)info;
+		else if (request == CLSET_VERS)
+			cm->cm_vers = *(u_int32_t *)info;
+		else if (request == CLSET_WINDOW)
+			cm->cm_window = *(struct clnt_window *)info;
+		for (i = 0; i < cm->cm_nconn; i++) {
+			if (!cm->cm_legs[i].lg_clnt
+			    || !CLNT_CONTROL(cm->cm_legs[i].lg_clnt, request,
+					     info))
+				rslt = false;
+		}
+		rwlock_unlock(&cm->cm_lock);
+		break;
+
+	default:
+		/* the first leg answers for all (CLGET_FD, CLGET_XID...) */
+		rwlock_rdlock(&cm->cm_lock);
+		rslt = cm->cm_legs[0].lg_clnt
+			&& CLNT_CONTROL(cm->cm_legs[0].lg_clnt, request, info);
+		rwlock_unlock(&cm->cm_lock);
+		break;
+	}
+
+	return (rslt);
+}
+
+static void
+clnt_vc_multi_destroy(CLIENT *clnt)
+{
+	struct cm_data *cm = CM_DATA(clnt);
+	u_int i;
+
+	/* outstanding calls hold their legs */
+	for (i = 0; i < cm->cm_nconn; i++) {
+		if (cm->cm_legs[i].lg_clnt)
+			CLNT_DESTROY(cm->cm_legs[i].lg_clnt);
+	}
+
+	rwlock_destroy(&cm->cm_lock);
+	mutex_destroy(&clnt->cl_lock);
+	mem_free(cm, sizeof(struct cm_data)
+		     + cm->cm_nconn * sizeof(struct cm_leg));
+}
+
+static struct clnt_ops *
+clnt_vc_multi_ops(void)
+{
+	static struct clnt_ops ops;
+	extern mutex_t ops_lock;
+	sigset_t mask, newmask;
+
+	/* VARIABLES PROTECTED BY ops_lock: ops */
+
+	sigfillset(&newmask);
+	thr_sigsetmask(SIG_SETMASK, &newmask, &mask);
+	mutex_lock(&ops_lock);
+	if (ops.cl_call == NULL) {
+		ops.cl_call = clnt_vc_multi_call;
+		ops.cl_abort = clnt_vc_abort;
+		ops.cl_freeres = clnt_vc_freeres;
+		ops.cl_destroy = clnt_vc_multi_destroy;
+		ops.cl_control = clnt_vc_multi_control;
+		ops.cl_select = clnt_vc_multi_select;
 	}
 	mutex_unlock(&ops_lock);
 	thr_sigsetmask(SIG_SETMASK, &(mask), NULL);
@@ -1,4 +1,4 @@
-NTIRPC_${NTIRPC_VERSION_BASE} {
+NTIRPC_6.0.1 {
   global:
     # __*
     __ntirpc_pkg_params;
@@ -230,6 +230,39 @@ NTIRPC_${NTIRPC_VERSION_BASE} {
     *;
 };
 
+NTIRPC_${NTIRPC_VERSION_BASE} {
+  global:
+    # c*
+    clnt_cache_flush;
+    clnt_cache_ncreate_timed;
+    clnt_cache_release;
+    clnt_cq_attach;
+    clnt_cq_complete;
+    clnt_cq_create;
+    clnt_cq_destroy;
+    clnt_cq_fd;
+    clnt_cq_poll;
+    clnt_req_submit_batch;
+    clnt_vc_ncreate_multi;
+
+    # s*
+    svc_dg_ncreate_reuseport;
+
+    # x*
+    xdr_arena_create;
+    xdr_arena_destroy;
+    xdr_arena_grow;
+    xdr_bulk;
+    xdr_bytes_ref;
+    xdr_opaque_ref;
+    xdr_sizeof;
+    xdr_swap32;
+    xdr_swap64;
+    xdr_uint32_vector;
+    xdr_uint64_vector;
+    xdrsize_create;
+} NTIRPC_6.0.1;
+
 NTIRPC_PRIVATE {
   global:
   global_foo_bar;
@@ -35,6 +35,9 @@
  */
 
 #include "config.h"
+
+#define XDR_DIRECT	/* opaque_auth bodies in line */
+
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
@@ -42,6 +45,7 @@
 #include <rpc/rpc.h>
 #include <rpc/xdr_inline.h>
 #include <rpc/auth_inline.h>
+#include "rpc_com.h"
 
 #include <sys/select.h>
 
@@ -188,9 +192,12 @@ xdr_call_encode(XDR *xdrs, struct rpc_msg *cmsg)
  * decode a call message, log error messages
  *
  * param[IN]	buf	3 more inline
+ * param[OUT]	cred	when not NULL, the credential body may be borrowed
+ *			(xdr_opaque_auth_decode_ref), and is set there
  */
 bool
-xdr_call_decode(XDR *xdrs, struct rpc_msg *cmsg, int32_t *buf)
+xdr_call_decode_ref(XDR *xdrs, struct rpc_msg *cmsg, int32_t *buf,
+		    char **cred)
 {
 	if (buf != NULL) {
 		__warnx(TIRPC_DEBUG_FLAG_RPC_MSG,
@@ -235,7 +242,11 @@ xdr_call_decode(XDR *xdrs, struct rpc_msg *cmsg, int32_t *buf)
 	buf = xdr_inline_decode(xdrs, 3 * BYTES_PER_XDR_UNIT);
 	if (buf != NULL) {
 		cmsg->cb_proc = IXDR_GET_U_INT32(buf);
-		if (!xdr_opaque_auth_decode(xdrs, &(cmsg->cb_cred), buf)) {
+		if (!(cred
+		      ? xdr_opaque_auth_decode_ref(xdrs, &(cmsg->cb_cred),
+						   cred, buf)
+		      : xdr_opaque_auth_decode(xdrs, &(cmsg->cb_cred),
+					       buf))) {
 			__warnx(TIRPC_DEBUG_FLAG_ERROR,
 				"%s:%u ERROR (return)",
 				__func__, __LINE__);
@@ -246,7 +257,11 @@ xdr_call_decode(XDR *xdrs, struct rpc_msg *cmsg, int32_t *buf)
 			"%s:%u ERROR cb_proc",
 			__func__, __LINE__);
 		return (false);
-	} else if (!xdr_opaque_auth_decode(xdrs, &(cmsg->cb_cred), NULL)) {
+	} else if (!(cred
+		     ? xdr_opaque_auth_decode_ref(xdrs, &(cmsg->cb_cred),
+						  cred, NULL)
+		     : xdr_opaque_auth_decode(xdrs, &(cmsg->cb_cred),
+					      NULL))) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s:%u ERROR (return)",
 			__func__, __LINE__);
@@ -262,6 +277,12 @@ xdr_call_decode(XDR *xdrs, struct rpc_msg *cmsg, int32_t *buf)
 	return (true);
 }
 
+bool
+xdr_call_decode(XDR *xdrs, struct rpc_msg *cmsg, int32_t *buf)
+{
+	return (xdr_call_decode_ref(xdrs, cmsg, buf, NULL));
+}
+
 /*
  * XDR a call message, log error messages
  */
@@ -82,6 +82,10 @@ struct netbuf *__rpcb_findaddr_timed(rpcprog_t, rpcvers_t,
 
 bool __rpc_control(int, void *);
 
+/* borrowing call decodes, for the svc transports */
+bool xdr_call_decode_ref(XDR *, struct rpc_msg *, int32_t *, char **);
+bool xdr_dplx_decode_ref(XDR *, struct rpc_msg *, char **);
+
 char *_get_next_token(char *, int);
 
 __END_DECLS
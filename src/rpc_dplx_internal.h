@@ -29,6 +29,7 @@
 
 #include <misc/queue.h>
 #include <misc/rbtree.h>
+#include <misc/rbtree_x.h>
 #include <misc/wait_queue.h>
 #include <rpc/svc.h>
 #include <rpc/xdr_ioq.h>
@@ -55,7 +56,7 @@ struct rpc_dplx_rec {
 	struct svc_xprt xprt;		/**< Transport Independent handle */
 	struct xdr_ioq ioq;
 	struct poolq_head writeq;	/**< poolq for write requests */
-	struct opr_rbtree call_replies;
+	struct rbtree_x call_replies;	/**< by xid, on first call */
 	struct opr_rbtree_node fd_node;
 	struct {
 		rpc_dplx_lock_t lock;
@@ -87,9 +88,13 @@ struct rpc_dplx_rec {
 	uint32_t call_xid;		/**< current call xid */
 	uint32_t ev_count;		/**< atomic count of waiting events */
 	struct svc_req *svc_req;	/**< svc_req we are processing */
+	struct rpc_xprt_mem_stat mem;	/**< (atomic) memory budget */
 };
 #define REC_XPRT(p) (opr_containerof((p), struct rpc_dplx_rec, xprt))
 
+/* call_replies partitions (small prime), each with its own spinlock */
+#define RPC_DPLX_CALL_PARTS	7
+
 /* > SVC_XPRT_FLAG_LOCKED */
 #define RPC_DPLX_LOCKED		0x00100000
 #define RPC_DPLX_UNLOCK		0x00200000
@@ -117,7 +122,6 @@ static inline void
 rpc_dplx_rec_init(struct rpc_dplx_rec *rec)
 {
 	rpc_dplx_lock_init(&rec->recv.lock);
-	opr_rbtree_init(&rec->call_replies, clnt_req_xid_cmpf);
 	mutex_init(&rec->xprt.xp_lock, NULL);
 	TAILQ_INIT(&rec->writeq.qh);
 	mutex_init(&rec->writeq.qmutex, NULL);
@@ -134,6 +138,7 @@ rpc_dplx_rec_destroy(struct rpc_dplx_rec *rec)
 	rpc_dplx_lock_destroy(&rec->recv.lock);
 	mutex_destroy(&rec->xprt.xp_lock);
 	mutex_destroy(&rec->writeq.qmutex);
+	rbtx_cleanup(&rec->call_replies);
 
 #if defined(HAVE_BLKIN)
 	if (rec->xprt.blkin.svc_name)
@@ -48,6 +48,7 @@
 #include <rpc/rpc.h>
 #include <rpc/xdr_inline.h>
 #include <rpc/auth_inline.h>
+#include "rpc_com.h"
 
 static const struct xdr_discrim reply_dscrm[3] = {
 	{(int)MSG_ACCEPTED, (xdrproc_t) xdr_naccepted_reply},
@@ -425,9 +426,11 @@ xdr_reply_decode(XDR *xdrs, struct rpc_msg *dmsg, int32_t *buf)
 
 /*
  * decode a duplex message, log error messages
+ *
+ * param[OUT]	cred	see xdr_call_decode_ref()
  */
 bool
-xdr_dplx_decode(XDR *xdrs, struct rpc_msg *dmsg)
+xdr_dplx_decode_ref(XDR *xdrs, struct rpc_msg *dmsg, char **cred)
 {
 	int32_t *buf;
 
@@ -455,7 +458,7 @@ xdr_dplx_decode(XDR *xdrs, struct rpc_msg *dmsg)
 
 	switch (dmsg->rm_direction) {
 	case CALL:
-		return (xdr_call_decode(xdrs, dmsg, buf));
+		return (xdr_call_decode_ref(xdrs, dmsg, buf, cred));
 	case REPLY:
 		return (xdr_reply_decode(xdrs, dmsg, buf));
 	default:
@@ -469,6 +472,12 @@ xdr_dplx_decode(XDR *xdrs, struct rpc_msg *dmsg)
 	return (false);
 }
 
+bool
+xdr_dplx_decode(XDR *xdrs, struct rpc_msg *dmsg)
+{
+	return (xdr_dplx_decode_ref(xdrs, dmsg, NULL));
+}
+
 /*
  * XDR a duplex message
  */
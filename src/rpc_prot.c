@@ -40,6 +40,9 @@
  */
 
 #include "config.h"
+
+#define XDR_DIRECT	/* opaque_auth bodies in line */
+
 #include <sys/param.h>
 
 #include <assert.h>
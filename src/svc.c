@@ -176,6 +176,8 @@ svc_init(svc_init_params *params)
 	else
 		__svc_params->ioq.send_max = RPC_MAXDATA_DEFAULT;
 
+	__svc_params->dg.batch = SVC_DG_BATCH_DEFAULT;
+
 	__svc_params->ioq.thrd_min = SVC_WORK_POOL_THRD_MIN;
 	if (__svc_params->ioq.thrd_min < params->ioq_thrd_min)
 		__svc_params->ioq.thrd_min = params->ioq_thrd_min;
@@ -675,6 +677,60 @@ rpc_control(int what, void *arg)
 	case RPC_SVC_CONNMAXREC_GET:
 		*(int *)arg = __svc_maxrec;
 		break;
+	case RPC_SVC_IOQ_POOL_GET:
+	case RPC_SVC_IOQ_POOL_SET:
+		return xdr_ioq_pool_control(what, arg);
+	case RPC_SVC_IOQ_TRIM:
+		(void)xdr_ioq_pool_trim();
+		break;
+	case RPC_SVC_MEM_BUDGET_GET:
+	case RPC_SVC_MEM_BUDGET_SET:
+		return svc_ioq_budget_control(what, arg);
+	case RPC_SVC_DG_BATCH_SET:
+		val = *(int *)arg;
+		if (val <= 0 || val > SVC_DG_BATCH_MAX)
+			return false;
+		__svc_params->dg.batch = val;
+		break;
+	case RPC_SVC_DG_BATCH_GET:
+		*(int *)arg = __svc_params->dg.batch;
+		break;
+	case RPC_SVC_DG_OFFLOAD_SET:
+		val = *(int *)arg;
+		if (val & ~(RPC_DG_OFFLOAD_GRO | RPC_DG_OFFLOAD_GSO))
+			return false;
+		__svc_params->dg.offload = val;
+		break;
+	case RPC_SVC_DG_OFFLOAD_GET:
+		*(int *)arg = __svc_params->dg.offload;
+		break;
+	case RPC_SVC_CLNT_SPIN_SET:
+		val = *(int *)arg;
+		if (val < 0)
+			return false;
+		__svc_params->clnt.spin = val;
+		break;
+	case RPC_SVC_CLNT_SPIN_GET:
+		*(int *)arg = __svc_params->clnt.spin;
+		break;
+	case RPC_SVC_CLNT_CACHE_GET:
+	case RPC_SVC_CLNT_CACHE_SET:
+		return clnt_cache_control(what, arg);
+	case RPC_SVC_XDR_ARENA_SET:
+		val = *(int *)arg;
+		if (val < 0)
+			return false;
+		__svc_params->req.arena = val;
+		break;
+	case RPC_SVC_XDR_ARENA_GET:
+		*(int *)arg = __svc_params->req.arena;
+		break;
+	case RPC_SVC_XDR_SIZING_SET:
+		__svc_params->req.sizing = !!*(int *)arg;
+		break;
+	case RPC_SVC_XDR_SIZING_GET:
+		*(int *)arg = __svc_params->req.sizing;
+		break;
 	default:
 		return (false);
 	}
@@ -325,6 +325,14 @@ svcauth_gss_release_cred(void)
 	return (true);
 }
 
+/* unless decoded into the request arena */
+static inline void
+svcauth_gss_free_tok(struct svc_req *req, gss_buffer_desc *tok)
+{
+	if (!req->rq_arena)
+		xdr_free((xdrproc_t)xdr_rpc_gss_init_args, (void *)tok);
+}
+
 static bool
 svcauth_gss_accept_sec_context(struct svc_req *req,
 			       struct svc_rpc_gss_data *gd,
@@ -346,7 +354,7 @@ svcauth_gss_accept_sec_context(struct svc_req *req,
 	req->rq_msg.rm_xdr.where = &recv_tok;
 	req->rq_msg.rm_xdr.proc = (xdrproc_t)xdr_rpc_gss_init_args;
 	if (!SVCAUTH_UNWRAP(req)) {
-		xdr_free((xdrproc_t)xdr_rpc_gss_init_args, (void *)&recv_tok);
+		svcauth_gss_free_tok(req, &recv_tok);
 		return (false);
 	}
 
@@ -355,7 +363,7 @@ svcauth_gss_accept_sec_context(struct svc_req *req,
 	/* We can not accept incoming context, if server gss-creds are NULL. */
 	if (server_creds.gss_creds == NULL) {
 		rwlock_unlock(&server_creds.gss_creds_lock);
-		xdr_free((xdrproc_t)xdr_rpc_gss_init_args, (void *)&recv_tok);
+		svcauth_gss_free_tok(req, &recv_tok);
 		return false;
 	}
 
@@ -365,7 +373,7 @@ svcauth_gss_accept_sec_context(struct svc_req *req,
 		&ret_flags, &time_rec, NULL);
 	rwlock_unlock(&server_creds.gss_creds_lock);
 
-	xdr_free((xdrproc_t)xdr_rpc_gss_init_args, (void *)&recv_tok);
+	svcauth_gss_free_tok(req, &recv_tok);
 
 	if ((gr->gr_major != GSS_S_COMPLETE)
 	    && (gr->gr_major != GSS_S_CONTINUE_NEEDED)) {
@@ -489,7 +497,7 @@ svcauth_gss_validate(struct svc_req *req,
 	IXDR_PUT_ENUM(buf, oa->oa_flavor);
 	IXDR_PUT_LONG(buf, oa->oa_length);
 	if (oa->oa_length) {
-		memcpy(buf, oa->oa_body, oa->oa_length);
+		memcpy(buf, req->rq_cred_ref, oa->oa_length);
 		buf += RNDUP(oa->oa_length) / sizeof(int32_t);
 	}
 	rpcbuf.value = rpchdr;
@@ -618,7 +626,7 @@ _svcauth_gss(struct svc_req *req, bool *no_dispatch)
 	gc = (struct rpc_gss_cred *)req->rq_msg.rq_cred_body;
 	memset(gc, 0, sizeof(struct rpc_gss_cred));
 
-	xdrmem_create(xdrs, req->rq_msg.cb_cred.oa_body,
+	xdrmem_create(xdrs, req->rq_cred_ref,
 		      req->rq_msg.cb_cred.oa_length, XDR_DECODE);
 
 	if (!xdr_rpc_gss_cred(xdrs, gc)) {
@@ -76,7 +76,7 @@ _svcauth_unix(struct svc_req *req)
 	aup->aup_machname = area->area_machname;
 	aup->aup_gids = area->area_gids;
 	auth_len = (u_int) req->rq_msg.cb_cred.oa_length;
-	xdrmem_create(&xdrs, req->rq_msg.cb_cred.oa_body, auth_len,
+	xdrmem_create(&xdrs, req->rq_cred_ref, auth_len,
 		      XDR_DECODE);
 	buf = xdr_inline_decode(&xdrs, auth_len);
 	if (buf != NULL) {
@@ -99,9 +99,8 @@ _svcauth_unix(struct svc_req *req)
 			goto done;
 		}
 		aup->aup_len = gid_len;
+		xdr_swap32((uint32_t *)aup->aup_gids, (uint32_t *)buf, gid_len);
 		for (i = 0; i < gid_len; i++) {
-			/* suppress block warning */
-			aup->aup_gids[i] = (int)IXDR_GET_INT32(buf);
 			if (aup->aup_gids[i] == (gid_t)-1) {
 				stat = AUTH_BADCRED;
 				goto done;
@@ -61,6 +61,7 @@
 #include <string.h>
 #include <netconfig.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <err.h>
 
 #include "rpc_com.h"
@@ -78,7 +79,11 @@ static void svc_dg_rendezvous_ops(SVCXPRT *);
 static void svc_dg_override_ops(SVCXPRT *, SVCXPRT *);
 
 static void svc_dg_enable_pktinfo(int, const struct __rpc_sockinfo *);
+static void svc_dg_enable_offload(int, struct svc_dg_xprt *);
+static int svc_dg_gro_size(struct msghdr *);
 static int svc_dg_store_pktinfo(struct msghdr *, SVCXPRT *);
+static void svc_dg_reply_flush(struct svc_dg_xprt *);
+static void svc_dg_reply_done(SVCXPRT *, SVCXPRT *);
 
 /*
  * Usage:
@@ -91,21 +96,41 @@ static int svc_dg_store_pktinfo(struct msghdr *, SVCXPRT *);
 static void
 svc_dg_xprt_free(struct svc_dg_xprt *su)
 {
+	struct poolq_entry *have;
+
+	if (su->su_replies) {
+		/* rendezvous */
+		while ((have = TAILQ_FIRST(&su->su_pool.qh))) {
+			TAILQ_REMOVE(&su->su_pool.qh, have, q);
+			svc_dg_xprt_free(opr_containerof(have,
+					struct svc_dg_xprt, su_dr.ioq.ioq_s));
+		}
+		poolq_head_destroy(&su->su_pool);
+		mutex_destroy(&su->su_reply_lock);
+		mem_free(su->su_replies,
+			 SVC_DG_BATCH_MAX * sizeof(struct svc_dg_xprt *));
+	}
 	XDR_DESTROY(su->su_dr.ioq.xdrs);
 	rpc_dplx_rec_destroy(&su->su_dr);
 	mem_free(su, sizeof(struct svc_dg_xprt) + su->su_dr.maxrec);
 }
 
-static struct svc_dg_xprt *
-svc_dg_xprt_zalloc(size_t iosz)
+static void
+svc_dg_xprt_init(struct svc_dg_xprt *su)
 {
-	struct svc_dg_xprt *su = mem_zalloc(sizeof(struct svc_dg_xprt) + iosz);
-
 	/* Init SVCXPRT locks, etc */
 	rpc_dplx_rec_init(&su->su_dr);
 	/* Extra ref to match TCP */
 	SVC_REF(&su->su_dr.xprt, SVC_REF_FLAG_NONE);
 	xdr_ioq_setup(&su->su_dr.ioq);
+}
+
+static struct svc_dg_xprt *
+svc_dg_xprt_zalloc(size_t iosz)
+{
+	struct svc_dg_xprt *su = mem_zalloc(sizeof(struct svc_dg_xprt) + iosz);
+
+	svc_dg_xprt_init(su);
 	return (su);
 }
 
@@ -200,11 +225,22 @@ svc_dg_ncreatef(const int fd, const u_int sendsz, const u_int recvsz,
 	/* duplex streams are not used by the rendezvous transport */
 	xdrmem_create(su->su_dr.ioq.xdrs, NULL, 0, XDR_ENCODE);
 
+	/* request transports are recycled here */
+	poolq_head_setup(&su->su_pool);
+
+	/* replies are queued here for sendmmsg() */
+	mutex_init(&su->su_reply_lock, NULL);
+	su->su_replies = mem_alloc(SVC_DG_BATCH_MAX
+				   * sizeof(struct svc_dg_xprt *));
+
 	svc_dg_rendezvous_ops(xprt);
 
 	/* Enable reception of IP*_PKTINFO control msgs */
 	svc_dg_enable_pktinfo(fd, &si);
 
+	/* Optional UDP_GRO and UDP_SEGMENT */
+	svc_dg_enable_offload(fd, su);
+
 	/* Conditional register */
 	if ((!(__svc_params->flags & SVC_FLAG_NOREG_XPRTS)
 	     && !(flags & SVC_CREATE_FLAG_XPRT_NOREG))
@@ -224,6 +260,132 @@ svc_dg_ncreatef(const int fd, const u_int sendsz, const u_int recvsz,
 	return (xprt);
 }
 
+#if defined(SO_REUSEPORT)
+/*
+ * Destroy a rendezvous transport just created by svc_dg_ncreatef(),
+ * dropping both the svc_xprt_lookup() and the svc_dg_xprt_init()
+ * references, so that its socket is closed.
+ */
+static void
+svc_dg_unwind(SVCXPRT *xprt)
+{
+	SVC_DESTROY(xprt);
+	SVC_RELEASE(xprt, SVC_RELEASE_FLAG_NONE);
+	SVC_RELEASE(xprt, SVC_RELEASE_FLAG_NONE);
+}
+#endif
+
+/*
+ * Open count SO_REUSEPORT sockets bound to the same address, each with
+ * its own rendezvous transport.  The kernel spreads incoming datagrams
+ * across the sockets by flow, and replies go out through the socket
+ * that received the request.
+ *
+ * rendezvous_cb is set on each transport before it is registered.
+ * Unless SVC_CREATE_FLAG_XPRT_NOREG is given, each transport is
+ * registered on a new event channel, so receive is no longer serialized
+ * on one socket; those channels are deleted by svc_shutdown().
+ * Otherwise, the caller registers each transport.
+ *
+ * On any failure, the transports and channels already created are
+ * destroyed, and nothing is stored in xprts[].
+ *
+ * @return count, 0 on failure.
+ */
+int
+svc_dg_ncreate_reuseport(const struct sockaddr *addr, const socklen_t addrlen,
+			 const u_int sendsz, const u_int recvsz,
+			 const uint32_t flags, const u_int count,
+			 svc_xprt_fun_t rendezvous_cb, SVCXPRT **xprts)
+{
+#if defined(SO_REUSEPORT)
+	SVCXPRT *xprt;
+	uint32_t *chans;
+	uint32_t chan_id;
+	u_int nchans = 0;
+	int on = 1;
+	int fd;
+	u_int n;
+
+	if (!count)
+		return (0);
+
+	chans = mem_alloc(count * sizeof(uint32_t));
+
+	for (n = 0; n < count; n++) {
+		fd = socket(addr->sa_family, SOCK_DGRAM, IPPROTO_UDP);
+		if (fd < 0) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: socket %u of %u failed (%d)",
+				__func__, n, count, errno);
+			goto unwind;
+		}
+		if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on))
+		    || bind(fd, addr, addrlen)) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: fd %d reuseport bind failed (%d)",
+				__func__, fd, errno);
+			close(fd);
+			goto unwind;
+		}
+
+		xprt = svc_dg_ncreatef(fd, sendsz, recvsz,
+				       flags | SVC_CREATE_FLAG_CLOSE
+				       | SVC_CREATE_FLAG_XPRT_NOREG);
+		if (!xprt) {
+			close(fd);
+			goto unwind;
+		}
+		xprt->xp_dispatch.rendezvous_cb = rendezvous_cb;
+
+		if (flags & SVC_CREATE_FLAG_XPRT_NOREG) {
+			xprts[n] = xprt;
+			continue;
+		}
+
+		if (svc_rqst_new_evchan(&chan_id, NULL,
+					SVC_RQST_FLAG_CHAN_AFFINITY)) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: fd %d event channel failed",
+				__func__, fd);
+			svc_dg_unwind(xprt);
+			goto unwind;
+		}
+		/* out of channels, shares the default (not ours to delete) */
+		if (chan_id != __svc_params->ev_u.evchan.id)
+			chans[nchans++] = chan_id;
+
+		if (svc_rqst_evchan_reg(chan_id, xprt,
+					SVC_RQST_FLAG_CHAN_AFFINITY)) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: fd %d event channel register failed",
+				__func__, fd);
+			svc_dg_unwind(xprt);
+			goto unwind;
+		}
+		xprts[n] = xprt;
+	}
+	mem_free(chans, count * sizeof(uint32_t));
+	return (count);
+
+unwind:
+	while (n > 0) {
+		xprt = xprts[--n];
+		xprts[n] = NULL;
+		svc_dg_unwind(xprt);
+	}
+	while (nchans > 0)
+		svc_rqst_delete_evchan(chans[--nchans]);
+	mem_free(chans, count * sizeof(uint32_t));
+	return (0);
+#else
+	__warnx(TIRPC_DEBUG_FLAG_ERROR,
+		"%s: SO_REUSEPORT not supported",
+		__func__);
+	return (0);
+#endif
+}
+
  /*ARGSUSED*/
 static enum xprt_stat
 svc_dg_stat(SVCXPRT *xprt)
@@ -231,67 +393,138 @@ svc_dg_stat(SVCXPRT *xprt)
 	return SVC_STAT(xprt->xp_parent);
 }
 
-static enum xprt_stat
-svc_dg_rendezvous(SVCXPRT *xprt)
+static struct svc_dg_xprt *
+svc_dg_slot_zalloc(struct svc_dg_xprt *req_su)
 {
-	struct svc_dg_xprt *req_su = su_data(xprt);
 	struct svc_dg_xprt *su = svc_dg_xprt_zalloc(req_su->su_dr.maxrec);
-	SVCXPRT *newxprt = &su->su_dr.xprt;
-	struct sockaddr *sp = (struct sockaddr *)&newxprt->xp_remote.ss;
-	struct msghdr *mesgp;
-	struct timespec now;
-	struct iovec iov;
-	ssize_t rlen;
 
-	newxprt->xp_fd = xprt->xp_fd;
-	newxprt->xp_flags = SVC_XPRT_FLAG_INITIAL | SVC_XPRT_FLAG_INITIALIZED;
-
-	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &now);
-	su->su_dr.call_xid = __RPC_GETXID(&now);
 	su->su_dr.sendsz = req_su->su_dr.sendsz;
 	su->su_dr.recvsz = req_su->su_dr.recvsz;
 	su->su_dr.maxrec = req_su->su_dr.maxrec;
-	svc_dg_override_ops(newxprt, xprt);
+	return (su);
+}
 
- again:
-	iov.iov_base = &su[1];
-	iov.iov_len = su->su_dr.maxrec;
-	mesgp = &su->su_msghdr;
-	memset(mesgp, 0, sizeof(*mesgp));
-	mesgp->msg_iov = &iov;
+/*
+ * Take up to n idle request transports from the rendezvous pool,
+ * allocating any shortfall.
+ */
+static void
+svc_dg_slot_get(struct svc_dg_xprt *req_su, struct svc_dg_xprt **slot, int n)
+{
+	struct poolq_entry *have;
+	int i = 0;
+
+	mutex_lock(&req_su->su_pool.qmutex);
+	while (i < n && (have = TAILQ_FIRST(&req_su->su_pool.qh))) {
+		TAILQ_REMOVE(&req_su->su_pool.qh, have, q);
+		(req_su->su_pool.qcount)--;
+		slot[i++] = opr_containerof(have, struct svc_dg_xprt,
+					    su_dr.ioq.ioq_s);
+	}
+	mutex_unlock(&req_su->su_pool.qmutex);
+
+	while (i < n)
+		slot[i++] = svc_dg_slot_zalloc(req_su);
+}
+
+/*
+ * Return request transports to the rendezvous pool, in the state
+ * svc_dg_slot_zalloc() leaves them; free any beyond SVC_DG_POOL_MAX.
+ */
+static void
+svc_dg_slot_put(struct svc_dg_xprt *req_su, struct svc_dg_xprt **slot, int n)
+{
+	int i = 0;
+
+	mutex_lock(&req_su->su_pool.qmutex);
+	for (; i < n && req_su->su_pool.qcount < SVC_DG_POOL_MAX; i++) {
+		TAILQ_INSERT_HEAD(&req_su->su_pool.qh,
+				  &slot[i]->su_dr.ioq.ioq_s, q);
+		(req_su->su_pool.qcount)++;
+	}
+	mutex_unlock(&req_su->su_pool.qmutex);
+
+	while (i < n)
+		svc_dg_xprt_free(slot[i++]);
+}
+
+/*
+ * Reset a finished request transport for reuse, keeping its buffer.
+ */
+static void
+svc_dg_slot_recycle(struct svc_dg_xprt *su)
+{
+	u_int sendsz = su->su_dr.sendsz;
+	u_int recvsz = su->su_dr.recvsz;
+	size_t maxrec = su->su_dr.maxrec;
+
+	XDR_DESTROY(su->su_dr.ioq.xdrs);
+	rpc_dplx_rec_destroy(&su->su_dr);
+	memset(su, 0, sizeof(struct svc_dg_xprt));
+	svc_dg_xprt_init(su);
+	su->su_dr.sendsz = sendsz;
+	su->su_dr.recvsz = recvsz;
+	su->su_dr.maxrec = maxrec;
+}
+
+static void
+svc_dg_slot_prepare(struct svc_dg_xprt *su, struct mmsghdr *mmsg,
+		    struct iovec *iov)
+{
+	struct sockaddr *sp = (struct sockaddr *)&su->su_dr.xprt.xp_remote.ss;
+	struct msghdr *mesgp = &mmsg->msg_hdr;
+
+	iov->iov_base = &su[1];
+	iov->iov_len = su->su_dr.maxrec;
+	memset(mmsg, 0, sizeof(*mmsg));
+	mesgp->msg_iov = iov;
 	mesgp->msg_iovlen = 1;
 	mesgp->msg_name = sp;
 	sp->sa_family = (sa_family_t) 0xffff;
 	mesgp->msg_namelen = sizeof(struct sockaddr_storage);
 	mesgp->msg_control = su->su_cmsg;
 	mesgp->msg_controllen = sizeof(su->su_cmsg);
+}
+
+/*
+ * Set up a received datagram as a new transport.
+ *
+ * @return false when the datagram is bad (and back in the pool)
+ */
+static bool
+svc_dg_slot_setup(SVCXPRT *xprt, struct svc_dg_xprt *su,
+		  struct mmsghdr *mmsg)
+{
+	SVCXPRT *newxprt = &su->su_dr.xprt;
+	struct sockaddr *sp = (struct sockaddr *)&newxprt->xp_remote.ss;
+	struct msghdr *mesgp = &su->su_msghdr;
+	ssize_t rlen = mmsg->msg_len;
+	struct timespec now;
 
-	rlen = recvmsg(newxprt->xp_fd, mesgp, 0);
+	*mesgp = mmsg->msg_hdr;
 
-	if (rlen == -1 && errno == EINTR)
-		goto again;
+	if (sp->sa_family == (sa_family_t) 0xffff) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: Bad message sa_family is 0xffff",
+			__func__);
+		svc_dg_slot_put(su_data(xprt), &su, 1);
+		return (false);
+	}
 
-	if (unlikely(svc_rqst_rearm_events(xprt, SVC_XPRT_FLAG_ADDED_RECV))) {
+	if (rlen < (ssize_t) (4 * sizeof(u_int32_t))) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
-			"%s: %p fd %d svc_rqst_rearm_events failed (will set dead)",
-			__func__, xprt, xprt->xp_fd);
-		svc_dg_xprt_free(su);
-		return (XPRT_DIED);
+			"%s: Bad message rlen: %zd",
+			__func__, rlen);
+		svc_dg_slot_put(su_data(xprt), &su, 1);
+		return (false);
 	}
 
-        if (sp->sa_family == (sa_family_t) 0xffff) {
-                __warnx(TIRPC_DEBUG_FLAG_ERROR,
-                        "%s: Bad message sa_family is 0xffff",
-                        __func__);
-                return SVC_STAT(xprt);
-        }
+	newxprt->xp_fd = xprt->xp_fd;
+	newxprt->xp_flags = SVC_XPRT_FLAG_INITIAL | SVC_XPRT_FLAG_INITIALIZED;
 
-        if (rlen == -1 || (rlen < (ssize_t) (4 * sizeof(u_int32_t)))) {
-                __warnx(TIRPC_DEBUG_FLAG_ERROR,
-                        "%s: Bad message rlen: %d",
-                        __func__, rlen);
-                return SVC_STAT(xprt);
-        }
+	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &now);
+	su->su_dr.call_xid = __RPC_GETXID(&now);
+	svc_dg_override_ops(newxprt, xprt);
 
 	__rpc_address_setup(&newxprt->xp_local);
 	__rpc_address_setup(&newxprt->xp_remote);
@@ -310,12 +543,172 @@ svc_dg_rendezvous(SVCXPRT *xprt)
 	__rpc_set_blkin_endpoint(newxprt, "svc_dg");
 #endif
 
-	xdrmem_create(su->su_dr.ioq.xdrs, iov.iov_base, iov.iov_len,
+	xdrmem_create(su->su_dr.ioq.xdrs, (char *)&su[1], su->su_dr.maxrec,
 		      XDR_DECODE);
 
 	SVC_REF(xprt, SVC_REF_FLAG_NONE);
 	newxprt->xp_parent = xprt;
-	return (xprt->xp_dispatch.rendezvous_cb(newxprt));
+	return (true);
+}
+
+static void
+svc_dg_rendezvous_task(struct work_pool_entry *wpe)
+{
+	struct rpc_dplx_rec *rec =
+			opr_containerof(wpe, struct rpc_dplx_rec, ioq.ioq_wpe);
+	SVCXPRT *newxprt = &rec->xprt;
+	SVCXPRT *xprt = newxprt->xp_parent;
+
+	SVC_REF(newxprt, SVC_REF_FLAG_NONE);
+	(void)xprt->xp_dispatch.rendezvous_cb(newxprt);
+	svc_dg_reply_done(xprt, newxprt);
+}
+
+/*
+ * The first request of a batch is kept for this (hot) thread, the rest
+ * go to the work pool.  Each request of a batch may queue its reply for
+ * sendmmsg() until it is done (svc_dg_reply_done).
+ */
+static void
+svc_dg_slot_dispatch(SVCXPRT *xprt, struct svc_dg_xprt *su,
+		     SVCXPRT **newxprt, bool *hold)
+{
+	if (!*newxprt) {
+		*newxprt = &su->su_dr.xprt;
+		return;
+	}
+	if (!*hold) {
+		*hold = true;
+		su_data(*newxprt)->su_reply_held = true;
+	}
+	su->su_reply_held = true;
+	su->su_dr.ioq.ioq_wpe.fun = svc_dg_rendezvous_task;
+	work_pool_submit(&svc_work_pool, &su->su_dr.ioq.ioq_wpe);
+}
+
+/*
+ * UDP_GRO may coalesce several datagrams of one flow into one buffer of
+ * equal sized segments (the last may be shorter).  Copy each segment
+ * after the first into a slot of its own, with the same source address
+ * and pktinfo, and dispatch it; the first is left in place.
+ */
+static void
+svc_dg_gro_split(SVCXPRT *xprt, struct svc_dg_xprt *su, struct mmsghdr *mmsg,
+		 SVCXPRT **newxprt, bool *hold)
+{
+	struct svc_dg_xprt *req_su = su_data(xprt);
+	struct svc_dg_xprt *seg_su;
+	struct mmsghdr seg;
+	char *base = (char *)&su[1];
+	u_int len = mmsg->msg_len;
+	u_int off;
+	int gso = svc_dg_gro_size(&mmsg->msg_hdr);
+
+	if (gso <= 0 || len <= (u_int)gso)
+		return;
+
+	__warnx(TIRPC_DEBUG_FLAG_SVC_DG,
+		"%s: %p fd %d splitting %u by %d",
+		__func__, xprt, xprt->xp_fd, len, gso);
+
+	for (off = gso; off < len; off += gso) {
+		svc_dg_slot_get(req_su, &seg_su, 1);
+
+		seg.msg_hdr = mmsg->msg_hdr;
+		seg.msg_hdr.msg_name = &seg_su->su_dr.xprt.xp_remote.ss;
+		seg.msg_hdr.msg_control = seg_su->su_cmsg;
+		seg.msg_len = MIN(gso, len - off);
+		memcpy(seg.msg_hdr.msg_name, mmsg->msg_hdr.msg_name,
+		       mmsg->msg_hdr.msg_namelen);
+		memcpy(seg_su->su_cmsg, su->su_cmsg,
+		       mmsg->msg_hdr.msg_controllen);
+		memcpy(&seg_su[1], base + off, seg.msg_len);
+
+		if (svc_dg_slot_setup(xprt, seg_su, &seg))
+			svc_dg_slot_dispatch(xprt, seg_su, newxprt, hold);
+	}
+	mmsg->msg_len = gso;
+}
+
+/*
+ * Drain up to __svc_params->dg.batch datagrams per event with a single
+ * recvmmsg() into preallocated receive slots.  All but the first are
+ * dispatched to the work pool; the first is processed on this thread.
+ * Replies are held for sendmmsg() until the first is done.
+ */
+static enum xprt_stat
+svc_dg_rendezvous(SVCXPRT *xprt)
+{
+	struct svc_dg_xprt *req_su = su_data(xprt);
+	struct svc_dg_xprt *slot[SVC_DG_BATCH_MAX];
+	struct mmsghdr mmsg[SVC_DG_BATCH_MAX];
+	struct iovec iov[SVC_DG_BATCH_MAX];
+	SVCXPRT *newxprt = NULL;
+	u_int batch = MIN(MAX(__svc_params->dg.batch, 1), SVC_DG_BATCH_MAX);
+	enum xprt_stat stat;
+	bool hold = false;
+	int code;
+	int n;
+	int i;
+
+	svc_dg_slot_get(req_su, slot, batch);
+	for (i = 0; i < batch; i++)
+		svc_dg_slot_prepare(slot[i], &mmsg[i], &iov[i]);
+
+ again:
+	n = recvmmsg(xprt->xp_fd, mmsg, batch, MSG_DONTWAIT, NULL);
+	code = errno;
+
+	if (n == -1 && code == EINTR)
+		goto again;
+
+	/* keep unused slots for the next event */
+	if (n < (int)batch)
+		svc_dg_slot_put(req_su, &slot[MAX(n, 0)], batch - MAX(n, 0));
+
+	if (unlikely(svc_rqst_rearm_events(xprt, SVC_XPRT_FLAG_ADDED_RECV))) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: %p fd %d svc_rqst_rearm_events failed (will set dead)",
+			__func__, xprt, xprt->xp_fd);
+		for (i = 0; i < n; i++)
+			svc_dg_xprt_free(slot[i]);
+		return (XPRT_DIED);
+	}
+
+	if (n == -1) {
+		if (code != EAGAIN && code != EWOULDBLOCK)
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: %p fd %d recvmmsg errno %d",
+				__func__, xprt, xprt->xp_fd, code);
+		return SVC_STAT(xprt);
+	}
+
+	__warnx(TIRPC_DEBUG_FLAG_SVC_DG,
+		"%s: %p fd %d received %d of %u",
+		__func__, xprt, xprt->xp_fd, n, batch);
+
+	for (i = 0; i < n; i++) {
+		if (req_su->su_offload & RPC_DG_OFFLOAD_GRO)
+			svc_dg_gro_split(xprt, slot[i], &mmsg[i],
+					 &newxprt, &hold);
+
+		if (!svc_dg_slot_setup(xprt, slot[i], &mmsg[i]))
+			continue;
+
+		svc_dg_slot_dispatch(xprt, slot[i], &newxprt, &hold);
+	}
+
+	if (!newxprt)
+		return SVC_STAT(xprt);
+
+	if (hold)
+		SVC_REF(newxprt, SVC_REF_FLAG_NONE);
+
+	stat = xprt->xp_dispatch.rendezvous_cb(newxprt);
+
+	if (hold)
+		svc_dg_reply_done(xprt, newxprt);
+	return (stat);
 }
 
 static enum xprt_stat
@@ -349,7 +742,7 @@ svc_dg_decode(struct svc_req *req)
 	XDR_SETPOS(xdrs, 0);
 	rpc_msg_init(&req->rq_msg);
 
-	if (!xdr_dplx_decode(xdrs, &req->rq_msg)) {
+	if (!xdr_dplx_decode_ref(xdrs, &req->rq_msg, &req->rq_cred_ref)) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s: %p fd %d failed (will set dead)",
 			__func__, xprt, xprt->xp_fd);
@@ -388,6 +781,260 @@ svc_dg_checksum(struct svc_req *req, void *data, size_t length)
 #endif
 }
 
+/*
+ * Fill in su_msghdr for sending the reply in the receive buffer, with the
+ * IP*_PKTINFO of the request, so the reply leaves from the address that
+ * the request was sent to.
+ */
+static void
+svc_dg_reply_prepare(SVCXPRT *xprt, struct svc_dg_xprt *su, size_t slen)
+{
+	struct msghdr *msg = &su->su_msghdr;
+	struct cmsghdr *cmsg;
+
+	su->su_iov.iov_base = &su[1];
+	su->su_iov.iov_len = slen;
+	msg->msg_iov = &su->su_iov;
+	msg->msg_iovlen = 1;
+	msg->msg_name = (struct sockaddr *)&xprt->xp_remote.ss;
+	msg->msg_namelen = sizeof(struct sockaddr_storage);
+	msg->msg_flags = 0;
+
+	if (!xprt->xp_local.nb.len) {
+		msg->msg_control = NULL;
+		msg->msg_controllen = 0;
+		return;
+	}
+	msg->msg_control = su->su_cmsg;
+	msg->msg_controllen = sizeof(su->su_cmsg);
+
+	cmsg = CMSG_FIRSTHDR(msg);
+	if (xprt->xp_local.ss.ss_family == AF_INET) {
+		cmsg->cmsg_level = IPPROTO_IP;	/* a.k.a. SOL_IP */
+		cmsg->cmsg_type = IP_PKTINFO;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(struct in_pktinfo));
+		*(struct in_pktinfo *)CMSG_DATA(cmsg) = xprt->xp_pktinfo.in;
+		msg->msg_controllen = CMSG_SPACE(sizeof(struct in_pktinfo));
+	} else {
+		cmsg->cmsg_level = IPPROTO_IPV6; /* a.k.a. SOL_IPV6 */
+		cmsg->cmsg_type = IPV6_PKTINFO;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
+		*(struct in6_pktinfo *)CMSG_DATA(cmsg) = xprt->xp_pktinfo.in6;
+		msg->msg_controllen = CMSG_SPACE(sizeof(struct in6_pktinfo));
+	}
+}
+
+#if defined(UDP_SEGMENT)
+/* pktinfo (as received) plus UDP_SEGMENT */
+union svc_dg_gso_cmsg {
+	char buf[SVC_CMSG_SIZE + CMSG_SPACE(sizeof(uint16_t))];
+	struct cmsghdr align;
+};
+
+static inline bool
+svc_dg_gso_same_path(struct svc_dg_xprt *a, struct svc_dg_xprt *b)
+{
+	struct rpc_address *ra = &a->su_dr.xprt.xp_remote;
+	struct rpc_address *rb = &b->su_dr.xprt.xp_remote;
+
+	return (ra->nb.len == rb->nb.len
+		&& !memcmp(&ra->ss, &rb->ss, ra->nb.len)
+		&& a->su_msghdr.msg_controllen == b->su_msghdr.msg_controllen
+		&& (!a->su_msghdr.msg_controllen
+		    || !memcmp(a->su_msghdr.msg_control,
+			       b->su_msghdr.msg_control,
+			       a->su_msghdr.msg_controllen)));
+}
+
+/*
+ * Replies from reply[i] to the same client and source address, of the
+ * same length but for a shorter last, can go out as one UDP_SEGMENT
+ * send.
+ *
+ * @return the end of the run starting at reply[i]
+ */
+static u_int
+svc_dg_gso_run(struct svc_dg_xprt **reply, u_int i, u_int n)
+{
+	size_t gso = reply[i]->su_iov.iov_len;
+	size_t total = gso;
+	size_t len;
+	u_int j;
+
+	for (j = i + 1; j < n; j++) {
+		len = reply[j]->su_iov.iov_len;
+		if (len > gso || total + len > SVC_DG_GSO_MAX
+		    || !svc_dg_gso_same_path(reply[i], reply[j]))
+			break;
+		total += len;
+		if (len < gso) {
+			j++;
+			break;
+		}
+	}
+	return (j);
+}
+
+static void
+svc_dg_gso_prepare(struct msghdr *msg, struct svc_dg_xprt **reply,
+		   u_int i, u_int j, struct iovec *iov,
+		   union svc_dg_gso_cmsg *ctl)
+{
+	struct cmsghdr *cmsg;
+	u_int k;
+
+	for (k = i; k < j; k++)
+		iov[k] = reply[k]->su_iov;
+	msg->msg_iov = &iov[i];
+	msg->msg_iovlen = j - i;
+
+	memcpy(ctl->buf, msg->msg_control, msg->msg_controllen);
+	cmsg = (struct cmsghdr *)(ctl->buf + msg->msg_controllen);
+	cmsg->cmsg_level = SOL_UDP;
+	cmsg->cmsg_type = UDP_SEGMENT;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+	*(uint16_t *)CMSG_DATA(cmsg) = reply[i]->su_iov.iov_len;
+	msg->msg_control = ctl->buf;
+	msg->msg_controllen += CMSG_SPACE(sizeof(uint16_t));
+}
+#endif
+
+/*
+ * Send the replies queued on the rendezvous transport with sendmmsg(),
+ * each with its own destination and pktinfo.  With RPC_DG_OFFLOAD_GSO,
+ * runs of equal sized replies to one client are sent as one message
+ * segmented by the kernel.  The queue is taken under the lock, and sent
+ * outside it.
+ */
+static void
+svc_dg_reply_flush(struct svc_dg_xprt *req_su)
+{
+	struct svc_dg_xprt *reply[SVC_DG_BATCH_MAX];
+	struct mmsghdr mmsg[SVC_DG_BATCH_MAX];
+	u_int first[SVC_DG_BATCH_MAX + 1];
+#if defined(UDP_SEGMENT)
+	union svc_dg_gso_cmsg ctl[SVC_DG_BATCH_MAX];
+	struct iovec iov[SVC_DG_BATCH_MAX];
+#endif
+	SVCXPRT *xprt = &req_su->su_dr.xprt;
+	u_int n;
+	u_int m;
+	u_int i;
+	u_int k;
+	int sent;
+
+	mutex_lock(&req_su->su_reply_lock);
+	n = req_su->su_nreplies;
+	memcpy(reply, req_su->su_replies, n * sizeof(struct svc_dg_xprt *));
+	req_su->su_nreplies = 0;
+	mutex_unlock(&req_su->su_reply_lock);
+
+	if (!n)
+		return;
+
+	/* mmsg[m] sends reply[first[m]] up to reply[first[m + 1]] */
+	for (i = 0, m = 0; i < n; m++) {
+		mmsg[m].msg_hdr = reply[i]->su_msghdr;
+		mmsg[m].msg_len = 0;
+		first[m] = i++;
+#if defined(UDP_SEGMENT)
+		if (!(req_su->su_offload & RPC_DG_OFFLOAD_GSO))
+			continue;
+		i = svc_dg_gso_run(reply, first[m], n);
+		if (i - first[m] > 1)
+			svc_dg_gso_prepare(&mmsg[m].msg_hdr, reply, first[m],
+					   i, iov, &ctl[m]);
+#endif
+	}
+	first[m] = n;
+
+	__warnx(TIRPC_DEBUG_FLAG_SVC_DG,
+		"%s: %p fd %d sending %u in %u",
+		__func__, xprt, xprt->xp_fd, n, m);
+
+	for (i = 0; i < m; i += sent) {
+		sent = sendmmsg(xprt->xp_fd, &mmsg[i], m - i, 0);
+		if (sent > 0)
+			continue;
+		if (sent < 0 && errno == EINTR) {
+			sent = 0;
+			continue;
+		}
+		sent = 1;
+
+		/* segmentation may not be possible on this path */
+		if (first[i + 1] - first[i] > 1) {
+			for (k = first[i]; k < first[i + 1]; k++)
+				if (sendmsg(xprt->xp_fd, &reply[k]->su_msghdr, 0)
+				    < 0)
+					break;
+			if (k == first[i + 1])
+				continue;
+		}
+
+		/* drop the failed datagram, as sendmsg() would have */
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: %p fd %d err %d sendmmsg failed",
+			__func__, xprt, xprt->xp_fd, errno);
+	}
+
+	for (i = 0; i < n; i++)
+		SVC_RELEASE(&reply[i]->su_dr.xprt, SVC_RELEASE_FLAG_NONE);
+}
+
+/*
+ * A request of a received batch is done (its thread holding a reference
+ * taken before its rendezvous_cb): send the queue, with its own reply if
+ * any, so that no reply waits for longer than the request that made it.
+ */
+static void
+svc_dg_reply_done(SVCXPRT *xprt, SVCXPRT *newxprt)
+{
+	struct svc_dg_xprt *req_su = su_data(xprt);
+
+	mutex_lock(&req_su->su_reply_lock);
+	su_data(newxprt)->su_reply_held = false;
+	mutex_unlock(&req_su->su_reply_lock);
+
+	svc_dg_reply_flush(req_su);
+	SVC_RELEASE(newxprt, SVC_RELEASE_FLAG_NONE);
+}
+
+/*
+ * Queue the reply to a request of a received batch on the rendezvous
+ * transport, until the queue fills or that request is done, sending the
+ * replies made meanwhile together.  Otherwise (a single request, a reply
+ * made after its request returned, or a full queue) send it now.
+ *
+ * @return true when queued
+ */
+static bool
+svc_dg_reply_queue(SVCXPRT *xprt, struct svc_dg_xprt *su)
+{
+	struct svc_dg_xprt *req_su;
+	u_int batch = MIN(MAX(__svc_params->dg.batch, 1), SVC_DG_BATCH_MAX);
+	bool flush;
+
+	if (!xprt->xp_parent)
+		return (false);
+	req_su = su_data(xprt->xp_parent);
+
+	mutex_lock(&req_su->su_reply_lock);
+	if (!su->su_reply_held
+	    || req_su->su_nreplies >= SVC_DG_BATCH_MAX) {
+		mutex_unlock(&req_su->su_reply_lock);
+		return (false);
+	}
+	SVC_REF(xprt, SVC_REF_FLAG_NONE);
+	req_su->su_replies[req_su->su_nreplies++] = su;
+	flush = (req_su->su_nreplies >= batch);
+	mutex_unlock(&req_su->su_reply_lock);
+
+	if (flush)
+		svc_dg_reply_flush(req_su);
+	return (true);
+}
+
 static enum xprt_stat
 svc_dg_reply(struct svc_req *req)
 {
@@ -395,11 +1042,7 @@ svc_dg_reply(struct svc_req *req)
 	struct rpc_dplx_rec *rec = REC_XPRT(xprt);
 	XDR *xdrs = rec->ioq.xdrs;
 	struct svc_dg_xprt *su = DG_DR(rec);
-	struct msghdr *msg = &su->su_msghdr;
-	struct cmsghdr* cmsg;
-	struct iovec iov;
 	size_t slen;
-        char msg_control[sizeof(struct cmsghdr) + sizeof(struct in6_pktinfo)];
 
 	if (!xprt->xp_remote.nb.len) {
 		__warnx(TIRPC_DEBUG_FLAG_WARN,
@@ -426,35 +1069,13 @@ svc_dg_reply(struct svc_req *req)
 			__func__, xprt, xprt->xp_fd);
 		return (XPRT_DIED);
 	}
-	iov.iov_base = &su[1];
-	iov.iov_len = slen = XDR_GETPOS(xdrs);
-	msg->msg_iov = &iov;
-	msg->msg_iovlen = 1;
-	msg->msg_name = (struct sockaddr *)&xprt->xp_remote.ss;
-	msg->msg_namelen = sizeof(struct sockaddr_storage);
-	msg->msg_control = msg_control;
-	msg->msg_controllen = sizeof(msg_control);
-	msg->msg_flags = 0;
+	slen = XDR_GETPOS(xdrs);
+	svc_dg_reply_prepare(xprt, su, slen);
 
-	cmsg = CMSG_FIRSTHDR(msg);
-	cmsg->cmsg_level = (xprt->xp_local.ss.ss_family == AF_INET)
-		? IPPROTO_IP : IPPROTO_IPV6; /* a.k.a. SOL_IP and SOL_IPV6 */
-	cmsg->cmsg_type = (xprt->xp_local.ss.ss_family == AF_INET)
-		? IP_PKTINFO : IPV6_PKTINFO;
-	if (xprt->xp_local.ss.ss_family == AF_INET)
-		*(struct in_pktinfo*)CMSG_DATA(cmsg) =
-			*(struct in_pktinfo*) &xprt->xp_pktinfo;
-	else
-		*(struct in6_pktinfo*)CMSG_DATA(cmsg) =
-			*(struct in6_pktinfo*) &xprt->xp_pktinfo;
-	cmsg->cmsg_len = (xprt->xp_local.ss.ss_family == AF_INET)
-		? CMSG_LEN(sizeof(struct in_pktinfo))
-		: CMSG_LEN(sizeof(struct in6_pktinfo));
-	msg->msg_controllen = (xprt->xp_local.ss.ss_family == AF_INET)
-		? CMSG_SPACE(sizeof(struct in_pktinfo))
-		: CMSG_SPACE(sizeof(struct in6_pktinfo));
-
-	if (sendmsg(xprt->xp_fd, msg, 0) != (ssize_t) slen) {
+	if (svc_dg_reply_queue(xprt, su))
+		return (XPRT_IDLE);
+
+	if (sendmsg(xprt->xp_fd, &su->su_msghdr, 0) != (ssize_t) slen) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s: %p fd %d err %d sendmsg failed (will set dead)",
 			__func__, xprt, xprt->xp_fd, errno);
@@ -464,6 +1085,33 @@ svc_dg_reply(struct svc_req *req)
 	return (XPRT_IDLE);
 }
 
+static void
+svc_dg_destroy_final(struct rpc_dplx_rec *rec)
+{
+	SVCXPRT *parent = rec->xprt.xp_parent;
+	struct svc_dg_xprt *su = DG_DR(rec);
+
+	if (rec->xprt.xp_ops->xp_free_user_data)
+		rec->xprt.xp_ops->xp_free_user_data(&rec->xprt);
+
+	if (rec->xprt.xp_tp)
+		mem_free(rec->xprt.xp_tp, 0);
+	if (rec->xprt.xp_netid)
+		mem_free(rec->xprt.xp_netid, 0);
+
+	if (!parent) {
+		svc_dg_xprt_free(su);
+		return;
+	}
+
+	/* request transport: back to the rendezvous pool, which the
+	 * parent reference still holds open
+	 */
+	svc_dg_slot_recycle(su);
+	svc_dg_slot_put(su_data(parent), &su, 1);
+	SVC_RELEASE(parent, SVC_RELEASE_FLAG_NONE);
+}
+
 static void
 svc_dg_destroy_task(struct work_pool_entry *wpe)
 {
@@ -499,18 +1147,7 @@ svc_dg_destroy_task(struct work_pool_entry *wpe)
 		rec->xprt.xp_fd_send = RPC_ANYFD;
 	}
 
-	if (rec->xprt.xp_ops->xp_free_user_data)
-		rec->xprt.xp_ops->xp_free_user_data(&rec->xprt);
-
-	if (rec->xprt.xp_tp)
-		mem_free(rec->xprt.xp_tp, 0);
-	if (rec->xprt.xp_netid)
-		mem_free(rec->xprt.xp_netid, 0);
-
-	if (rec->xprt.xp_parent)
-		SVC_RELEASE(rec->xprt.xp_parent, SVC_RELEASE_FLAG_NONE);
-
-	svc_dg_xprt_free(DG_DR(rec));
+	svc_dg_destroy_final(rec);
 }
 
 static void
@@ -537,6 +1174,14 @@ svc_dg_destroy_it(SVCXPRT *xprt, u_int flags, const char *tag, const int line)
 		"%s() %p fd %d xp_refcnt %" PRId32 " @%s:%d",
 		__func__, xprt, xprt->xp_fd, xprt->xp_refcnt, tag, line);
 
+	if (xprt->xp_parent && !atomic_fetch_int32_t(&xprt->xp_refcnt)) {
+		/* request transports are never hooked into an event
+		 * channel, so nothing else can be working on them
+		 */
+		svc_dg_destroy_final(REC_XPRT(xprt));
+		return;
+	}
+
 	while (atomic_postset_uint16_t_bits(&(REC_XPRT(xprt)->ioq.ioq_s.qflags),
 					    IOQ_FLAG_WORKING)
 	       & IOQ_FLAG_WORKING) {
@@ -662,6 +1307,52 @@ svc_dg_enable_pktinfo(int fd, const struct __rpc_sockinfo *si)
 	}
 }
 
+/*
+ * Enable the RPC_DG_OFFLOAD_* set by rpc_control() that this socket
+ * supports.  Coalesced receive needs buffers of whole segments.
+ */
+static void
+svc_dg_enable_offload(int fd, struct svc_dg_xprt *su)
+{
+#if defined(UDP_GRO) && defined(UDP_SEGMENT)
+	u_int offload = __svc_params->dg.offload;
+	socklen_t len = sizeof(int);
+	int on = 1;
+	int val;
+
+	if ((offload & RPC_DG_OFFLOAD_GRO)
+	    && !setsockopt(fd, SOL_UDP, UDP_GRO, &on, sizeof(on))) {
+		su->su_offload |= RPC_DG_OFFLOAD_GRO;
+		su->su_dr.maxrec = MAX(su->su_dr.maxrec, SVC_DG_GRO_BUFSZ);
+	}
+
+	/* probe only, the segment size is set per message */
+	if ((offload & RPC_DG_OFFLOAD_GSO)
+	    && !getsockopt(fd, SOL_UDP, UDP_SEGMENT, &val, &len))
+		su->su_offload |= RPC_DG_OFFLOAD_GSO;
+#endif
+}
+
+/*
+ * @return the UDP_GRO segment size of a coalesced datagram, else 0
+ */
+static int
+svc_dg_gro_size(struct msghdr *msg)
+{
+#if defined(UDP_GRO)
+	struct cmsghdr *cmsg;
+
+	for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL;
+	     cmsg = CMSG_NXTHDR(msg, cmsg)) {
+		if (cmsg->cmsg_level == SOL_UDP
+		    && cmsg->cmsg_type == UDP_GRO
+		    && cmsg->cmsg_len >= CMSG_LEN(sizeof(int)))
+			return (*(int *)CMSG_DATA(cmsg));
+	}
+#endif
+	return (0);
+}
+
 static int
 svc_dg_store_in_pktinfo(struct cmsghdr *cmsg, SVCXPRT *xprt)
 {
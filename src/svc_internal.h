@@ -79,6 +79,20 @@ struct svc_params {
 		u_int thrd_min;
 	} ioq;
 
+	struct {
+		u_int batch;	/* datagrams per rendezvous */
+		u_int offload;	/* RPC_DG_OFFLOAD_* */
+	} dg;
+
+	struct {
+		u_int spin;	/* sync reply polls before sleeping */
+	} clnt;
+
+	struct {
+		u_int arena;	/* decode arena chunk bytes; 0: none */
+		u_int sizing;	/* size replies before encoding */
+	} req;
+
 	u_long flags;
 	u_int max_connections;
 	int32_t idle_timeout;
@@ -110,10 +124,22 @@ union pktinfo_u {
  * which wraps struct svc_xprt indexed by fd.
  */
 #define DG_NUM_PKTINFO 4 /* s/b enough space for all pktinfos in normal case*/
+#define SVC_DG_BATCH_DEFAULT 16
+#define SVC_DG_BATCH_MAX 64
+#define SVC_DG_POOL_MAX 256	/* idle request transports kept per socket */
+#define SVC_DG_GRO_BUFSZ 65536	/* coalesced receive, whole segments */
+#define SVC_DG_GSO_MAX 65507	/* largest UDP payload */
 struct svc_dg_xprt {
 	struct rpc_dplx_rec su_dr;	/* SVCXPRT indexed by fd */
 	struct msghdr su_msghdr;	/* msghdr received from clnt */
 	union pktinfo_u su_cmsg[DG_NUM_PKTINFO]; /* cmsghdr recv'd from clnt */
+	struct iovec su_iov;		/* reply, while queued */
+	struct poolq_head su_pool;	/* rendezvous: idle request transports */
+	mutex_t su_reply_lock;		/* rendezvous: reply queue */
+	struct svc_dg_xprt **su_replies;
+	u_int su_nreplies;
+	bool su_reply_held;		/* request: reply may be queued */
+	u_int su_offload;		/* rendezvous: RPC_DG_OFFLOAD_* enabled */
 };
 #define DG_DR(p) (opr_containerof((p), struct svc_dg_xprt, su_dr))
 #define su_data(xprt) (DG_DR(REC_XPRT(xprt)))
@@ -193,6 +219,7 @@ void svc_rqst_xprt_unregister_rdma(SVCXPRT *, uint32_t);
 int svc_rqst_evchan_write(SVCXPRT *, struct xdr_ioq *, bool);
 void svc_rqst_xprt_send_complete(SVCXPRT *);
 void svc_rqst_unhook(SVCXPRT *);
+int svc_rqst_delete_evchan(uint32_t);
 
 typedef struct sockaddr_storage sockaddr_t;
 int svc_get_port(sockaddr_t *);
@@ -82,7 +82,7 @@ svc_ioq_flushv(SVCXPRT *xprt, struct xdr_ioq *xioq)
 	int error = 0;
 	int frag_needed = 0;
 	u_int32_t last_frag = 0;
-	u_int32_t end, remaining, iov_count, vsize, isize;
+	u_int32_t end, remaining, iov_count, vsize, isize, fill;
 
 	/* update the most recent data length, just in case */
 	xdr_tail_update(xioq->xdrs);
@@ -140,24 +140,21 @@ svc_ioq_flushv(SVCXPRT *xprt, struct xdr_ioq *xioq)
 		int i;
 		int frag_hdr_size = 0;
 
-		/* Note that there may be lots of re-walking the ioq to
-		 * count the number of buffers or fill the buffers in the vio,
-		 * unfortunately, any mechanism to try and avoid that would
-		 * still have to re-walk the ioq, so we don't save THAT much
-		 * by just recomputing in preparation for each attempt to send
-		 * data. We could shortcut a little bit if we could estimate
-		 * how many bytes would fit in a single iovec so that we
-		 * don't walk more of the ioq than we need to. But that adds a
-		 * lot of complexity, and just saves walking a linked list.
-		 *
-		 * A more relevant improvement here might actually be to use
-		 * larger buffers than 8k. Optionally, when we do more to
-		 * implement zero copy, the largest responses which are
-		 * READ and READDIR will be adding a single buffer, or a small
-		 * number of buffers to the ioq instead of copying into the
-		 * 8k byte buffers.
+		/* Each attempt recounts and refills the buffers from
+		 * write_start.  The xdr_ioq segment index finds write_start
+		 * (and the end of the fragment) without walking the ioq, and
+		 * only as many buffers as sendmsg can take are filled, so a
+		 * long reply sent in many attempts costs no more than one.
 		 */
 		iov_count = XDR_IOVCOUNT(xioq->xdrs, xioq->write_start, fbytes);
+		fill = fbytes;
+
+		if (iov_count + frag_needed > PRESUMED_UIO_MAXIOV) {
+			/* sendmsg can only take UIO_MAXIOV iovecs */
+			iov_count = PRESUMED_UIO_MAXIOV - frag_needed;
+			fill = xdr_ioq_extent(xioq, xioq->write_start,
+					      iov_count);
+		}
 
 		if (xioq->write_start == 0 ||
 		    xioq->write_start == LAST_FRAG_XDR_UNITS ||
@@ -189,18 +186,13 @@ svc_ioq_flushv(SVCXPRT *xprt, struct xdr_ioq *xioq)
 			xioq->write_start, end, frag_needed, frag_hdr_size);
 
 		/* Get an xdr_vio corresponding to the bytes of this fragment */
-		if (!XDR_FILLBUFS(xioq->xdrs, xioq->write_start, vio, fbytes)) {
+		if (!XDR_FILLBUFS(xioq->xdrs, xioq->write_start, vio, fill)) {
 			__warnx(TIRPC_DEBUG_FLAG_ERROR,
 				"%s() XDR_FILLBUFS failed", __func__);
 			error = -1;
 			break;
 		}
 
-		if (iov_count + frag_needed > PRESUMED_UIO_MAXIOV) {
-			/* sendmsg can only take UIO_MAXIOV iovecs */
-			iov_count = PRESUMED_UIO_MAXIOV - frag_needed;
-		}
-
 		/* Convert the xdr_vio to an iovec */
 		for (i = 0; i < iov_count; i++) {
 			iov[i + frag_needed].iov_base = vio[i].vio_head;
@@ -313,6 +305,315 @@ again:
 	return error;
 }
 
+/*
+ * Memory budgets.
+ *
+ * Completed requests are charged to the receive budget until their
+ * stream is destroyed, and replies to the send budget until written.
+ * A transport over either budget is not rearmed for receive; it is
+ * rearmed by the release that brings it back under budget.  Only a
+ * transport with bytes outstanding is stopped, so that some release
+ * is always pending to restart it.
+ */
+static struct rpc_mem_budget svc_ioq_budget;
+
+bool
+svc_ioq_budget_control(int what, struct rpc_mem_budget *budget)
+{
+	switch (what) {
+	case RPC_SVC_MEM_BUDGET_GET:
+		*budget = svc_ioq_budget;
+		budget->recv_pending =
+			atomic_fetch_size_t(&svc_ioq_budget.recv_pending);
+		budget->send_pending =
+			atomic_fetch_size_t(&svc_ioq_budget.send_pending);
+		budget->throttled =
+			atomic_fetch_uint64_t(&svc_ioq_budget.throttled);
+		budget->resumed =
+			atomic_fetch_uint64_t(&svc_ioq_budget.resumed);
+		break;
+	case RPC_SVC_MEM_BUDGET_SET:
+		svc_ioq_budget.xprt_recv = budget->xprt_recv;
+		svc_ioq_budget.xprt_send = budget->xprt_send;
+		svc_ioq_budget.total_recv = budget->total_recv;
+		svc_ioq_budget.total_send = budget->total_send;
+		break;
+	default:
+		return (false);
+	}
+	return (true);
+}
+
+static inline bool
+svc_ioq_over_budget(struct rpc_dplx_rec *rec)
+{
+	size_t recv = atomic_fetch_size_t(&rec->mem.recv_pending);
+	size_t send = atomic_fetch_size_t(&rec->mem.send_pending);
+
+	if (!(recv | send))
+		return (false);
+
+	return (svc_ioq_budget.xprt_recv
+		&& recv > svc_ioq_budget.xprt_recv)
+	    || (svc_ioq_budget.xprt_send
+		&& send > svc_ioq_budget.xprt_send)
+	    || (svc_ioq_budget.total_recv
+		&& atomic_fetch_size_t(&svc_ioq_budget.recv_pending)
+		   > svc_ioq_budget.total_recv)
+	    || (svc_ioq_budget.total_send
+		&& atomic_fetch_size_t(&svc_ioq_budget.send_pending)
+		   > svc_ioq_budget.total_send);
+}
+
+/* Restart receive, when stopped and now under budget */
+static void
+svc_ioq_budget_drained(struct rpc_dplx_rec *rec)
+{
+	SVCXPRT *xprt = &rec->xprt;
+
+	if (likely(!(xprt->xp_flags & SVC_XPRT_FLAG_RECV_THROTTLED))
+	    || svc_ioq_over_budget(rec))
+		return;
+
+	if (!(atomic_postclear_uint16_t_bits(&xprt->xp_flags,
+					     SVC_XPRT_FLAG_RECV_THROTTLED)
+	      & SVC_XPRT_FLAG_RECV_THROTTLED))
+		return;
+
+	atomic_inc_uint64_t(&svc_ioq_budget.resumed);
+
+	__warnx(TIRPC_DEBUG_FLAG_SVC_VC,
+		"%s: %p fd %d resuming receive",
+		__func__, xprt, xprt->xp_fd);
+
+	if (unlikely(svc_rqst_rearm_events(xprt, SVC_XPRT_FLAG_ADDED_RECV))) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: %p fd %d svc_rqst_rearm_events failed (will set dead)",
+			__func__, xprt, xprt->xp_fd);
+		SVC_DESTROY(xprt);
+	}
+}
+
+/*
+ * Charge a completed request to the receive budget.
+ *
+ * The request stream must be destroyed before its transport is freed,
+ * as done by svc_request() and svc_resume().
+ */
+void
+svc_ioq_budget_recv(SVCXPRT *xprt, struct xdr_ioq *xioq)
+{
+	struct rpc_dplx_rec *rec = REC_XPRT(xprt);
+	struct poolq_entry *have;
+	size_t len = 0;
+
+	TAILQ_FOREACH(have, &xioq->ioq_uv.uvqh.qh, q) {
+		len += ioquv_size(IOQ_(have));
+	}
+
+	xioq->rec = rec;
+	xioq->recv_budget = len;
+	atomic_add_size_t(&rec->mem.recv_pending, len);
+	atomic_add_size_t(&svc_ioq_budget.recv_pending, len);
+}
+
+void
+svc_ioq_budget_release(struct xdr_ioq *xioq)
+{
+	struct rpc_dplx_rec *rec = xioq->rec;
+
+	atomic_sub_size_t(&svc_ioq_budget.recv_pending, xioq->recv_budget);
+	atomic_sub_size_t(&rec->mem.recv_pending, xioq->recv_budget);
+	xioq->recv_budget = 0;
+
+	svc_ioq_budget_drained(rec);
+}
+
+static inline void
+svc_ioq_budget_send(struct rpc_dplx_rec *rec, struct xdr_ioq *xioq)
+{
+	struct poolq_entry *have;
+	size_t len = 0;
+
+	TAILQ_FOREACH(have, &xioq->ioq_uv.uvqh.qh, q) {
+		len += ioquv_length(IOQ_(have));
+	}
+
+	xioq->send_budget = len;
+	atomic_add_size_t(&rec->mem.send_pending, len);
+	atomic_add_size_t(&svc_ioq_budget.send_pending, len);
+}
+
+static inline void
+svc_ioq_budget_sent(struct rpc_dplx_rec *rec, struct xdr_ioq *xioq)
+{
+	atomic_sub_size_t(&svc_ioq_budget.send_pending, xioq->send_budget);
+	atomic_sub_size_t(&rec->mem.send_pending, xioq->send_budget);
+	xioq->send_budget = 0;
+
+	svc_ioq_budget_drained(rec);
+}
+
+/*
+ * Rearm receive events, unless over budget.
+ *
+ * @return 0 or errno from svc_rqst_rearm_events()
+ */
+int
+svc_ioq_rearm_recv(SVCXPRT *xprt)
+{
+	struct rpc_dplx_rec *rec = REC_XPRT(xprt);
+
+	if (unlikely(svc_ioq_over_budget(rec))) {
+		atomic_set_uint16_t_bits(&xprt->xp_flags,
+					 SVC_XPRT_FLAG_RECV_THROTTLED);
+
+		/* recheck, a release may have raced the flag */
+		if (svc_ioq_over_budget(rec)) {
+			atomic_inc_uint32_t(&rec->mem.throttled);
+			atomic_inc_uint64_t(&svc_ioq_budget.throttled);
+
+			__warnx(TIRPC_DEBUG_FLAG_SVC_VC,
+				"%s: %p fd %d over budget, recv %zu send %zu",
+				__func__, xprt, xprt->xp_fd,
+				rec->mem.recv_pending, rec->mem.send_pending);
+			return (0);
+		}
+
+		if (!(atomic_postclear_uint16_t_bits(&xprt->xp_flags,
+					SVC_XPRT_FLAG_RECV_THROTTLED)
+		      & SVC_XPRT_FLAG_RECV_THROTTLED)) {
+			/* already rearmed by svc_ioq_budget_drained() */
+			return (0);
+		}
+	}
+
+	return svc_rqst_rearm_events(xprt, SVC_XPRT_FLAG_ADDED_RECV);
+}
+
+/*
+ * Several short records queued: send them together in one sendmsg(),
+ * each with its own record mark.
+ *
+ * Only records not yet started are taken, each fitting in one fragment.
+ * Fully sent records are released here; a partly sent record keeps its
+ * progress at the head of the queue, for svc_ioq_flushv().  On any error
+ * nothing is changed, and svc_ioq_flushv() handles it.
+ *
+ * The next head is fetched with the dequeue, under the same lock: once
+ * the queue is seen empty, a new record schedules its own writer.
+ *
+ * @return the number of records sent
+ */
+#define SVC_IOQ_GATHER_MAX	16	/* records */
+#define SVC_IOQ_GATHER_IOV	64
+
+static int
+svc_ioq_flush_gather(SVCXPRT *xprt, struct rpc_dplx_rec *rec,
+		     struct poolq_entry **next)
+{
+	struct xdr_ioq *xv[SVC_IOQ_GATHER_MAX];
+	u_int32_t hdr[SVC_IOQ_GATHER_MAX];
+	u_int32_t len[SVC_IOQ_GATHER_MAX];
+	struct iovec iov[SVC_IOQ_GATHER_IOV];
+	struct xdr_vio vio[SVC_IOQ_GATHER_IOV];
+	struct poolq_entry *have;
+	struct xdr_ioq *xioq;
+	struct msghdr msg;
+	ssize_t result;
+	u_int32_t count;
+	u_int32_t end;
+	int niov = 0;
+	int done;
+	int i, j;
+	int n = 0;
+
+	mutex_lock(&rec->writeq.qmutex);
+	for (have = TAILQ_FIRST(&rec->writeq.qh);
+	     have && n < SVC_IOQ_GATHER_MAX;
+	     have = TAILQ_NEXT(have, q)) {
+		xioq = _IOQ(have);
+		if (xioq->write_start || xioq->frag_hdr_bytes_sent
+		 || xioq->has_blocked)
+			break;
+
+		xdr_tail_update(xioq->xdrs);
+		end = XDR_GETPOS(xioq->xdrs);
+		if (end > LAST_FRAG_XDR_UNITS)
+			break;
+
+		count = XDR_IOVCOUNT(xioq->xdrs, 0, end);
+		if (niov + 1 + count > SVC_IOQ_GATHER_IOV)
+			break;
+
+		xv[n] = xioq;
+		len[n++] = end;
+		niov += 1 + count;
+	}
+	mutex_unlock(&rec->writeq.qmutex);
+
+	if (n < 2)
+		return (0);
+
+	for (i = 0, niov = 0; i < n; i++) {
+		hdr[i] = htonl(len[i] | LAST_FRAG);
+		iov[niov].iov_base = &hdr[i];
+		iov[niov++].iov_len = sizeof(hdr[i]);
+
+		count = XDR_IOVCOUNT(xv[i]->xdrs, 0, len[i]);
+		if (!XDR_FILLBUFS(xv[i]->xdrs, 0, vio, len[i]))
+			return (0);
+		for (j = 0; j < count; j++) {
+			iov[niov].iov_base = vio[j].vio_head;
+			iov[niov++].iov_len = vio[j].vio_length;
+		}
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = niov;
+
+	/* non-blocking write */
+	result = sendmsg(xprt->xp_fd, &msg, MSG_DONTWAIT);
+
+	__warnx(TIRPC_DEBUG_FLAG_SVC_VC,
+		"%s: %p fd %d %d records %d iovs result %ld",
+		__func__, xprt, xprt->xp_fd, n, niov, (long int) result);
+
+	if (result <= 0)
+		return (0);
+
+	for (done = 0; done < n; done++) {
+		if (result < sizeof(hdr[0]) + len[done]) {
+			/* partly sent, left at the head */
+			if (result < sizeof(hdr[0])) {
+				xv[done]->frag_hdr_bytes_sent = result;
+			} else {
+				xv[done]->frag_hdr_bytes_sent = sizeof(hdr[0]);
+				xv[done]->write_start = result - sizeof(hdr[0]);
+			}
+			break;
+		}
+		result -= sizeof(hdr[0]) + len[done];
+	}
+
+	if (!done)
+		return (0);
+
+	mutex_lock(&rec->writeq.qmutex);
+	for (i = 0; i < done; i++)
+		TAILQ_REMOVE(&rec->writeq.qh, &xv[i]->ioq_s, q);
+	*next = TAILQ_FIRST(&rec->writeq.qh);
+	mutex_unlock(&rec->writeq.qmutex);
+
+	for (i = 0; i < done; i++) {
+		svc_ioq_budget_sent(rec, xv[i]);
+		SVC_RELEASE(xprt, SVC_RELEASE_FLAG_NONE);
+		XDR_DESTROY(xv[i]->xdrs);
+	}
+	return (done);
+}
+
 void svc_ioq_write(SVCXPRT *xprt)
 {
 	struct rpc_dplx_rec *rec = REC_XPRT(xprt);
@@ -333,6 +634,11 @@ void svc_ioq_write(SVCXPRT *xprt)
 	while (have != NULL) {
 		int rc = 0;
 
+		if (svc_work_pool.params.thrd_max
+		 && !(xprt->xp_flags & SVC_XPRT_FLAG_DESTROYED)
+		 && svc_ioq_flush_gather(xprt, rec, &have))
+			continue;
+
 		xioq = _IOQ(have);
 
 		/* Save has blocked before state */
@@ -404,6 +710,8 @@ void svc_ioq_write(SVCXPRT *xprt)
 		have = TAILQ_FIRST(&rec->writeq.qh);
 		mutex_unlock(&rec->writeq.qmutex);
 
+		svc_ioq_budget_sent(rec, xioq);
+
 		__warnx(TIRPC_DEBUG_FLAG_SVC_VC,
 			"%s: %p fd %d About to release",
 			__func__, xprt, xprt->xp_fd);
@@ -427,7 +735,7 @@ svc_ioq_write_now(SVCXPRT *xprt, struct xdr_ioq *xioq)
 	bool was_empty;
 
 	SVC_REF(xprt, SVC_REF_FLAG_NONE);
-
+	svc_ioq_budget_send(rec, xioq);
 
 	XPRT_UNIQUE_AUTO_TRACEPOINT(xprt, mutex_lock,
 		TRACE_DEBUG, "Locking mutex");
@@ -451,6 +759,41 @@ svc_ioq_write_now(SVCXPRT *xprt, struct xdr_ioq *xioq)
 	}
 }
 
+/*
+ * Queue several output requests in order, as one batch.
+ */
+void
+svc_ioq_write_submitv(SVCXPRT *xprt, struct xdr_ioq **xioqv, int count)
+{
+	struct rpc_dplx_rec *rec = REC_XPRT(xprt);
+	bool was_empty;
+	int i;
+
+	if (count <= 0)
+		return;
+
+	for (i = 0; i < count; i++) {
+		SVC_REF(xprt, SVC_REF_FLAG_NONE);
+		svc_ioq_budget_send(rec, xioqv[i]);
+	}
+
+	mutex_lock(&rec->writeq.qmutex);
+
+	was_empty = TAILQ_FIRST(&rec->writeq.qh) == NULL;
+
+	/* always queue output requests on the duplex record's writeq */
+	for (i = 0; i < count; i++)
+		TAILQ_INSERT_TAIL(&rec->writeq.qh, &(xioqv[i]->ioq_s), q);
+
+	mutex_unlock(&rec->writeq.qmutex);
+
+	if (was_empty) {
+		/* Schedule work to process output for this duplex record. */
+		xioqv[0]->ioq_wpe.fun = svc_ioq_write_callback;
+		work_pool_submit(&svc_work_pool, &xioqv[0]->ioq_wpe);
+	}
+}
+
 /*
  * Handle rare case of first output followed by heavy traffic that prevents the
  * original thread from continuing for too long.
@@ -465,6 +808,7 @@ svc_ioq_write_submit(SVCXPRT *xprt, struct xdr_ioq *xioq)
 	bool was_empty;
 
 	SVC_REF(xprt, SVC_REF_FLAG_NONE);
+	svc_ioq_budget_send(rec, xioq);
 
 	mutex_lock(&rec->writeq.qmutex);
 	XPRT_UNIQUE_AUTO_TRACEPOINT(xprt, mutex_lock, TRACE_DEBUG,
@@ -32,5 +32,11 @@
 void svc_ioq_write(SVCXPRT *);
 void svc_ioq_write_now(SVCXPRT *, struct xdr_ioq *);
 void svc_ioq_write_submit(SVCXPRT *, struct xdr_ioq *);
+void svc_ioq_write_submitv(SVCXPRT *, struct xdr_ioq **, int);
+
+bool svc_ioq_budget_control(int, struct rpc_mem_budget *);
+void svc_ioq_budget_recv(SVCXPRT *, struct xdr_ioq *);
+void svc_ioq_budget_release(struct xdr_ioq *);
+int svc_ioq_rearm_recv(SVCXPRT *);
 
 #endif				/* SVC_IOQ_H */
@@ -211,9 +211,9 @@ svc_rdma_decode(struct svc_req *req)
 	xdrs->x_op = XDR_DECODE;
 	rpc_msg_init(&req->rq_msg);
 
-	if (!xdr_dplx_decode(xdrs, &req->rq_msg)) {
+	if (!xdr_dplx_decode_ref(xdrs, &req->rq_msg, &req->rq_cred_ref)) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
-			"%s: xdr_dplx_decode failed",
+			"%s: xdr_dplx_decode_ref failed",
 			__func__);
 		return (XPRT_DIED);
 	}
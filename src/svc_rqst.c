@@ -289,35 +289,115 @@ svc_rqst_expire_cmpf(const struct opr_rbtree_node *lhs,
 	return (1);
 }
 
+/*
+ * Retransmit deadline, only kept by datagram clients (cr_rto set); any
+ * other cc_deadline_ms is ignored.
+ */
 static inline int
-svc_rqst_expire_ms(struct timespec *to)
+svc_rqst_expire_deadline(struct clnt_req *cc)
 {
-	struct timespec ts;
-
-	/* coarse nsec, not system time */
-	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &ts);
-	timespecadd(&ts, to, &ts);
-	return timespec_ms(&ts);
+	if (!CX_DATA(cc->cc_clnt)->cx_rtt.cr_rto)
+		return (0);
+	return (cc->cc_deadline_ms);
 }
 
-void
-svc_rqst_expire_insert(struct clnt_req *cc)
+/*
+ * Datagram calls expire first at the estimated retransmit timeout,
+ * bounded by their deadline.
+ */
+static inline int
+svc_rqst_expire_next(struct clnt_req *cc, int now_ms)
 {
-	struct cx_data *cx = CX_DATA(cc->cc_clnt);
-	struct svc_rqst_rec *sr_rec = cx->cx_rec->ev_p;
-	struct opr_rbtree_node *nv;
+	int expire_ms = now_ms + clnt_rtt_timeout_ms(CX_DATA(cc->cc_clnt));
 
-	cc->cc_expire_ms = svc_rqst_expire_ms(&cc->cc_timeout);
+	if (expire_ms > cc->cc_deadline_ms)
+		return cc->cc_deadline_ms;
+	return expire_ms;
+}
 
-	mutex_lock(&sr_rec->ev_lock);
-	cc->cc_flags = CLNT_REQ_FLAG_EXPIRING;
+/*
+ * called locked
+ */
+static inline void
+svc_rqst_expire_insert_locked(struct svc_rqst_rec *sr_rec,
+			      struct clnt_req *cc)
+{
  repeat:
-	nv = opr_rbtree_insert(&sr_rec->call_expires, &cc->cc_rqst);
-	if (nv) {
+	if (opr_rbtree_insert(&sr_rec->call_expires, &cc->cc_rqst)) {
 		/* add this slightly later */
 		cc->cc_expire_ms++;
 		goto repeat;
 	}
+}
+
+static inline struct svc_rqst_rec *
+svc_rqst_expire_chan(struct clnt_req *cc)
+{
+	struct cx_data *cx = CX_DATA(cc->cc_clnt);
+	struct svc_rqst_rec *sr_rec = cx->cx_rec->ev_p;
+
+	if (unlikely(!sr_rec)) {
+		/* transport already unregistered; expire on the global
+		 * channel (channels are only freed at shutdown)
+		 */
+		sr_rec = svc_rqst_lookup_chan(__svc_params->ev_u.evchan.id);
+		if (!sr_rec) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: %p xid %" PRIu32 " no event channel",
+				__func__, cc, cc->cc_xid);
+			return (NULL);
+		}
+		atomic_dec_int32_t(&sr_rec->ev_refcnt);
+	}
+	return (sr_rec);
+}
+
+/*
+ * Calls on the same event channel are inserted under one ev_lock, with
+ * one wakeup.
+ */
+void
+svc_rqst_expire_insertv(struct clnt_req **ccv, int count)
+{
+	struct svc_rqst_rec *sr_rec = NULL;
+	struct svc_rqst_rec *next;
+	struct clnt_req *cc;
+	struct timespec now;
+	struct timespec ts;
+	int now_ms;
+	int i;
+
+	/* coarse nsec, not system time */
+	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &now);
+	now_ms = timespec_ms(&now);
+
+	for (i = 0; i < count; i++) {
+		cc = ccv[i];
+		next = svc_rqst_expire_chan(cc);
+		if (!next)
+			continue;
+
+		cc->cc_expires = next;
+		timespecadd(&now, &cc->cc_timeout, &ts);
+		cc->cc_expire_ms = timespec_ms(&ts);
+		if (svc_rqst_expire_deadline(cc))
+			cc->cc_expire_ms = svc_rqst_expire_next(cc, now_ms);
+
+		if (next != sr_rec) {
+			if (sr_rec) {
+				mutex_unlock(&sr_rec->ev_lock);
+				ev_sig(sr_rec->sv[0], 0);
+			}
+			sr_rec = next;
+			mutex_lock(&sr_rec->ev_lock);
+		}
+		/* not yet sent: only its credit is kept */
+		cc->cc_flags = CLNT_REQ_FLAG_EXPIRING
+			     | (cc->cc_flags & CLNT_REQ_FLAG_CREDIT);
+		svc_rqst_expire_insert_locked(sr_rec, cc);
+	}
+	if (!sr_rec)
+		return;
 	mutex_unlock(&sr_rec->ev_lock);
 
 	__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
@@ -327,11 +407,17 @@ svc_rqst_expire_insert(struct clnt_req *cc)
 	ev_sig(sr_rec->sv[0], 0);	/* send wakeup */
 }
 
+void
+svc_rqst_expire_insert(struct clnt_req *cc)
+{
+	svc_rqst_expire_insertv(&cc, 1);
+}
+
 void
 svc_rqst_expire_remove(struct clnt_req *cc)
 {
-	struct cx_data *cx = CX_DATA(cc->cc_clnt);
-	struct svc_rqst_rec *sr_rec = cx->cx_rec->ev_p;
+	/* not cx_rec->ev_p, cleared when its transport is destroyed */
+	struct svc_rqst_rec *sr_rec = cc->cc_expires;
 
 	mutex_lock(&sr_rec->ev_lock);
 	opr_rbtree_remove(&sr_rec->call_expires, &cc->cc_rqst);
@@ -363,6 +449,23 @@ svc_rqst_expire_task(struct work_pool_entry *wpe)
 	clnt_req_release(cc);
 }
 
+/*
+ * Retransmit a datagram call, still EXPIRING at its next timeout.
+ * The reply may have arrived meanwhile.
+ */
+static void
+svc_rqst_resend_task(struct work_pool_entry *wpe)
+{
+	struct clnt_req *cc = opr_containerof(wpe, struct clnt_req, cc_wpe);
+
+	if (!(atomic_fetch_uint16_t(&cc->cc_flags)
+	      & (CLNT_REQ_FLAG_ACKSYNC | CLNT_REQ_FLAG_BACKSYNC)))
+		(void)CLNT_CALL_ONCE(cc);
+
+	atomic_clear_uint16_t_bits(&cc->cc_flags, CLNT_REQ_FLAG_RESENDING);
+	clnt_req_release(cc);
+}
+
 static inline void
 svc_rqst_release(struct svc_rqst_rec *sr_rec)
 {
@@ -1214,6 +1317,35 @@ svc_rqst_xprt_task_recv(struct work_pool_entry *wpe)
 	SVC_RELEASE(&rec->xprt, SVC_RELEASE_FLAG_NONE);
 }
 
+/*
+ * Release a finished request.  Results decoded from a borrowing stream
+ * (XDR_FLAG_BORROW) may point into its buffers, so these are kept until
+ * after the free_cb; the extra reference holds the transport for the
+ * stream destroy.  Likewise the decode arena.
+ */
+static void svc_request_done(struct svc_req *req, enum xprt_stat stat)
+{
+	XDR *xdrs = req->rq_xdrs;
+	SVCXPRT *xprt = req->rq_xprt;
+	struct xdr_arena *xa = req->rq_arena;
+
+	if (req->rq_auth)
+		SVCAUTH_RELEASE(req);
+
+	xdrs->x_flags &= ~XDR_FLAG_ARENA;
+	if (!(xdrs->x_flags & XDR_FLAG_BORROW)) {
+		XDR_DESTROY(xdrs);
+		__svc_params->free_cb(req, stat);
+	} else {
+		SVC_REF(xprt, SVC_REF_FLAG_NONE);
+		__svc_params->free_cb(req, stat);
+		XDR_DESTROY(xdrs);
+		SVC_RELEASE(xprt, SVC_RELEASE_FLAG_NONE);
+	}
+	if (xa)
+		xdr_arena_destroy(xa);
+}
+
 enum xprt_stat svc_request(SVCXPRT *xprt, XDR *xdrs)
 {
 	enum xprt_stat stat;
@@ -1223,6 +1355,16 @@ enum xprt_stat svc_request(SVCXPRT *xprt, XDR *xdrs)
 	/* Track the request we are processing */
 	rpc_dplx_rec->svc_req = req;
 
+	/* unless borrowed by the transport decode */
+	req->rq_cred_ref = req->rq_msg.cb_cred.oa_body;
+
+	req->rq_arena = NULL;
+	if (__svc_params->req.arena) {
+		req->rq_arena = xdr_arena_create(__svc_params->req.arena);
+		xdrs->x_arena = req->rq_arena;
+		xdrs->x_flags |= XDR_FLAG_ARENA;
+	}
+
 	/* All decode functions basically do a
 	 * return xprt->xp_dispatch.process_cb(req);
 	 */
@@ -1236,12 +1378,7 @@ enum xprt_stat svc_request(SVCXPRT *xprt, XDR *xdrs)
 		return XPRT_SUSPEND;
 	}
 
-	if (req->rq_auth)
-		SVCAUTH_RELEASE(req);
-
-	XDR_DESTROY(req->rq_xdrs);
-
-	__svc_params->free_cb(req, stat);
+	svc_request_done(req, stat);
 
 	return stat;
 }
@@ -1263,12 +1400,7 @@ static void svc_resume_task(struct work_pool_entry *wpe)
 		return;
 	}
 
-	if (req->rq_auth)
-		SVCAUTH_RELEASE(req);
-
-	XDR_DESTROY(req->rq_xdrs);
-
-	__svc_params->free_cb(req, stat);
+	svc_request_done(req, stat);
 }
 
 void svc_resume(struct svc_req *req)
@@ -1331,6 +1463,7 @@ svc_rqst_clean_func(SVCXPRT *xprt, void *arg)
 }
 
 void authgss_ctx_gc_idle(void);
+void xdr_ioq_pool_gc_idle(void);
 
 static void
 svc_rqst_clean_idle(int timeout)
@@ -1352,6 +1485,10 @@ svc_rqst_clean_idle(int timeout)
 	authgss_ctx_gc_idle();
 #endif /* _HAVE_GSSAPI */
 
+	/* trim shared client cache and idle ioq buffer chunks */
+	clnt_cache_gc_idle();
+	xdr_ioq_pool_gc_idle();
+
 	if (timeout <= 0)
 		goto unlock;
 
@@ -1513,8 +1650,10 @@ static void svc_rqst_epoll_loop(struct work_pool_entry *wpe)
 	struct timespec ts;
 	int timeout_ms;
 	int expire_ms;
+	int deadline_ms;
 	int n_events;
 	bool finished;
+	bool resend;
 
 	for (;;) {
 		timeout_ms = SVC_RQST_TIMEOUT_MS;
@@ -1533,9 +1672,51 @@ static void svc_rqst_epoll_loop(struct work_pool_entry *wpe)
 				break;
 			}
 
+			deadline_ms = svc_rqst_expire_deadline(cc);
+			if (deadline_ms > expire_ms
+			 || (atomic_fetch_uint16_t(&cc->cc_flags)
+			     & CLNT_REQ_FLAG_RESENDING)) {
+				/* still EXPIRING, at the next timeout.  A
+				 * pending retransmit owns cc_wpe, so none is
+				 * added, and the final expiry waits for it.
+				 */
+				opr_rbtree_remove(&sr_rec->call_expires,
+						  &cc->cc_rqst);
+				resend = deadline_ms > expire_ms
+				      && !(atomic_postset_uint16_t_bits(
+						&cc->cc_flags,
+						CLNT_REQ_FLAG_RESENDING)
+					   & CLNT_REQ_FLAG_RESENDING);
+				if (resend) {
+					atomic_set_uint16_t_bits(&cc->cc_flags,
+						CLNT_REQ_FLAG_RETRANS);
+					clnt_rtt_backoff(CX_DATA(cc->cc_clnt));
+				}
+				cc->cc_expire_ms = (deadline_ms > expire_ms)
+					? svc_rqst_expire_next(cc, expire_ms)
+					: expire_ms + 1;
+				svc_rqst_expire_insert_locked(sr_rec, cc);
+
+				if (resend) {
+					atomic_inc_uint32_t(&cc->cc_refcnt);
+					cc->cc_wpe.fun = svc_rqst_resend_task;
+					cc->cc_wpe.arg = NULL;
+					work_pool_submit(&svc_work_pool,
+							 &cc->cc_wpe);
+				}
+				continue;
+			}
+
 			/* order dependent */
-			atomic_clear_uint16_t_bits(&cc->cc_flags,
-						   CLNT_REQ_FLAG_EXPIRING);
+			if (!(atomic_postclear_uint16_t_bits(&cc->cc_flags,
+						CLNT_REQ_FLAG_EXPIRING)
+			      & CLNT_REQ_FLAG_EXPIRING)) {
+				/* its reply owns the removal, and waits for
+				 * ev_lock; removing here too corrupts the tree.
+				 */
+				timeout_ms = 1;
+				break;
+			}
 			opr_rbtree_remove(&sr_rec->call_expires, &cc->cc_rqst);
 			cc->cc_expire_ms = 0;	/* atomic barrier(s) */
 
@@ -1606,6 +1787,9 @@ static void svc_rqst_epoll_loop(struct work_pool_entry *wpe)
 				sr_rec, sr_rec->id_k, sr_rec->ev_refcnt,
 				sr_rec->ev_u.epoll.epoll_fd);
 			atomic_inc_uint32_t(&wakeups);
+
+			/* no events to trigger it */
+			svc_rqst_clean_idle(__svc_params->idle_timeout);
 			continue;
 		}
 		n_events = errno;
@@ -1674,7 +1858,7 @@ svc_rqst_thrd_signal(uint32_t chan_id, uint32_t flags)
 	return (0);
 }
 
-static int
+int
 svc_rqst_delete_evchan(uint32_t chan_id)
 {
 	struct svc_rqst_rec *sr_rec;
@@ -660,6 +660,9 @@ svc_vc_control(SVCXPRT *xprt, const u_int rq, void *in)
 	case SVCSET_XP_FLAGS:
 		xprt->xp_flags = *(u_int *) in;
 		break;
+	case SVCGET_XP_MEM_STAT:
+		*(struct rpc_xprt_mem_stat *) in = REC_XPRT(xprt)->mem;
+		break;
 	case SVCGET_XP_UNREF_USER_DATA:
 		mutex_lock(&ops_lock);
 		*(svc_xprt_void_fun_t *) in = xprt->xp_ops->xp_unref_user_data;
@@ -1149,6 +1152,9 @@ again:
 	(rec->ioq.ioq_uv.uvqh.qcount)--;
 	TAILQ_REMOVE(&rec->ioq.ioq_uv.uvqh.qh, &xioq->ioq_s, q);
 	xdr_ioq_reset(xioq, 0);
+	svc_ioq_budget_recv(xprt, xioq);
+	/* held until the request is freed: opaques may be borrowed */
+	xioq->xdrs[0].x_flags |= XDR_FLAG_BORROW;
 
 	if (!is_remote_addr_set(xprt)) {
 		if (!update_and_notify_remote_address_set(xprt)) {
@@ -1157,7 +1163,7 @@ again:
 		}
 	}
 
-	if (unlikely(svc_rqst_rearm_events(xprt, SVC_XPRT_FLAG_ADDED_RECV))) {
+	if (unlikely(svc_ioq_rearm_recv(xprt))) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s: %p fd %d svc_rqst_rearm_events failed (will set dead)",
 			__func__, xprt, xprt->xp_fd);
@@ -1188,7 +1194,7 @@ svc_vc_decode(struct svc_req *req)
 	xdrs->x_op = XDR_DECODE;
 	rpc_msg_init(&req->rq_msg);
 
-	if (!xdr_dplx_decode(xdrs, &req->rq_msg)) {
+	if (!xdr_dplx_decode_ref(xdrs, &req->rq_msg, &req->rq_cred_ref)) {
 		/* stream is unsynchronized beyond recovery */
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s: %p fd %d failed (will set dead)",
@@ -1230,6 +1236,41 @@ svc_vc_checksum(struct svc_req *req, void *data, size_t length)
 #endif
 }
 
+/*
+ * With RPC_SVC_XDR_SIZING_SET, size the reply before encoding, so that
+ * its first buffer holds all but the data passed by reference, with no
+ * further allocation.  RPCSEC_GSS adds a databody length, sequence, and
+ * checksum (or places the results in buffers of this size).
+ */
+static u_int
+svc_vc_reply_size(struct svc_req *req)
+{
+	struct rpc_msg *msg = &req->rq_msg;
+	XDR xdrs[1];
+	u_int slack = 0;
+	u_int size;
+
+	if (!__svc_params->req.sizing)
+		return (RPC_MAXDATA_DEFAULT);
+
+	xdrsize_create(xdrs);
+	if (!xdr_reply_encode(xdrs, msg))
+		return (RPC_MAXDATA_DEFAULT);
+
+	if (msg->rm_reply.rp_stat == MSG_ACCEPTED
+	 && msg->rm_reply.rp_acpt.ar_stat == SUCCESS
+	 && req->rq_auth) {
+		if (!(*msg->RPCM_ack.ar_results.proc)
+				(xdrs, msg->RPCM_ack.ar_results.where))
+			return (RPC_MAXDATA_DEFAULT);
+		if (msg->cb_cred.oa_flavor == RPCSEC_GSS)
+			slack = 2 * BYTES_PER_XDR_UNIT + MAX_AUTH_BYTES;
+	}
+
+	size = xdrsize_length(xdrs) - xdrsize_refer(xdrs) + slack;
+	return (MIN(size, __svc_params->ioq.send_max + RPC_MAXDATA_DEFAULT));
+}
+
 static enum xprt_stat
 svc_vc_reply(struct svc_req *req)
 {
@@ -1239,7 +1280,7 @@ svc_vc_reply(struct svc_req *req)
 	/* Nb, we should probably use getpagesize() on Unix.  Need
 	 * an equivalent for Windows.
 	 */
-	xioq = xdr_ioq_create(RPC_MAXDATA_DEFAULT,
+	xioq = xdr_ioq_create(svc_vc_reply_size(req),
 			      __svc_params->ioq.send_max + RPC_MAXDATA_DEFAULT,
 			      UIO_FLAG_FREE);
 
@@ -176,6 +176,175 @@ xdr_netobj(XDR *xdrs, struct netobj *np)
 	return (xdr_bytes(xdrs, &np->n_bytes, &np->n_len, MAX_NETOBJ_SZ));
 }
 
+/*
+ * XDR bulk opaque<>
+ *
+ * On a vector stream (xdr_ioq), the xb_uio segments are queued by
+ * reference (XDR_PUTBUFS) and sent from the caller's memory, which must
+ * not change until the call completes.  Each segment reference dropped
+ * calls uio_release().  Other streams copy the segments, then call
+ * uio_release() once (xdr_uio_copied).  The caller's own reference is
+ * never taken.
+ *
+ * Decoding places the data at xb_base, of at most xb_size bytes, rather
+ * than allocating.
+ */
+bool
+xdr_bulk(XDR *xdrs, struct xdr_bulk *xb)
+{
+	xdr_uio *uio = xb->xb_uio;
+	xdr_vio *v;
+	uint32_t zero = 0;
+	u_int rndup;
+	int ix;
+
+	switch (xdrs->x_op) {
+	case XDR_ENCODE:
+		if (!uio) {
+			return (XDR_PUTUINT32(xdrs, xb->xb_len)
+				&& xdr_opaque_encode(xdrs, xb->xb_base,
+						     xb->xb_len));
+		}
+		xb->xb_len = 0;
+		for (ix = 0; ix < uio->uio_count; ix++) {
+			v = &uio->uio_vio[ix];
+			xb->xb_len += (uintptr_t)v->vio_tail
+				    - (uintptr_t)v->vio_head;
+		}
+		if (!XDR_PUTUINT32(xdrs, xb->xb_len))
+			return (false);
+
+		if (xdrs->x_flags & XDR_FLAG_VIO) {
+			if (!XDR_PUTBUFS(xdrs, uio, XDR_PUTBUFS_FLAG_NONE))
+				return (false);
+		} else {
+			for (ix = 0; ix < uio->uio_count; ix++) {
+				v = &uio->uio_vio[ix];
+				if (!XDR_PUTBYTES(xdrs, (char *)v->vio_head,
+						  (uintptr_t)v->vio_tail
+						  - (uintptr_t)v->vio_head))
+					break;
+			}
+			xdr_uio_copied(uio);
+			if (ix < uio->uio_count)
+				return (false);
+		}
+
+		rndup = xb->xb_len & (BYTES_PER_XDR_UNIT - 1);
+		if (rndup > 0)
+			return (XDR_PUTBYTES(xdrs, (char *)&zero,
+					     BYTES_PER_XDR_UNIT - rndup));
+		return (true);
+	case XDR_DECODE:
+		if (!XDR_GETUINT32(xdrs, &xb->xb_len))
+			return (false);
+		if (xb->xb_len > xb->xb_size) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s:%u ERROR size %u > room %u",
+				__func__, __LINE__, xb->xb_len, xb->xb_size);
+			return (false);
+		}
+		return (xdr_opaque_decode(xdrs, xb->xb_base, xb->xb_len));
+	case XDR_FREE:
+		return (true);
+	}
+	/* NOTREACHED */
+	return (false);
+}
+
+/*
+ * XDR borrowed opaques
+ *
+ * On a stream marked XDR_FLAG_BORROW (such as a connection oriented
+ * service request, valid until its free_cb), data within one buffer is
+ * returned by reference, uncopied.  Data spanning buffers, or from
+ * other streams, is copied to allocated memory (XDR_REF_ALLOC), freed by
+ * XDR_FREE; references are left alone.
+ */
+static bool
+xdr_ref_decode(XDR *xdrs, struct xdr_ref *xr, u_int cnt)
+{
+	uint8_t *future = xdrs->x_data + RNDUP(cnt);
+
+	xr->xr_len = cnt;
+	xr->xr_flags = 0;
+	if (!cnt) {
+		xr->xr_base = NULL;
+		return (true);
+	}
+	if ((xdrs->x_flags & XDR_FLAG_BORROW)
+	 && future <= xdrs->x_v.vio_tail) {
+		xr->xr_base = (char *)xdrs->x_data;
+		xdrs->x_data = future;
+		return (true);
+	}
+
+	xr->xr_base = xdr_alloc(xdrs, cnt);
+	if (!xdr_opaque_decode(xdrs, xr->xr_base, cnt)) {
+		xdr_unalloc(xdrs, xr->xr_base, cnt);
+		xr->xr_base = NULL;
+		return (false);
+	}
+	if (!(xdrs->x_flags & XDR_FLAG_ARENA))
+		xr->xr_flags = XDR_REF_ALLOC;
+	return (true);
+}
+
+static bool
+xdr_ref_free(struct xdr_ref *xr)
+{
+	if (xr->xr_flags & XDR_REF_ALLOC)
+		mem_free(xr->xr_base, xr->xr_len);
+	xr->xr_base = NULL;
+	xr->xr_flags = 0;
+	return (true);
+}
+
+/* fixed length opaque[cnt] */
+bool
+xdr_opaque_ref(XDR *xdrs, struct xdr_ref *xr, u_int cnt)
+{
+	switch (xdrs->x_op) {
+	case XDR_ENCODE:
+		return (xdr_opaque_encode(xdrs, xr->xr_base, cnt));
+	case XDR_DECODE:
+		return (xdr_ref_decode(xdrs, xr, cnt));
+	case XDR_FREE:
+		return (xdr_ref_free(xr));
+	}
+	/* NOTREACHED */
+	return (false);
+}
+
+/* counted opaque<maxsize> or string<maxsize> */
+bool
+xdr_bytes_ref(XDR *xdrs, struct xdr_ref *xr, u_int maxsize)
+{
+	uint32_t size;
+
+	switch (xdrs->x_op) {
+	case XDR_ENCODE:
+		if (xr->xr_len > maxsize)
+			return (false);
+		return (XDR_PUTUINT32(xdrs, xr->xr_len)
+			&& xdr_opaque_encode(xdrs, xr->xr_base, xr->xr_len));
+	case XDR_DECODE:
+		if (!XDR_GETUINT32(xdrs, &size))
+			return (false);
+		if (size > maxsize) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s:%u ERROR size %u > max %u",
+				__func__, __LINE__, size, maxsize);
+			return (false);
+		}
+		return (xdr_ref_decode(xdrs, xr, size));
+	case XDR_FREE:
+		return (xdr_ref_free(xr));
+	}
+	/* NOTREACHED */
+	return (false);
+}
+
 /*
  * Non-portable xdr primitives.
  * Care should be taken when moving these routines to new architectures.
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+/*
+ * xdr_arena.c, bump allocation of decoded objects.
+ *
+ * An arena is a list of chunks, the first holding the arena itself.
+ * Objects are carved from the current chunk in order; one too large for
+ * half a chunk gets a chunk of its own, leaving the current one in use.
+ * Nothing is freed until the whole arena is.
+ */
+
+#include <sys/types.h>
+
+#include <rpc/types.h>
+#include <rpc/xdr.h>
+
+struct xdr_arena_chunk {
+	struct xdr_arena_chunk *xc_next;
+	size_t xc_size;
+};
+
+#define XDR_ARENA_RND(n) \
+	(((n) + XDR_ARENA_ALIGN - 1) & ~((size_t)XDR_ARENA_ALIGN - 1))
+#define XDR_ARENA_HEAD XDR_ARENA_RND(sizeof(struct xdr_arena))
+#define XDR_CHUNK_HEAD XDR_ARENA_RND(sizeof(struct xdr_arena_chunk))
+
+struct xdr_arena *
+xdr_arena_create(size_t size)
+{
+	struct xdr_arena *xa;
+
+	size = XDR_ARENA_RND(size);
+	xa = mem_alloc(XDR_ARENA_HEAD + size);
+	xa->xa_next = (uint8_t *)xa + XDR_ARENA_HEAD;
+	xa->xa_end = xa->xa_next + size;
+	xa->xa_chunks = NULL;
+	xa->xa_size = size;
+	return (xa);
+}
+
+/* size is rounded; called by xdr_arena_alloc() when it does not fit */
+void *
+xdr_arena_grow(struct xdr_arena *xa, size_t size)
+{
+	struct xdr_arena_chunk *xc;
+	uint8_t *p;
+
+	if (size > xa->xa_size / 2) {
+		xc = mem_alloc(XDR_CHUNK_HEAD + size);
+		xc->xc_size = size;
+		xc->xc_next = xa->xa_chunks;
+		xa->xa_chunks = xc;
+		return ((uint8_t *)xc + XDR_CHUNK_HEAD);
+	}
+
+	xc = mem_alloc(XDR_CHUNK_HEAD + xa->xa_size);
+	xc->xc_size = xa->xa_size;
+	xc->xc_next = xa->xa_chunks;
+	xa->xa_chunks = xc;
+
+	p = (uint8_t *)xc + XDR_CHUNK_HEAD;
+	xa->xa_next = p + size;
+	xa->xa_end = p + xa->xa_size;
+	return (p);
+}
+
+void
+xdr_arena_destroy(struct xdr_arena *xa)
+{
+	struct xdr_arena_chunk *xc = xa->xa_chunks;
+	struct xdr_arena_chunk *next;
+
+	for (; xc; xc = next) {
+		next = xc->xc_next;
+		mem_free(xc, XDR_CHUNK_HEAD + xc->xc_size);
+	}
+	mem_free(xa, XDR_ARENA_HEAD + xa->xa_size);
+}
@@ -56,6 +56,7 @@
 #endif
 
 #include <rpc/xdr_ioq.h>
+#include "svc_ioq.h"
 
 #define VREC_MAXBUFS 24
 
@@ -94,13 +95,326 @@ timespec_diff(const struct timespec *start,
         }
 }
 
+/*
+ * Chunked buffer pool for socket transports.
+ *
+ * UIO_FLAG_FREE buffers (TCP fragments, replies) are carved from larger
+ * chunks in power of two size classes.  Only chunks with free buffers
+ * are listed, partly used first, so an allocation takes the first and
+ * wholly free chunks age at the end.  Like the RDMA io_bufs, an extra
+ * chunk with no buffers outstanding is freed after it has been idle for
+ * XDR_IOQ_SHRINK_WAIT_NS (by the svc_rqst idle processing), or at once
+ * by xdr_ioq_pool_trim() under memory pressure, but never below the low
+ * watermark.  Above the high watermark, buffers are allocated outside
+ * the pool.
+ */
+#define XDR_IOQ_POOL_MIN_SHIFT	12	/* 4 KiB */
+#define XDR_IOQ_POOL_CLASSES	9	/* through 1 MiB */
+#define XDR_IOQ_CHUNK_SIZE	(256 * 1024)
+#define XDR_IOQ_SHRINK_WAIT_NS	(NS_PER_SEC * 60ULL)
+
+struct xdr_ioq_pool_class;
+
+struct xdr_ioq_chunk {
+	struct poolq_entry q;		/* class avail, while nfree */
+	struct xdr_ioq_pool_class *cls;
+	uint8_t *base;
+	void *free;			/* linked through first word */
+	struct timespec last_used;
+	u_int nbufs;
+	u_int nfree;
+};
+
+struct xdr_ioq_pool_class {
+	struct poolq_head avail;	/* chunks with free buffers */
+	size_t bsize;
+	size_t csize;
+};
+
+static struct xdr_ioq_pool_class xdr_ioq_pool[XDR_IOQ_POOL_CLASSES];
+static pthread_once_t xdr_ioq_pool_once = PTHREAD_ONCE_INIT;
+
+static struct rpc_ioq_pool_stat xdr_ioq_pool_stat = {
+	.high_wat = 64 * 1024 * 1024,
+	.low_wat = 4 * 1024 * 1024,
+};
+
+static void
+xdr_ioq_pool_init(void)
+{
+	struct xdr_ioq_pool_class *cls = xdr_ioq_pool;
+	int i;
+
+	for (i = 0; i < XDR_IOQ_POOL_CLASSES; i++, cls++) {
+		poolq_head_setup(&cls->avail);
+		cls->bsize = (size_t)1 << (XDR_IOQ_POOL_MIN_SHIFT + i);
+		cls->csize = MAX(XDR_IOQ_CHUNK_SIZE, cls->bsize);
+	}
+}
+
+static struct xdr_ioq_chunk *
+xdr_ioq_chunk_create(struct xdr_ioq_pool_class *cls)
+{
+	struct xdr_ioq_chunk *chunk = mem_zalloc(sizeof(*chunk));
+	uint8_t *buf;
+
+	chunk->cls = cls;
+	chunk->base = alloc_buffer(cls->csize);
+	chunk->nbufs =
+	chunk->nfree = cls->csize / cls->bsize;
+
+	for (buf = chunk->base + cls->csize - cls->bsize;
+	     buf >= chunk->base; buf -= cls->bsize) {
+		*(void **)buf = chunk->free;
+		chunk->free = buf;
+	}
+
+	atomic_add_size_t(&xdr_ioq_pool_stat.total, cls->csize);
+	atomic_inc_uint64_t(&xdr_ioq_pool_stat.chunks_alloc);
+
+	__warnx(TIRPC_DEBUG_FLAG_XDR,
+		"%s() chunk %p bsize %zu nbufs %u",
+		__func__, chunk, cls->bsize, chunk->nbufs);
+	return (chunk);
+}
+
+/* must be called with cls->avail.qmutex held */
+static void
+xdr_ioq_chunk_destroy_locked(struct xdr_ioq_chunk *chunk)
+{
+	struct xdr_ioq_pool_class *cls = chunk->cls;
+
+	assert(chunk->nfree == chunk->nbufs);
+
+	TAILQ_REMOVE(&cls->avail.qh, &chunk->q, q);
+	(cls->avail.qcount)--;
+
+	atomic_sub_size_t(&xdr_ioq_pool_stat.total, cls->csize);
+	atomic_inc_uint64_t(&xdr_ioq_pool_stat.chunks_freed);
+
+	__warnx(TIRPC_DEBUG_FLAG_XDR,
+		"%s() chunk %p bsize %zu",
+		__func__, chunk, cls->bsize);
+
+	free_buffer(chunk->base, cls->csize);
+	mem_free(chunk, sizeof(*chunk));
+}
+
+/*
+ * Free every idle chunk of a class, keeping the low watermark.  When
+ * wait_ns is non-zero, only chunks idle that long.
+ *
+ * must be called with cls->avail.qmutex held
+ */
+static size_t
+xdr_ioq_pool_shrink_locked(struct xdr_ioq_pool_class *cls, uint64_t wait_ns)
+{
+	struct poolq_entry *have = TAILQ_LAST(&cls->avail.qh, poolq_head_s);
+	struct timespec now;
+	size_t freed = 0;
+
+	if (wait_ns)
+		clock_gettime(CLOCK_MONOTONIC_FAST, &now);
+
+	while (have) {
+		struct poolq_entry *prev = TAILQ_PREV(have, poolq_head_s, q);
+		struct xdr_ioq_chunk *chunk =
+			opr_containerof(have, struct xdr_ioq_chunk, q);
+
+		if (atomic_fetch_size_t(&xdr_ioq_pool_stat.total)
+		    < xdr_ioq_pool_stat.low_wat + cls->csize)
+			break;
+
+		if (chunk->nfree == chunk->nbufs
+		    && (!wait_ns
+			|| timespec_diff(&chunk->last_used, &now) >= wait_ns)) {
+			xdr_ioq_chunk_destroy_locked(chunk);
+			freed += cls->csize;
+		}
+		have = prev;
+	}
+	return (freed);
+}
+
+static void
+xdr_ioq_pool_uv_release(struct xdr_uio *uio, u_int flags)
+{
+	struct xdr_ioq_uv *uv = IOQU(uio);
+	struct xdr_ioq_chunk *chunk = uio->uio_p1;
+	struct xdr_ioq_pool_class *cls = chunk->cls;
+
+	pthread_mutex_lock(&cls->avail.qmutex);
+
+	*(void **)uio->uio_p2 = chunk->free;
+	chunk->free = uio->uio_p2;
+
+	if (++(chunk->nfree) == chunk->nbufs) {
+		/* wholly free, to age at the end */
+		clock_gettime(CLOCK_MONOTONIC_FAST, &chunk->last_used);
+		if (chunk->nfree > 1)
+			TAILQ_REMOVE(&cls->avail.qh, &chunk->q, q);
+		else
+			(cls->avail.qcount)++;
+		TAILQ_INSERT_TAIL(&cls->avail.qh, &chunk->q, q);
+	} else if (chunk->nfree == 1) {
+		(cls->avail.qcount)++;
+		TAILQ_INSERT_HEAD(&cls->avail.qh, &chunk->q, q);
+	}
+
+	pthread_mutex_unlock(&cls->avail.qmutex);
+
+	atomic_sub_size_t(&xdr_ioq_pool_stat.in_use, cls->bsize);
+	mem_free(uv, sizeof(*uv));
+}
+
+/*
+ * Get a pooled buffer of at least size bytes, NULL when the size is
+ * too large or the pool has reached its high watermark.
+ */
+static uint8_t *
+xdr_ioq_pool_get(size_t size, struct xdr_ioq_chunk **pchunk)
+{
+	struct xdr_ioq_pool_class *cls = xdr_ioq_pool;
+	struct xdr_ioq_chunk *chunk = NULL;
+	struct poolq_entry *have;
+	uint8_t *buf;
+	int i;
+
+	if (!xdr_ioq_pool_stat.high_wat)
+		return (NULL);
+
+	for (i = 0; cls->bsize < size; i++, cls++) {
+		if (i + 1 >= XDR_IOQ_POOL_CLASSES)
+			return (NULL);
+	}
+
+	pthread_mutex_lock(&cls->avail.qmutex);
+
+	have = TAILQ_FIRST(&cls->avail.qh);
+	if (have) {
+		chunk = opr_containerof(have, struct xdr_ioq_chunk, q);
+	} else {
+		if (atomic_fetch_size_t(&xdr_ioq_pool_stat.total) + cls->csize
+		    > xdr_ioq_pool_stat.high_wat) {
+			pthread_mutex_unlock(&cls->avail.qmutex);
+			atomic_inc_uint64_t(&xdr_ioq_pool_stat.overflow);
+			return (NULL);
+		}
+		chunk = xdr_ioq_chunk_create(cls);
+		(cls->avail.qcount)++;
+		TAILQ_INSERT_HEAD(&cls->avail.qh, &chunk->q, q);
+	}
+
+	buf = chunk->free;
+	chunk->free = *(void **)buf;
+	if (!--(chunk->nfree)) {
+		TAILQ_REMOVE(&cls->avail.qh, &chunk->q, q);
+		(cls->avail.qcount)--;
+	}
+
+	pthread_mutex_unlock(&cls->avail.qmutex);
+
+	atomic_add_size_t(&xdr_ioq_pool_stat.in_use, cls->bsize);
+	*pchunk = chunk;
+	return (buf);
+}
+
+/*
+ * Release idle chunks down to the low watermark, regardless of age.
+ * Intended for memory pressure notification (PSI or cgroup memory.high
+ * events) by the application, usually via rpc_control(RPC_SVC_IOQ_TRIM).
+ *
+ * @return bytes released
+ */
+size_t
+xdr_ioq_pool_trim(void)
+{
+	struct xdr_ioq_pool_class *cls = xdr_ioq_pool;
+	size_t freed = 0;
+	int i;
+
+	pthread_once(&xdr_ioq_pool_once, xdr_ioq_pool_init);
+
+	for (i = 0; i < XDR_IOQ_POOL_CLASSES; i++, cls++) {
+		pthread_mutex_lock(&cls->avail.qmutex);
+		freed += xdr_ioq_pool_shrink_locked(cls, 0);
+		pthread_mutex_unlock(&cls->avail.qmutex);
+	}
+
+	__warnx(TIRPC_DEBUG_FLAG_EVENT,
+		"%s() released %zu bytes, %zu remain",
+		__func__, freed,
+		atomic_fetch_size_t(&xdr_ioq_pool_stat.total));
+	return (freed);
+}
+
+/*
+ * Periodic (svc_rqst idle processing).  Release chunks idle for
+ * XDR_IOQ_SHRINK_WAIT_NS, down to the low watermark.
+ */
+void
+xdr_ioq_pool_gc_idle(void)
+{
+	struct xdr_ioq_pool_class *cls = xdr_ioq_pool;
+	size_t freed = 0;
+	int i;
+
+	pthread_once(&xdr_ioq_pool_once, xdr_ioq_pool_init);
+
+	for (i = 0; i < XDR_IOQ_POOL_CLASSES; i++, cls++) {
+		pthread_mutex_lock(&cls->avail.qmutex);
+		freed += xdr_ioq_pool_shrink_locked(cls,
+						    XDR_IOQ_SHRINK_WAIT_NS);
+		pthread_mutex_unlock(&cls->avail.qmutex);
+	}
+
+	if (freed)
+		__warnx(TIRPC_DEBUG_FLAG_XDR,
+			"%s() released %zu bytes, %zu remain",
+			__func__, freed,
+			atomic_fetch_size_t(&xdr_ioq_pool_stat.total));
+}
+
+bool
+xdr_ioq_pool_control(int what, struct rpc_ioq_pool_stat *stat)
+{
+	switch (what) {
+	case RPC_SVC_IOQ_POOL_GET:
+		*stat = xdr_ioq_pool_stat;
+		stat->total = atomic_fetch_size_t(&xdr_ioq_pool_stat.total);
+		stat->in_use = atomic_fetch_size_t(&xdr_ioq_pool_stat.in_use);
+		break;
+	case RPC_SVC_IOQ_POOL_SET:
+		if (stat->low_wat > stat->high_wat)
+			return (false);
+		xdr_ioq_pool_stat.high_wat = stat->high_wat;
+		xdr_ioq_pool_stat.low_wat = stat->low_wat;
+		break;
+	default:
+		return (false);
+	}
+	return (true);
+}
+
 struct xdr_ioq_uv *
 xdr_ioq_uv_create(size_t size, u_int uio_flags)
 {
 	struct xdr_ioq_uv *uv = mem_zalloc(sizeof(struct xdr_ioq_uv));
+	struct xdr_ioq_chunk *chunk = NULL;
 
 	if (size) {
-		uv->v.vio_base = alloc_buffer(size);
+		if ((uio_flags & (UIO_FLAG_FREE | UIO_FLAG_REALLOC))
+		    == UIO_FLAG_FREE) {
+			pthread_once(&xdr_ioq_pool_once, xdr_ioq_pool_init);
+			uv->v.vio_base = xdr_ioq_pool_get(size, &chunk);
+		}
+		if (uv->v.vio_base) {
+			uv->u.uio_release = xdr_ioq_pool_uv_release;
+			uv->u.uio_p1 = chunk;
+			uv->u.uio_p2 = uv->v.vio_base;
+		} else {
+			uv->v.vio_base = alloc_buffer(size);
+		}
 		uv->v.vio_head = uv->v.vio_base;
 		uv->v.vio_tail = uv->v.vio_base;
 		uv->v.vio_wrap = uv->v.vio_base + size;
@@ -608,6 +922,196 @@ xdr_ioq_uv_release(struct xdr_ioq_uv *uv)
 	}
 }
 
+/*
+ * Segment index
+ *
+ * Positions in streams of more than a few segments are found through an
+ * array of the segments and their starting offsets.  Segments are only
+ * appended while encoding (or receiving), and only the last one grows,
+ * so the entries stay valid and the index is extended as needed, from
+ * the queue itself:  new segments are found back from its last, and must
+ * follow the last entry, else the index is rebuilt from its first.  An
+ * entry is only dereferenced once found in the queue.  xdr_ioq routines
+ * that insert in the middle reset it themselves.
+ */
+#define XDR_IOQ_SEEK_LINEAR	8	/* segments walked, not indexed */
+
+static inline void
+xdr_ioq_index_reset(struct xdr_ioq *xioq)
+{
+	xioq->ioq_segs.segc =
+	xioq->ioq_segs.segcur = 0;
+}
+
+static void
+xdr_ioq_index_free(struct xdr_ioq *xioq)
+{
+	if (xioq->ioq_segs.segv)
+		mem_free(xioq->ioq_segs.segv,
+			 xioq->ioq_segs.segmax * sizeof(struct xdr_ioq_seg));
+	xioq->ioq_segs.segv = NULL;
+	xioq->ioq_segs.segmax = 0;
+	xdr_ioq_index_reset(xioq);
+}
+
+static void
+xdr_ioq_index(struct xdr_ioq *xioq)
+{
+	struct xdr_ioq_uv_head *uvh = &xioq->ioq_uv;
+	struct xdr_ioq_seg_index *xs = &xioq->ioq_segs;
+	struct poolq_entry *last = TAILQ_LAST(&uvh->uvqh.qh, poolq_head_s);
+	struct poolq_entry *have;
+	struct xdr_ioq_seg *seg;
+	u_int count = uvh->uvqh.qcount;
+	u_int n = xs->segc;
+	u_int i;
+	size_t off = 0;
+
+	if (n > count
+	 || (n && xs->segv[0].uv != IOQ_(TAILQ_FIRST(&uvh->uvqh.qh))))
+		n = 0;
+	if (n == count && (!n || xs->segv[n - 1].uv == IOQ_(last)))
+		return;
+	if (n == count)
+		n = 0;
+
+	if (count > xs->segmax) {
+		u_int max = MAX(count, 2 * xs->segmax);
+
+		seg = mem_alloc(max * sizeof(struct xdr_ioq_seg));
+		if (n)
+			memcpy(seg, xs->segv, n * sizeof(struct xdr_ioq_seg));
+		xdr_ioq_index_free(xioq);
+		xs->segv = seg;
+		xs->segmax = max;
+	}
+
+	/* the first unindexed segment, back from the last; the indexed
+	 * entries are kept only when the last of them precedes it.
+	 */
+	have = NULL;
+	if (n) {
+		have = last;
+		for (i = count - 1; have && i > n; i--)
+			have = TAILQ_PREV(have, poolq_head_s, q);
+		seg = &xs->segv[n - 1];
+		if (have && TAILQ_PREV(have, poolq_head_s, q) == &seg->uv->uvq)
+			off = seg->off + ioquv_length(seg->uv);
+		else
+			n = 0;
+	}
+	if (!n)
+		have = TAILQ_FIRST(&uvh->uvqh.qh);
+
+	for (; have && n < count; have = TAILQ_NEXT(have, q), n++) {
+		seg = &xs->segv[n];
+		seg->uv = IOQ_(have);
+		seg->off = off;
+		off += ioquv_length(seg->uv);
+	}
+	xs->segc = n;
+	if (xs->segcur >= n)
+		xs->segcur = 0;
+}
+
+/*
+ * Find the segment holding stream offset pos (the first whose data ends
+ * past it), with its index and starting offset.  NULL at or past the end
+ * of the data, with the count of segments and total length.
+ *
+ * Callers bring the current tail up to date first.
+ */
+static struct xdr_ioq_uv *
+xdr_ioq_seek(struct xdr_ioq *xioq, size_t pos, u_int *idxp, size_t *offp)
+{
+	struct xdr_ioq_uv_head *uvh = &xioq->ioq_uv;
+	struct xdr_ioq_seg_index *xs = &xioq->ioq_segs;
+	struct xdr_ioq_seg *segv;
+	struct poolq_entry *have;
+	struct xdr_ioq_uv *uv;
+	size_t off = 0;
+	u_int idx = 0;
+	u_int lo, hi, mid;
+
+	if (uvh->uvqh.qcount <= XDR_IOQ_SEEK_LINEAR) {
+		TAILQ_FOREACH(have, &uvh->uvqh.qh, q) {
+			uv = IOQ_(have);
+			if (pos < off + ioquv_length(uv)) {
+				*idxp = idx;
+				*offp = off;
+				return (uv);
+			}
+			off += ioquv_length(uv);
+			idx++;
+		}
+		*idxp = idx;
+		*offp = off;
+		return (NULL);
+	}
+
+	xdr_ioq_index(xioq);
+	segv = xs->segv;
+
+	/* the last found, or after it, for sequential access */
+	lo = 0;
+	hi = xs->segc;
+	if (segv[xs->segcur].off <= pos) {
+		lo = xs->segcur;
+		if (lo + 1 < hi && pos < segv[lo + 1].off)
+			hi = lo + 1;
+	}
+	/* last entry starting at or before pos */
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		if (segv[mid].off <= pos)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	uv = segv[lo].uv;
+	if (pos < segv[lo].off + ioquv_length(uv)) {
+		xs->segcur = lo;
+		*idxp = lo;
+		*offp = segv[lo].off;
+		return (uv);
+	}
+	/* only the last can end at or before pos */
+	*idxp = xs->segc;
+	*offp = segv[lo].off + ioquv_length(uv);
+	return (NULL);
+}
+
+/*
+ * Bytes from start to the end of count segments (or of the data), so
+ * that a partial send need only fill as many as it can use.
+ */
+u_int
+xdr_ioq_extent(struct xdr_ioq *xioq, u_int start, u_int count)
+{
+	struct xdr_ioq_uv *uv;
+	struct poolq_entry *have;
+	size_t off;
+	size_t end;
+	u_int idx;
+
+	xdr_tail_update(xioq->xdrs);
+
+	uv = xdr_ioq_seek(xioq, start, &idx, &off);
+	if (!uv)
+		return (0);
+
+	if (xioq->ioq_segs.segc && idx + count < xioq->ioq_segs.segc)
+		return (xioq->ioq_segs.segv[idx + count].off - start);
+
+	end = off;
+	for (have = &uv->uvq; have && count; have = TAILQ_NEXT(have, q)) {
+		end += ioquv_length(IOQ_(have));
+		count--;
+	}
+	return (end - start);
+}
+
 /*
  * Set current read/insert or fill position.
  */
@@ -642,6 +1146,7 @@ xdr_ioq_reset(struct xdr_ioq *xioq, u_int wh_pos)
 
 	xioq->ioq_uv.plength =
 	xioq->ioq_uv.pcount = 0;
+	xdr_ioq_index_reset(xioq);
 
 	if (wh_pos >= ioquv_size(uv)) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
@@ -670,6 +1175,9 @@ xdr_ioq_setup(struct xdr_ioq *xioq)
 
 	poolq_head_setup(&xioq->ioq_uv.uvqh);
 	pthread_cond_init(&xioq->ioq_cond, NULL);
+	xioq->ioq_segs.segv = NULL;
+	xioq->ioq_segs.segmax = 0;
+	xdr_ioq_index_reset(xioq);
 
 	xdrs->x_ops = &xdr_ioq_ops;
 	xdrs->x_op = XDR_ENCODE;
@@ -1120,6 +1628,19 @@ xdr_ioq_putbufs(XDR *xdrs, xdr_uio *uio, u_int flags)
 		"%s Before putbufs - pos %lu",
 		__func__, (unsigned long) XDR_GETPOS(xdrs));
 
+	/* RPCSEC_GSS needs a contiguous buffer, so copy */
+	if (IOQV(xdrs->x_base)->u.uio_flags & UIO_FLAG_REALLOC) {
+		for (ix = 0; ix < uio->uio_count; ++ix) {
+			v = &(uio->uio_vio[ix]);
+			if (!xdr_ioq_putbytes(xdrs, (char *)v->vio_head,
+					      (uintptr_t)v->vio_tail
+					      - (uintptr_t)v->vio_head))
+				break;
+		}
+		xdr_uio_copied(uio);
+		return (ix == uio->uio_count);
+	}
+
 	for (ix = 0; ix < uio->uio_count; ++ix) {
 		/* advance fill pointer, do not allocate buffers, refs =1 */
 		uv = xdr_ioq_uv_advance(XIOQ(xdrs));
@@ -1131,6 +1652,8 @@ xdr_ioq_putbufs(XDR *xdrs, xdr_uio *uio, u_int flags)
 		v = &(uio->uio_vio[ix]);
 		uv->u.uio_flags = UIO_FLAG_REFER;
 		uv->v = *v;
+		/* never fill past the caller's data */
+		uv->v.vio_wrap = uv->v.vio_tail;
 
 		/* save original buffer sequence for rele */
 		uv->u.uio_refer = uio;
@@ -1238,54 +1761,51 @@ xdr_ioq_getenddatapos(XDR *xdrs, u_int start, u_int datalen)
 static bool
 xdr_ioq_setpos(XDR *xdrs, u_int pos)
 {
-	struct poolq_entry *have;
+	struct xdr_ioq *xioq = XIOQ(xdrs);
+	struct xdr_ioq_uv *uv;
+	size_t off;
+	u_int idx;
 
 	/* update the most recent data length, just in case */
 	xdr_tail_update(xdrs);
 
-	XIOQ(xdrs)->ioq_uv.plength =
-	XIOQ(xdrs)->ioq_uv.pcount = 0;
-
-	TAILQ_FOREACH(have, &(XIOQ(xdrs)->ioq_uv.uvqh.qh), q) {
-		struct xdr_ioq_uv *uv = IOQ_(have);
-		struct xdr_ioq_uv *next = IOQ_(TAILQ_NEXT(have, q));
-		u_int len = ioquv_length(uv);
-		u_int full = (uintptr_t)xdrs->x_v.vio_wrap
-			   - (uintptr_t)xdrs->x_v.vio_head;
-
-		__warnx(TIRPC_DEBUG_FLAG_XDR,
-			"%s Examining xdr_ioq_uv %p (base %p head %p tail %p wrap %p len %lu full %lu) - %s pos %lu",
-			__func__, uv, uv->v.vio_base, uv->v.vio_head,
-			uv->v.vio_tail, uv->v.vio_wrap,
-			(unsigned long) len, (unsigned long) full,
-			next ? "more" : "last",
-			(unsigned long) pos);
-
-		/* If we have a next buffer and pos would land exactly at the
-		 * tail of this buffer, we want to force positioning in the
-		 * next buffer. The space between the tail of this buffer and
-		 * the wrap of this buffer is unused and MUST be skipped.
-		 */
-		if ((pos < len) || (next == NULL && pos <= full)) {
-			/* allow up to the end of the buffer, unless there is
-			 * a next buffer in which case only allow up to the
-			 * tail assuming next operation will extend.
-			 */
-			xdrs->x_data = uv->v.vio_head + pos;
-			xdrs->x_base = &uv->v;
-			xdrs->x_v = uv->v;
-			return (true);
+	/* If pos would land exactly at the tail of a buffer with a next
+	 * buffer, it is positioned in the next buffer: the space between
+	 * the tail and the wrap of this buffer is unused and MUST be
+	 * skipped.  Only the last buffer allows up to its end, assuming
+	 * the next operation will extend it.
+	 */
+	uv = xdr_ioq_seek(xioq, pos, &idx, &off);
+	if (!uv) {
+		uv = IOQ_(TAILQ_LAST(&xioq->ioq_uv.uvqh.qh, poolq_head_s));
+		if (!uv || !idx) {
+			__warnx(TIRPC_DEBUG_FLAG_XDR,
+				"%s failing with empty stream, pos %lu",
+				__func__, (unsigned long) pos);
+			return (false);
+		}
+		off -= ioquv_length(uv);
+		idx--;
+		if (pos - off > (uintptr_t)uv->v.vio_wrap
+			      - (uintptr_t)uv->v.vio_head) {
+			__warnx(TIRPC_DEBUG_FLAG_XDR,
+				"%s failing with remaining %lu",
+				__func__, (unsigned long) (pos - off));
+			return (false);
 		}
-		pos -= len;
-		XIOQ(xdrs)->ioq_uv.plength += len;
-		XIOQ(xdrs)->ioq_uv.pcount++;
 	}
 
 	__warnx(TIRPC_DEBUG_FLAG_XDR,
-		"%s failing with remaining %lu",
-		__func__, (unsigned long) pos);
+		"%s xdr_ioq_uv %p (base %p head %p tail %p wrap %p) idx %u pos %lu",
+		__func__, uv, uv->v.vio_base, uv->v.vio_head,
+		uv->v.vio_tail, uv->v.vio_wrap, idx, (unsigned long) pos);
 
-	return (false);
+	xioq->ioq_uv.plength = off;
+	xioq->ioq_uv.pcount = idx;
+	xdrs->x_data = uv->v.vio_head + (pos - off);
+	xdrs->x_base = &uv->v;
+	xdrs->x_v = uv->v;
+	return (true);
 }
 
 void
@@ -1322,6 +1842,10 @@ xdr_ioq_destroy(struct xdr_ioq *xioq, size_t qsize)
 #endif
 
 	xdr_ioq_release(&xioq->ioq_uv.uvqh);
+	xdr_ioq_index_free(xioq);
+
+	if (xioq->recv_budget)
+		svc_ioq_budget_release(xioq);
 
 	if (xioq->ioq_pool) {
 		xdr_ioq_uv_recycle(xioq->ioq_pool, &xioq->ioq_s);
@@ -1395,174 +1919,97 @@ xdr_ioq_newbuf(XDR *xdrs)
 static int
 xdr_ioq_iovcount(XDR *xdrs, u_int start, u_int datalen)
 {
-	/* Buffers starts at -1 to indicate start has not yet been found */
-	int buffers = -1;
-	struct poolq_entry *have;
-	struct xdr_ioq_uv *uv;
+	size_t off;
+	u_int first;
+	u_int last;
 
 	/* update the most recent data length, just in case */
 	xdr_tail_update(xdrs);
 
-	TAILQ_FOREACH(have, &(XIOQ(xdrs)->ioq_uv.uvqh.qh), q) {
-		u_int len;
-
-		uv = IOQ_(have);
-		len = ioquv_length(uv);
-
+	if (!xdr_ioq_seek(XIOQ(xdrs), start, &first, &off)) {
+		/* start was not within the xdr stream */
 		__warnx(TIRPC_DEBUG_FLAG_XDR,
-			"%s Examining xdr_ioq_uv %p (base %p head %p tail %p wrap %p) - start %lu len %lu buffers %d",
-			__func__, uv, uv->v.vio_base, uv->v.vio_head,
-			uv->v.vio_tail, uv->v.vio_wrap,
-			(unsigned long) start, (unsigned long) len, buffers);
-
-		if (buffers > 0) {
-			/* Accumulate another buffer */
-			buffers++;
-			__warnx(TIRPC_DEBUG_FLAG_XDR,
-				"Accumulated another buffer total = %d",
-				buffers);
-		} else if (start < len) {
-			/* We have found the buffer that start begins. */
-			buffers = 1;
-			__warnx(TIRPC_DEBUG_FLAG_XDR,
-				"Starting total = %d", buffers);
-		} else {
-			/* Keep looking, need to reduce start by the length of
-			 * this buffer.
-			 */
-			start -= len;
-		}
-		if (buffers > 0) {
-			/* Now we need to decrement the datalen to see if we're
-			 * done. Note the first time we come in, start may not
-			 * be zero, which represents the fact that start was in
-			 * the middle of this buffer, just subtract the
-			 * remaining start from the length of this buffer.
-			 */
-			u_int buflen = uv->v.vio_tail - uv->v.vio_head - start;
-			if (buflen >= datalen) {
-				/* We have found end. */
-				datalen = 0;
-				break;
-			}
-
-			/* Decrement the datalen, and zero out start for future
-			 * buffers.
-			 */
-			datalen -= buflen;
-			start = 0;
-		}
+			"%s start %lu past end %lu",
+			__func__, (unsigned long) start, (unsigned long) off);
+		return -1;
 	}
+	if (!datalen)
+		return 1;
 
-	if (datalen != 0) {
+	if (!xdr_ioq_seek(XIOQ(xdrs), (size_t)start + datalen - 1,
+			  &last, &off)) {
 		/* There wasn't enough data... */
 		__warnx(TIRPC_DEBUG_FLAG_XDR,
-			"%s start %lu remain %lu",
+			"%s start %lu datalen %lu past end %lu",
 			__func__, (unsigned long) start,
-			(unsigned long) datalen);
-			return -1;
+			(unsigned long) datalen, (unsigned long) off);
+		return -1;
 	}
 
 	__warnx(TIRPC_DEBUG_FLAG_XDR,
-		"%s start %lu buffers %d",
-		__func__, (unsigned long) start, buffers);
+		"%s start %lu buffers %u",
+		__func__, (unsigned long) start, last - first + 1);
 
-	/* If start was not within the xdr stream, buffers will still be -1 */
-	return buffers;
+	return last - first + 1;
 }
 
 static bool
 xdr_ioq_fillbufs(XDR *xdrs, u_int start, xdr_vio *vector, u_int datalen)
 {
-	bool found = false;
 	struct poolq_entry *have;
 	struct xdr_ioq_uv *uv;
+	size_t off;
+	u_int first;
+	u_int len;
 	int idx = 0;
 
 	/* update the most recent data length, just in case */
 	xdr_tail_update(xdrs);
 
-	TAILQ_FOREACH(have, &(XIOQ(xdrs)->ioq_uv.uvqh.qh), q) {
-		u_int len;
-
-		uv = IOQ_(have);
-		len = ioquv_length(uv);
-
+	uv = xdr_ioq_seek(XIOQ(xdrs), start, &first, &off);
+	if (!uv) {
 		__warnx(TIRPC_DEBUG_FLAG_XDR,
-			"%s Examining xdr_ioq_uv %p (base %p head %p tail %p wrap %p len %lu) - %s start %lu remain %lu idx %d",
-			__func__, uv, uv->v.vio_base, uv->v.vio_head,
-			uv->v.vio_tail, uv->v.vio_wrap,
-			(unsigned long) len,
-			found ? "found" : "not found",
-			(unsigned long) start, (unsigned long) datalen, idx);
-
-		if (!found) {
-			if (start < len) {
-				/* We have found the buffer that start begins.
-				 */
-				found = true;
-				__warnx(TIRPC_DEBUG_FLAG_XDR, "found");
-			} else {
-				/* Keep looking, need to reduce start by the
-				 * length of this buffer.
-				 */
-				start -= len;
-			}
-		}
-
-		if (found) {
-			vector[idx] = uv->v;
-			vector[idx].vio_type = VIO_DATA;
-
-			if (start > 0) {
-				/* The start position wasn't at the start of
-				 * a buffer, adjust the vio_head of this buffer
-				 * and len and then zero out start for
-				 * future buffers.
-				 */
-				len -= start;
-				vector[idx].vio_head += start;
-				start = 0;
-			}
-
-			vector[idx].vio_length = len;
-
-			if (datalen < vector[idx].vio_length) {
-				/* This is the last buffer, and we're not using
-				 * all of it, adjust vio_length and vio_tail.
-				 */
-				vector[idx].vio_length = datalen;
-				vector[idx].vio_tail = vector[idx].vio_head
-					+ datalen;
-				datalen = 0;
-				break;
-			} else if (datalen == vector[idx].vio_length) {
-				/* We have reached the end. */
-				datalen = 0;
-				break;
-			}
-
-			datalen -= vector[idx].vio_length;
+			"%s start %lu past end %lu",
+			__func__, (unsigned long) start, (unsigned long) off);
+		return false;
+	}
+	/* the start position may not be at the start of its buffer */
+	start -= off;
 
-			idx++;
+	for (have = &uv->uvq; have; have = TAILQ_NEXT(have, q)) {
+		uv = IOQ_(have);
+		len = ioquv_length(uv) - start;
+
+		vector[idx] = uv->v;
+		vector[idx].vio_type = VIO_DATA;
+		vector[idx].vio_head += start;
+		start = 0;
+
+		if (datalen <= len) {
+			/* This is the last buffer, maybe not all of it */
+			vector[idx].vio_length = datalen;
+			vector[idx].vio_tail = vector[idx].vio_head + datalen;
+			datalen = 0;
+			break;
 		}
+		vector[idx].vio_length = len;
+		datalen -= len;
+		idx++;
 	}
 
 	if (datalen != 0) {
 		/* There wasn't enough data... */
 		__warnx(TIRPC_DEBUG_FLAG_XDR,
-			"%s start %lu remain %lu",
-			__func__, (unsigned long) start,
-			(unsigned long) datalen);
+			"%s remain %lu",
+			__func__, (unsigned long) datalen);
 			return false;
 	}
 
 	__warnx(TIRPC_DEBUG_FLAG_XDR,
-		"%s %s start %lu remain %lu idx %d",
-		__func__, found ? "found" : "not found",
-		(unsigned long) start, (unsigned long) datalen, idx);
+		"%s idx %d",
+		__func__, idx);
 
-	return found;
+	return true;
 }
 
 static struct xdr_ioq_uv *
@@ -1614,6 +2061,7 @@ xdr_ioq_use_or_allocate(struct xdr_ioq *xioq, xdr_vio *v, struct xdr_ioq_uv *uv)
 			(xioq->ioq_uv.uvqh.qcount)++;
 			TAILQ_INSERT_AFTER(&xioq->ioq_uv.uvqh.qh,
 					   have, have2, q);
+			xdr_ioq_index_reset(xioq);
 
 			/* Advance to new buffer */
 			uv = uv2;
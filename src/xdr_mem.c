@@ -77,6 +77,7 @@ xdrmem_ncreate(XDR *xdrs, char *addr, u_int size, enum xdr_op op)
 	xdrs->x_private = NULL;
 	xdrs->x_lib[0] = NULL;
 	xdrs->x_lib[1] = NULL;
+	xdrs->x_flags = XDR_FLAG_NONE;
 	xdrs->x_data = addr;
 	xdrs->x_v.vio_base = addr;
 	xdrs->x_v.vio_head = addr;
@@ -196,7 +197,7 @@ xdrmem_putbufs(XDR *xdrs, xdr_uio *uio, u_int flags)
 		xdr_vio *v = &(uio->uio_vio[ix]);
 
 		if (!XDR_PUTBYTES(xdrs, v->vio_head, v->vio_length))
-			return (FALSE);
+			break;
 
 		__warnx(TIRPC_DEBUG_FLAG_XDR,
 			"%s After putbufs Examining vio %p (base %p head %p tail %p wrap %p len %lu) pos %lu",
@@ -205,18 +206,8 @@ xdrmem_putbufs(XDR *xdrs, xdr_uio *uio, u_int flags)
 			(unsigned long) XDR_GETPOS(xdrs));
 	}
 
-	if (!(--uio->uio_references)) {
-		if (uio->uio_release) {
-			uio->uio_release(uio, UIO_FLAG_NONE);
-		} else {
-			__warnx(TIRPC_DEBUG_FLAG_ERROR,
-				"%s() memory leak, unexpected or no release flags (%u)\n",
-				__func__, uio->uio_flags);
-			abort();
-		}
-	}
-
-	return (TRUE);
+	xdr_uio_copied(uio);
+	return (ix == uio->uio_count);
 }
 
 static bool
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+/*
+ * xdr_sizeof.c, XDR sizing stream.
+ *
+ * Encodes nothing, but counts the bytes that would be encoded, so that
+ * a message can be sized before its buffer is allocated.  With no
+ * in-line buffer, every xdr_inline_encode() and bulk fast path falls
+ * back to x_putunit and x_putbytes.
+ *
+ * The position may be set back (to patch a length) and forward again;
+ * the size is the furthest position reached, xdrsize_length().  Data
+ * passed by reference (XDR_PUTBUFS) is counted as on any other stream,
+ * and apart by xdrsize_refer(), so that a vector stream needs only the
+ * difference in its own buffers.
+ */
+
+#include <sys/types.h>
+#include <string.h>
+
+#include <rpc/types.h>
+#include <rpc/xdr.h>
+
+static const struct xdr_ops xdrsize_ops;
+
+/*
+ * The procedure xdrsize_create initializes a stream descriptor for
+ * sizing an encode.
+ */
+void
+xdrsize_create(XDR *xdrs)
+{
+	xdrs->x_op = XDR_ENCODE;
+	xdrs->x_ops = &xdrsize_ops;
+	xdrs->x_public = NULL;
+	xdrs->x_private = NULL;	/* bytes by reference */
+	xdrs->x_lib[0] = NULL;
+	xdrs->x_lib[1] = NULL;
+	xdrs->x_data = NULL;
+	memset(&xdrs->x_v, 0, sizeof(xdrs->x_v));
+	xdrs->x_base = &xdrs->x_v;
+	xdrs->x_flags = XDR_FLAG_VIO;
+	xdrs->x_handy = 0;
+}
+
+/*
+ * Bytes that xdr_proc(obj) would encode, or 0 on failure.
+ */
+u_long
+xdr_sizeof(xdrproc_t xdr_proc, void *obj)
+{
+	XDR xdrs;
+
+	xdrsize_create(&xdrs);
+	if (!(*xdr_proc) (&xdrs, obj))
+		return (0);
+	return (xdrsize_length(&xdrs));
+}
+
+static inline void
+xdrsize_advance(XDR *xdrs, u_int len)
+{
+	xdrs->x_handy += len;
+	if (xdrs->x_v.vio_length < xdrs->x_handy)
+		xdrs->x_v.vio_length = xdrs->x_handy;
+}
+
+/* ARGSUSED */
+static bool
+xdrsize_getunit(XDR *xdrs, uint32_t *p)
+{
+	return (false);
+}
+
+/* ARGSUSED */
+static bool
+xdrsize_putunit(XDR *xdrs, const uint32_t v)
+{
+	xdrsize_advance(xdrs, BYTES_PER_XDR_UNIT);
+	return (true);
+}
+
+/* ARGSUSED */
+static bool
+xdrsize_getbytes(XDR *xdrs, char *addr, u_int len)
+{
+	return (false);
+}
+
+/* ARGSUSED */
+static bool
+xdrsize_putbytes(XDR *xdrs, const char *addr, u_int len)
+{
+	xdrsize_advance(xdrs, len);
+	return (true);
+}
+
+static u_int
+xdrsize_getpos(XDR *xdrs)
+{
+	return (xdrs->x_handy);
+}
+
+static u_int
+xdrsize_getstartdatapos(XDR *xdrs, u_int start, u_int datalen)
+{
+	return start;
+}
+
+static u_int
+xdrsize_getenddatapos(XDR *xdrs, u_int start, u_int datalen)
+{
+	return start + datalen;
+}
+
+/* within the bytes encoded so far */
+static bool
+xdrsize_setpos(XDR *xdrs, u_int pos)
+{
+	if (pos > xdrs->x_v.vio_length)
+		return (false);
+	xdrs->x_handy = pos;
+	return (true);
+}
+
+/* ARGSUSED */
+static void
+xdrsize_destroy(XDR *xdrs)
+{
+}
+
+/* counts only; no reference is taken, nor the caller's consumed */
+static bool
+xdrsize_putbufs(XDR *xdrs, xdr_uio *uio, u_int flags)
+{
+	xdr_vio *v;
+	u_int len;
+	int ix;
+
+	for (ix = 0; ix < uio->uio_count; ++ix) {
+		v = &(uio->uio_vio[ix]);
+		len = (uintptr_t)v->vio_tail - (uintptr_t)v->vio_head;
+		xdrsize_advance(xdrs, len);
+		xdrs->x_private = (void *)((uintptr_t)xdrs->x_private + len);
+	}
+	return (true);
+}
+
+/* there is no buffer for the start of a vector (GSS wrap) */
+static bool
+xdrsize_newbuf(XDR *xdrs)
+{
+	return (false);
+}
+
+static bool
+xdrsize_noop(void)
+{
+	return (false);
+}
+
+static int
+xdrsize_iovcount(XDR *xdrs, u_int start, u_int datalen)
+{
+	return -1;
+}
+
+typedef bool (*dummyfunc3)(XDR *, int, void *);
+typedef bool (*dummy_getbufs)(XDR *, xdr_uio *, u_int);
+typedef bool (*dummy_fillbufs)(XDR *, u_int, xdr_vio *, u_int);
+typedef bool (*dummy_allochdrs)(XDR *, u_int, xdr_vio *, int);
+
+static const struct xdr_ops xdrsize_ops = {
+	xdrsize_getunit,
+	xdrsize_putunit,
+	xdrsize_getbytes,
+	xdrsize_putbytes,
+	xdrsize_getpos,
+	xdrsize_getstartdatapos,
+	xdrsize_getenddatapos,
+	xdrsize_setpos,
+	xdrsize_destroy,
+	(dummyfunc3) xdrsize_noop,	/* x_control */
+	(dummy_getbufs) xdrsize_noop,	/* x_getbufs */
+	xdrsize_putbufs,		/* x_putbufs */
+	xdrsize_newbuf,			/* x_newbuf */
+	xdrsize_iovcount,		/* x_iovcount */
+	(dummy_fillbufs) xdrsize_noop,	/* x_fillbufs */
+	(dummy_allochdrs) xdrsize_noop,	/* x_allochdrs */
+};
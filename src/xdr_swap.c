@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+/*
+ * xdr_swap.c, bulk conversion of arrays of XDR integers.
+ *
+ * Contiguous runs within the current stream buffer are converted all at
+ * once, by the widest vector unit the CPU offers (chosen on first use);
+ * only the elements straddling a buffer edge are coded one at a time.
+ */
+
+#include <sys/param.h>
+#include <string.h>
+
+#include <rpc/types.h>
+#include <rpc/xdr.h>
+#include <rpc/xdr_inline.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define XDR_SWAP_X86 1
+#include <immintrin.h>
+#endif
+
+static void
+xdr_swap32_scalar(uint32_t *dst, const uint32_t *src, u_int n)
+{
+	u_int i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = ntohl(src[i]);
+}
+
+static void
+xdr_swap64_scalar(uint64_t *dst, const uint64_t *src, u_int n)
+{
+	const uint32_t *s = (const uint32_t *)src;
+	u_int i;
+
+	for (i = 0; i < n; i++, s += 2)
+		dst[i] = ((uint64_t) ntohl(s[0]) << 32) | ntohl(s[1]);
+}
+
+#if defined(XDR_SWAP_X86) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+/* SSE2 has no byte shuffle: swap the 16-bit halves, then their bytes */
+static inline __m128i __attribute__ ((target("sse2")))
+xdr_bswap16_sse2(__m128i v)
+{
+	return (_mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+}
+
+static void __attribute__ ((target("sse2")))
+xdr_swap32_sse2(uint32_t *dst, const uint32_t *src, u_int n)
+{
+	__m128i v;
+	u_int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		v = _mm_loadu_si128((const __m128i *)&src[i]);
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		_mm_storeu_si128((__m128i *)&dst[i], xdr_bswap16_sse2(v));
+	}
+	xdr_swap32_scalar(&dst[i], &src[i], n - i);
+}
+
+static void __attribute__ ((target("sse2")))
+xdr_swap64_sse2(uint64_t *dst, const uint64_t *src, u_int n)
+{
+	__m128i v;
+	u_int i;
+
+	for (i = 0; i + 2 <= n; i += 2) {
+		v = _mm_loadu_si128((const __m128i *)&src[i]);
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+		_mm_storeu_si128((__m128i *)&dst[i], xdr_bswap16_sse2(v));
+	}
+	xdr_swap64_scalar(&dst[i], &src[i], n - i);
+}
+
+static void __attribute__ ((target("avx2")))
+xdr_swap32_avx2(uint32_t *dst, const uint32_t *src, u_int n)
+{
+	const __m256i mask = _mm256_setr_epi8(
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	__m256i v;
+	u_int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		v = _mm256_loadu_si256((const __m256i *)&src[i]);
+		_mm256_storeu_si256((__m256i *)&dst[i],
+				    _mm256_shuffle_epi8(v, mask));
+	}
+	xdr_swap32_scalar(&dst[i], &src[i], n - i);
+}
+
+static void __attribute__ ((target("avx2")))
+xdr_swap64_avx2(uint64_t *dst, const uint64_t *src, u_int n)
+{
+	const __m256i mask = _mm256_setr_epi8(
+		7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+		7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+	__m256i v;
+	u_int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		v = _mm256_loadu_si256((const __m256i *)&src[i]);
+		_mm256_storeu_si256((__m256i *)&dst[i],
+				    _mm256_shuffle_epi8(v, mask));
+	}
+	xdr_swap64_scalar(&dst[i], &src[i], n - i);
+}
+#endif
+
+static void xdr_swap32_first(uint32_t *, const uint32_t *, u_int);
+static void xdr_swap64_first(uint64_t *, const uint64_t *, u_int);
+
+/* set once on first use; any thread picks the same routines */
+static void (*xdr_swap32_fn)(uint32_t *, const uint32_t *, u_int) =
+	xdr_swap32_first;
+static void (*xdr_swap64_fn)(uint64_t *, const uint64_t *, u_int) =
+	xdr_swap64_first;
+
+static void
+xdr_swap_select(void)
+{
+	void (*fn32)(uint32_t *, const uint32_t *, u_int) = xdr_swap32_scalar;
+	void (*fn64)(uint64_t *, const uint64_t *, u_int) = xdr_swap64_scalar;
+
+#if defined(XDR_SWAP_X86) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		fn32 = xdr_swap32_avx2;
+		fn64 = xdr_swap64_avx2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		fn32 = xdr_swap32_sse2;
+		fn64 = xdr_swap64_sse2;
+	}
+#endif
+	__atomic_store_n(&xdr_swap32_fn, fn32, __ATOMIC_RELAXED);
+	__atomic_store_n(&xdr_swap64_fn, fn64, __ATOMIC_RELAXED);
+}
+
+static void
+xdr_swap32_first(uint32_t *dst, const uint32_t *src, u_int n)
+{
+	xdr_swap_select();
+	xdr_swap32_fn(dst, src, n);
+}
+
+static void
+xdr_swap64_first(uint64_t *dst, const uint64_t *src, u_int n)
+{
+	xdr_swap_select();
+	xdr_swap64_fn(dst, src, n);
+}
+
+/*
+ * Convert n 32-bit (or 64-bit) integers between XDR and host order;
+ * the conversion is its own inverse.  dst and src may be the same, but
+ * must not otherwise overlap.
+ */
+void
+xdr_swap32(uint32_t *dst, const uint32_t *src, u_int n)
+{
+	__atomic_load_n(&xdr_swap32_fn, __ATOMIC_RELAXED)(dst, src, n);
+}
+
+void
+xdr_swap64(uint64_t *dst, const uint64_t *src, u_int n)
+{
+	__atomic_load_n(&xdr_swap64_fn, __ATOMIC_RELAXED)(dst, src, n);
+}
+
+/*
+ * XDR a fixed vector of n 32-bit integers
+ */
+bool
+xdr_uint32_vector(XDR *xdrs, uint32_t *vp, u_int n)
+{
+	u_int run;
+
+	switch (xdrs->x_op) {
+	case XDR_DECODE:
+		while (n) {
+			run = MIN(n, xdr_tail_inline(xdrs) / BYTES_PER_XDR_UNIT);
+			if (!run) {
+				/* straddling a buffer edge */
+				if (!XDR_GETUINT32(xdrs, vp))
+					return (false);
+				vp++;
+				n--;
+				continue;
+			}
+			xdr_swap32(vp, (uint32_t *)xdrs->x_data, run);
+			xdrs->x_data += run * BYTES_PER_XDR_UNIT;
+			vp += run;
+			n -= run;
+		}
+		return (true);
+	case XDR_ENCODE:
+		while (n) {
+			run = MIN(n, xdr_size_inline(xdrs) / BYTES_PER_XDR_UNIT);
+			if (!run) {
+				if (!XDR_PUTUINT32(xdrs, *vp))
+					return (false);
+				vp++;
+				n--;
+				continue;
+			}
+			xdr_swap32((uint32_t *)xdrs->x_data, vp, run);
+			xdrs->x_data += run * BYTES_PER_XDR_UNIT;
+			vp += run;
+			n -= run;
+		}
+		return (true);
+	case XDR_FREE:
+		return (true);
+	}
+	/* NOTREACHED */
+	return (false);
+}
+
+/*
+ * XDR a fixed vector of n 64-bit integers
+ */
+bool
+xdr_uint64_vector(XDR *xdrs, uint64_t *vp, u_int n)
+{
+	u_int run;
+
+	switch (xdrs->x_op) {
+	case XDR_DECODE:
+		while (n) {
+			run = MIN(n, xdr_tail_inline(xdrs) / sizeof(uint64_t));
+			if (!run) {
+				if (!xdr_uint64_t(xdrs, vp))
+					return (false);
+				vp++;
+				n--;
+				continue;
+			}
+			xdr_swap64(vp, (uint64_t *)xdrs->x_data, run);
+			xdrs->x_data += run * sizeof(uint64_t);
+			vp += run;
+			n -= run;
+		}
+		return (true);
+	case XDR_ENCODE:
+		while (n) {
+			run = MIN(n, xdr_size_inline(xdrs) / sizeof(uint64_t));
+			if (!run) {
+				if (!xdr_uint64_t(xdrs, vp))
+					return (false);
+				vp++;
+				n--;
+				continue;
+			}
+			xdr_swap64((uint64_t *)xdrs->x_data, vp, run);
+			xdrs->x_data += run * sizeof(uint64_t);
+			vp += run;
+			n -= run;
+		}
+		return (true);
+	case XDR_FREE:
+		return (true);
+	}
+	/* NOTREACHED */
+	return (false);
+}
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ *
+ * This code is released into the "public domain" by its author(s).
+ * Anybody may use, alter, and distribute the code without restriction.
+ * The author(s) make no guarantees, and take no liability of any kind
+ * for use of this code.
+ */
+
+/**
+ * @file rpcgenbench.c
+ * @brief ntirpcgen codec benchmark
+ *
+ * @section DESCRIPTION
+ *
+ * Times the codecs generated by ntirpcgen (gen_ prefix, compiled from
+ * rpcb_prot.x by rpcgen/CMakeLists.txt) against the hand-written ones
+ * of the library, for the same objects: encode, decode (and free), and
+ * sizing (xdr_sizeof() against the generated xdr_sizeof_ routine).
+ *
+ * The encodings and sizes are also compared; any difference is
+ * reported, and fails the run.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <rpc/rpc.h>
+#include <rpc/rpcb_prot.h>
+
+/* generated, see rpcgen/CMakeLists.txt */
+bool gen_xdr_rpcb(XDR *xdrs, rpcb *objp);
+u_int gen_xdr_sizeof_rpcb(const rpcb *objp);
+bool gen_xdr_rpcblist_ptr(XDR *xdrs, rpcblist_ptr *objp);
+u_int gen_xdr_sizeof_rpcblist_ptr(const rpcblist_ptr *objp);
+bool gen_xdr_rpcb_stat(XDR *xdrs, rpcb_stat *objp);
+u_int gen_xdr_sizeof_rpcb_stat(const rpcb_stat *objp);
+
+typedef u_int (*sizeproc_t)(const void *);
+
+struct codec {
+	const char *name;
+	xdrproc_t hand;
+	xdrproc_t gen;
+	sizeproc_t gen_size;
+	void *obj;
+	size_t objsz;
+};
+
+struct timing {
+	double encode;
+	double decode;
+	double size;
+};
+
+static uint64_t timespec_elapsed(const struct timespec *starting,
+				 const struct timespec *stopping)
+{
+	time_t elapsed = stopping->tv_sec - starting->tv_sec;
+	long nsec = stopping->tv_nsec - starting->tv_nsec;
+
+	return (elapsed * 1000000000L) + nsec;
+}
+
+/* xdr_sizeof() takes no const */
+static u_int
+hand_size(xdrproc_t proc, void *obj)
+{
+	return (xdr_sizeof(proc, obj));
+}
+
+static u_int
+encode(xdrproc_t proc, void *obj, char *buf, u_int len)
+{
+	XDR xdrs[1];
+	u_int pos = 0;
+
+	xdrmem_create(xdrs, buf, len, XDR_ENCODE);
+	if ((*proc)(xdrs, obj))
+		pos = XDR_GETPOS(xdrs);
+	XDR_DESTROY(xdrs);
+	return (pos);
+}
+
+static void
+bench(struct codec *c, xdrproc_t proc, sizeproc_t size, char *buf,
+      u_int len, int count, struct timing *t)
+{
+	struct timespec starting, stopping;
+	XDR xdrs[1];
+	void *out = calloc(1, c->objsz);
+	u_int sum = 0;
+	int i;
+
+	xdrmem_create(xdrs, buf, len, XDR_ENCODE);
+	clock_gettime(CLOCK_MONOTONIC, &starting);
+	for (i = 0; i < count; i++) {
+		XDR_SETPOS(xdrs, 0);
+		(void)(*proc)(xdrs, c->obj);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stopping);
+	t->encode = (double)timespec_elapsed(&starting, &stopping) / count;
+	XDR_DESTROY(xdrs);
+
+	xdrmem_create(xdrs, buf, len, XDR_DECODE);
+	clock_gettime(CLOCK_MONOTONIC, &starting);
+	for (i = 0; i < count; i++) {
+		XDR_SETPOS(xdrs, 0);
+		(void)(*proc)(xdrs, out);
+		xdr_free(proc, out);
+		memset(out, 0, c->objsz);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stopping);
+	t->decode = (double)timespec_elapsed(&starting, &stopping) / count;
+	XDR_DESTROY(xdrs);
+
+	clock_gettime(CLOCK_MONOTONIC, &starting);
+	for (i = 0; i < count; i++) {
+		if (size)
+			sum += (*size)(c->obj);
+		else
+			sum += hand_size(proc, c->obj);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stopping);
+	t->size = (double)timespec_elapsed(&starting, &stopping) / count;
+
+	free(out);
+	if (!sum)
+		fprintf(stderr, "%s: empty size\n", c->name);
+}
+
+static int
+run(struct codec *c, int count)
+{
+	struct timing hand, gen;
+	u_int len = xdr_sizeof(c->hand, c->obj);
+	u_int gen_len = (*c->gen_size)(c->obj);
+	char *buf = calloc(2, len + BYTES_PER_XDR_UNIT);
+	char *gen_buf = buf + len + BYTES_PER_XDR_UNIT;
+	u_int hand_pos = encode(c->hand, c->obj, buf, len);
+	u_int gen_pos = encode(c->gen, c->obj, gen_buf, len);
+	int rc = 0;
+
+	if (gen_len != len) {
+		fprintf(stderr, "%s: size hand %u gen %u\n",
+			c->name, len, gen_len);
+		rc = 1;
+	}
+	if (!hand_pos || hand_pos != gen_pos
+	 || memcmp(buf, gen_buf, hand_pos)) {
+		fprintf(stderr, "%s: encodings differ (hand %u gen %u)\n",
+			c->name, hand_pos, gen_pos);
+		rc = 1;
+	}
+
+	bench(c, c->hand, NULL, buf, len, count, &hand);
+	bench(c, c->gen, c->gen_size, buf, len, count, &gen);
+
+	fprintf(stdout, "rpcgenbench %s count=%d bytes=%u: encode hand %2.1lf gen %2.1lf, decode hand %2.1lf gen %2.1lf, sizeof hand %2.1lf gen %2.1lf (ns)\n",
+		c->name, count, len, hand.encode, gen.encode,
+		hand.decode, gen.decode, hand.size, gen.size);
+
+	free(buf);
+	return (rc);
+}
+
+static void usage(void)
+{
+	printf("Usage: rpcgenbench [--count=<n>] [--entries=<n>]\n");
+}
+
+static struct option long_options[] =
+{
+	{"count", required_argument, NULL, 'c'},
+	{"entries", required_argument, NULL, 'e'},
+	{NULL, 0, NULL, 0}
+};
+
+int main(int argc, char *argv[])
+{
+	rpcb map = {
+		.r_prog = 100003,
+		.r_vers = 3,
+		.r_netid = "tcp",
+		.r_addr = "0.0.0.0.8.1",
+		.r_owner = "superuser",
+	};
+	rpcb_stat stat;
+	rpcblist_ptr list = NULL;
+	rpcblist_ptr rl;
+	int count = 1000000;
+	int entries = 16;
+	int opt;
+	int rc = 0;
+	int i;
+
+	while ((opt = getopt_long(argc, argv, "c:e:",
+				  long_options, NULL)) != -1) {
+		switch (opt)
+		{
+		case 'c':
+			count = atoi(optarg);
+			break;
+		case 'e':
+			entries = atoi(optarg);
+			break;
+		default:
+			usage();
+			exit(1);
+			break;
+		};
+	}
+	if (count <= 0 || entries < 0) {
+		usage();
+		exit(1);
+	}
+
+	memset(&stat, 0, sizeof(stat));
+	for (i = 0; i < RPCBSTAT_HIGHPROC; i++)
+		stat.info[i] = i * 1000;
+	stat.setinfo = 7;
+	stat.unsetinfo = 3;
+
+	for (i = 0; i < entries; i++) {
+		rl = calloc(1, sizeof(*rl));
+		rl->rpcb_map = map;
+		rl->rpcb_map.r_prog += i;
+		rl->rpcb_next = list;
+		list = rl;
+	}
+
+	{
+		struct codec codecs[] = {
+			{"rpcb", (xdrproc_t) xdr_rpcb,
+			 (xdrproc_t) gen_xdr_rpcb,
+			 (sizeproc_t) gen_xdr_sizeof_rpcb,
+			 &map, sizeof(map)},
+			{"rpcb_stat", (xdrproc_t) xdr_rpcb_stat,
+			 (xdrproc_t) gen_xdr_rpcb_stat,
+			 (sizeproc_t) gen_xdr_sizeof_rpcb_stat,
+			 &stat, sizeof(stat)},
+			{"rpcblist_ptr", (xdrproc_t) xdr_rpcblist_ptr,
+			 (xdrproc_t) gen_xdr_rpcblist_ptr,
+			 (sizeproc_t) gen_xdr_sizeof_rpcblist_ptr,
+			 &list, sizeof(list)},
+		};
+
+		for (i = 0; i < sizeof(codecs) / sizeof(codecs[0]); i++)
+			rc |= run(&codecs[i], codecs[i].obj == &list
+					     ? MAX(count / (entries + 1), 1)
+					     : count);
+	}
+	fflush(stdout);
+
+	while (list) {
+		rl = list->rpcb_next;
+		free(list);
+		list = rl;
+	}
+	return (rc);
+}
@@ -52,6 +52,7 @@ struct state {
 	struct timespec starting;
 	struct timespec stopping;
 	int count;
+	int batch;
 	int proc;
 	int id;
 	uint32_t failures;
@@ -152,7 +153,9 @@ static void *
 worker(void *arg)
 {
 	struct state *s = arg;
+	struct clnt_req **ccv = calloc(s->batch, sizeof(*ccv));
 	struct clnt_req *cc;
+	int n = 0;
 	int i;
 
 	pthread_cond_init(&s->s_cond, NULL);
@@ -174,6 +177,17 @@ worker(void *arg)
 		cc->cc_refreshes = 1;
 		cc->cc_process_cb = worker_cb;
 
+		if (s->batch > 1) {
+			ccv[n++] = cc;
+			if (n < s->batch && i + 1 < s->count)
+				continue;
+			if (clnt_req_submit_batch(ccv, n) != RPC_SUCCESS)
+				fprintf(stderr,
+					"clnt_req_submit_batch failed\n");
+			n = 0;
+			continue;
+		}
+
 		cc->cc_error.re_status = CLNT_CALL_BACK(cc);
 		if (cc->cc_error.re_status != RPC_SUCCESS) {
 			rpc_perror(&cc->cc_error, "CLNT_CALL_BACK failed");
@@ -183,6 +197,12 @@ worker(void *arg)
 		}
 	}
 
+	if (n > 0) {
+		/* setup failed; send those already set up */
+		(void)clnt_req_submit_batch(ccv, n);
+	}
+	free(ccv);
+
 	pthread_mutex_lock(&s->s_mutex);
 	pthread_cond_wait(&s->s_cond, &s->s_mutex);
 	pthread_mutex_unlock(&s->s_mutex);
@@ -217,12 +237,15 @@ free_request(struct svc_req *req, enum xprt_stat stat)
 
 static void usage(void)
 {
-	printf("Usage: rpcping <raw|rdma|tcp|udp> <host> [--rpcbind] [--count=<n>] [--threads=<n>] [--workers=<n>] [--port=<n>] [--program=<n>] [--version=<n>] [--procedure=<n>]\n");
+	printf("Usage: rpcping <raw|rdma|tcp|udp> <host> [--rpcbind] [--count=<n>] [--batch=<n>] [--window=<n>] [--adapt] [--threads=<n>] [--workers=<n>] [--port=<n>] [--program=<n>] [--version=<n>] [--procedure=<n>]\n");
 }
 
 static struct option long_options[] =
 {
 	{"count", required_argument, NULL, 'c'},
+	{"batch", required_argument, NULL, 'n'},
+	{"window", required_argument, NULL, 'i'},
+	{"adapt", no_argument, NULL, 'a'},
 	{"threads", required_argument, NULL, 't'},
 	{"workers", required_argument, NULL, 'w'},
 	{"port", required_argument, NULL, 'p'},
@@ -246,6 +269,10 @@ int main(int argc, char *argv[])
 	int i;
 	int opt;
 	int count = 500; /* minimal concurrent requests */
+	int batch = 1; /* calls per clnt_req_submit_batch() */
+	struct clnt_window window = {
+		.cw_mode = CLNT_WINDOW_BLOCK,
+	};
 	int nthreads = 1;
 	int nworkers = 5;
 	int port = 2049;
@@ -270,13 +297,22 @@ int main(int argc, char *argv[])
 	host = argv[2];
 
 	optind = 3;
-	while ((opt = getopt_long(argc, argv, "bc:m:p:t:v:w:x:",
+	while ((opt = getopt_long(argc, argv, "abc:i:m:n:p:t:v:w:x:",
 				  long_options, NULL)) != -1) {
 		switch (opt)
 		{
 		case 'c':
 			count = atoi(optarg);
 			break;
+		case 'n':
+			batch = atoi(optarg);
+			break;
+		case 'i':
+			window.cw_calls = atoi(optarg);
+			break;
+		case 'a':
+			window.cw_flags |= CLNT_WINDOW_FLAG_ADAPT;
+			break;
 		case 't':
 			nthreads = atoi(optarg);
 			break;
@@ -357,12 +393,18 @@ int main(int argc, char *argv[])
 				exit(4);
 			}
 		}
+		if (window.cw_calls
+		 && !CLNT_CONTROL(clnt, CLSET_WINDOW, &window)) {
+			fprintf(stderr, "CLSET_WINDOW failed\n");
+			exit(5);
+		}
 		s = &states[i];
 		clnt->cl_u1 = s;
 
 		s->handle = clnt;
 		s->id = i;
 		s->count = count;
+		s->batch = batch;
 		s->proc = proc;
 		pthread_create(&t, NULL, worker, s);
 	}
@@ -384,8 +426,8 @@ int main(int argc, char *argv[])
 	total *= 1000000000.0;
 	total /= elapsed_ns;
 
-	fprintf(stdout, "rpcping %s %s count=%d threads=%d workers=%d (port=%d program=%d version=%d procedure=%d): failures %u timeouts %u mean %2.4lf, total %2.4lf\n",
-		proto, host, count, nthreads, nworkers, port, prog, vers, proc,
+	fprintf(stdout, "rpcping %s %s count=%d batch=%d window=%u threads=%d workers=%d (port=%d program=%d version=%d procedure=%d): failures %u timeouts %u mean %2.4lf, total %2.4lf\n",
+		proto, host, count, batch, window.cw_calls, nthreads, nworkers, port, prog, vers, proc,
 		failures, timeouts, total / nthreads, total);
 	fflush(stdout);
 
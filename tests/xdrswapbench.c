@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2026 Red Hat, Inc. and/or its affiliates.
+ *
+ * This code is released into the "public domain" by its author(s).
+ * Anybody may use, alter, and distribute the code without restriction.
+ * The author(s) make no guarantees, and take no liability of any kind
+ * for use of this code.
+ */
+
+/**
+ * @file xdrswapbench.c
+ * @brief XDR integer vector microbenchmark
+ *
+ * @section DESCRIPTION
+ *
+ * Times the bulk conversion of XDR integers (xdr_swap32, xdr_swap64)
+ * against one ntohl() per element, and the vector codecs built on them
+ * (xdr_uint32_vector, xdr_uint64_vector) against one xdr_uint32_t() or
+ * xdr_uint64_t() per element, decoding and encoding on xdrmem streams.
+ *
+ * The results of each pair are also compared; any difference is
+ * reported, and fails the run.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <arpa/inet.h>
+#include <rpc/rpc.h>
+#include <rpc/xdr_inline.h>
+
+static uint64_t timespec_elapsed(const struct timespec *starting,
+				 const struct timespec *stopping)
+{
+	time_t elapsed = stopping->tv_sec - starting->tv_sec;
+	long nsec = stopping->tv_nsec - starting->tv_nsec;
+
+	return (elapsed * 1000000000L) + nsec;
+}
+
+/* keep the compiler from dropping the loops */
+static volatile uint64_t sink;
+
+static double
+bench_swap32(const uint32_t *src, uint32_t *dst, u_int n, int count,
+	     bool bulk)
+{
+	struct timespec starting, stopping;
+	int i;
+	u_int j;
+
+	clock_gettime(CLOCK_MONOTONIC, &starting);
+	for (i = 0; i < count; i++) {
+		if (bulk) {
+			xdr_swap32(dst, src, n);
+		} else {
+			for (j = 0; j < n; j++)
+				dst[j] = ntohl(src[j]);
+		}
+		sink += dst[i % n];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stopping);
+	return ((double)timespec_elapsed(&starting, &stopping) / count);
+}
+
+static double
+bench_swap64(const uint64_t *src, uint64_t *dst, u_int n, int count,
+	     bool bulk)
+{
+	struct timespec starting, stopping;
+	const uint32_t *s;
+	int i;
+	u_int j;
+
+	clock_gettime(CLOCK_MONOTONIC, &starting);
+	for (i = 0; i < count; i++) {
+		if (bulk) {
+			xdr_swap64(dst, src, n);
+		} else {
+			s = (const uint32_t *)src;
+			for (j = 0; j < n; j++, s += 2)
+				dst[j] = ((uint64_t) ntohl(s[0]) << 32)
+					| ntohl(s[1]);
+		}
+		sink += dst[i % n];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stopping);
+	return ((double)timespec_elapsed(&starting, &stopping) / count);
+}
+
+static bool
+code32(XDR *xdrs, uint32_t *vp, u_int n, bool bulk)
+{
+	u_int j;
+
+	if (bulk)
+		return (xdr_uint32_vector(xdrs, vp, n));
+	for (j = 0; j < n; j++) {
+		if (!xdr_uint32_t(xdrs, &vp[j]))
+			return (false);
+	}
+	return (true);
+}
+
+static bool
+code64(XDR *xdrs, uint64_t *vp, u_int n, bool bulk)
+{
+	u_int j;
+
+	if (bulk)
+		return (xdr_uint64_vector(xdrs, vp, n));
+	for (j = 0; j < n; j++) {
+		if (!xdr_uint64_t(xdrs, &vp[j]))
+			return (false);
+	}
+	return (true);
+}
+
+/* width 4 or 8 */
+static double
+bench_xdr(char *buf, void *vp, u_int n, u_int width, enum xdr_op op,
+	  int count, bool bulk)
+{
+	struct timespec starting, stopping;
+	XDR xdrs[1];
+	int i;
+
+	xdrmem_create(xdrs, buf, n * width, op);
+	clock_gettime(CLOCK_MONOTONIC, &starting);
+	for (i = 0; i < count; i++) {
+		XDR_SETPOS(xdrs, 0);
+		if (width == sizeof(uint32_t))
+			(void)code32(xdrs, vp, n, bulk);
+		else
+			(void)code64(xdrs, vp, n, bulk);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stopping);
+	XDR_DESTROY(xdrs);
+	return ((double)timespec_elapsed(&starting, &stopping) / count);
+}
+
+static int
+check(const char *name, const void *a, const void *b, size_t len)
+{
+	if (!memcmp(a, b, len))
+		return (0);
+	fprintf(stderr, "%s: results differ\n", name);
+	return (1);
+}
+
+static void usage(void)
+{
+	printf("Usage: xdrswapbench [--count=<n>] [--length=<n>]\n");
+}
+
+static struct option long_options[] =
+{
+	{"count", required_argument, NULL, 'c'},
+	{"length", required_argument, NULL, 'l'},
+	{NULL, 0, NULL, 0}
+};
+
+int main(int argc, char *argv[])
+{
+	uint32_t *src32, *dst32, *ref32;
+	uint64_t *src64, *dst64, *ref64;
+	char *buf, *ref;
+	double scalar, bulk;
+	int count = 100000;
+	int length = 1024;	/* elements */
+	int opt;
+	int rc = 0;
+	u_int n;
+	u_int j;
+
+	while ((opt = getopt_long(argc, argv, "c:l:",
+				  long_options, NULL)) != -1) {
+		switch (opt)
+		{
+		case 'c':
+			count = atoi(optarg);
+			break;
+		case 'l':
+			length = atoi(optarg);
+			break;
+		default:
+			usage();
+			exit(1);
+			break;
+		};
+	}
+	if (count <= 0 || length <= 0) {
+		usage();
+		exit(1);
+	}
+	n = length;
+
+	src32 = calloc(n, sizeof(uint32_t));
+	dst32 = calloc(n, sizeof(uint32_t));
+	ref32 = calloc(n, sizeof(uint32_t));
+	src64 = calloc(n, sizeof(uint64_t));
+	dst64 = calloc(n, sizeof(uint64_t));
+	ref64 = calloc(n, sizeof(uint64_t));
+	buf = calloc(n, sizeof(uint64_t));
+	ref = calloc(n, sizeof(uint64_t));
+	for (j = 0; j < n; j++) {
+		src32[j] = j * 0x01020304U + 0x0a0b0c0dU;
+		src64[j] = j * 0x0102030405060708ULL + 0x0a0b0c0d0e0f1011ULL;
+	}
+
+	/* in memory */
+	scalar = bench_swap32(src32, ref32, n, count, false);
+	bulk = bench_swap32(src32, dst32, n, count, true);
+	rc |= check("xdr_swap32", ref32, dst32, n * sizeof(uint32_t));
+	fprintf(stdout, "xdrswapbench swap32 length=%u count=%d: ntohl %2.1lf xdr_swap32 %2.1lf (ns)\n",
+		n, count, scalar, bulk);
+
+	scalar = bench_swap64(src64, ref64, n, count, false);
+	bulk = bench_swap64(src64, dst64, n, count, true);
+	rc |= check("xdr_swap64", ref64, dst64, n * sizeof(uint64_t));
+	fprintf(stdout, "xdrswapbench swap64 length=%u count=%d: ntohl %2.1lf xdr_swap64 %2.1lf (ns)\n",
+		n, count, scalar, bulk);
+
+	/* through xdrmem streams */
+	scalar = bench_xdr(ref, src32, n, sizeof(uint32_t), XDR_ENCODE,
+			   count, false);
+	bulk = bench_xdr(buf, src32, n, sizeof(uint32_t), XDR_ENCODE,
+			 count, true);
+	rc |= check("xdr_uint32_vector encode", ref, buf,
+		    n * sizeof(uint32_t));
+	fprintf(stdout, "xdrswapbench encode32 length=%u count=%d: xdr_uint32_t %2.1lf xdr_uint32_vector %2.1lf (ns)\n",
+		n, count, scalar, bulk);
+
+	scalar = bench_xdr(buf, ref32, n, sizeof(uint32_t), XDR_DECODE,
+			   count, false);
+	bulk = bench_xdr(buf, dst32, n, sizeof(uint32_t), XDR_DECODE,
+			 count, true);
+	rc |= check("xdr_uint32_vector decode", src32, dst32,
+		    n * sizeof(uint32_t));
+	rc |= check("xdr_uint32_t decode", src32, ref32,
+		    n * sizeof(uint32_t));
+	fprintf(stdout, "xdrswapbench decode32 length=%u count=%d: xdr_uint32_t %2.1lf xdr_uint32_vector %2.1lf (ns)\n",
+		n, count, scalar, bulk);
+
+	scalar = bench_xdr(ref, src64, n, sizeof(uint64_t), XDR_ENCODE,
+			   count, false);
+	bulk = bench_xdr(buf, src64, n, sizeof(uint64_t), XDR_ENCODE,
+			 count, true);
+	rc |= check("xdr_uint64_vector encode", ref, buf,
+		    n * sizeof(uint64_t));
+	fprintf(stdout, "xdrswapbench encode64 length=%u count=%d: xdr_uint64_t %2.1lf xdr_uint64_vector %2.1lf (ns)\n",
+		n, count, scalar, bulk);
+
+	scalar = bench_xdr(buf, ref64, n, sizeof(uint64_t), XDR_DECODE,
+			   count, false);
+	bulk = bench_xdr(buf, dst64, n, sizeof(uint64_t), XDR_DECODE,
+			 count, true);
+	rc |= check("xdr_uint64_vector decode", src64, dst64,
+		    n * sizeof(uint64_t));
+	rc |= check("xdr_uint64_t decode", src64, ref64,
+		    n * sizeof(uint64_t));
+	fprintf(stdout, "xdrswapbench decode64 length=%u count=%d: xdr_uint64_t %2.1lf xdr_uint64_vector %2.1lf (ns)\n",
+		n, count, scalar, bulk);
+	fflush(stdout);
+
+	free(src32);
+	free(dst32);
+	free(ref32);
+	free(src64);
+	free(dst64);
+	free(ref64);
+	free(buf);
+	free(ref);
+	return (rc);
+}